@@ -0,0 +1,184 @@
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "atlas.h"
+#include "gen.h"
+#include "timing.h"
+
+typedef struct {
+    int row, col;
+    char path[1024];
+    OcrImage img;
+} Entry;
+
+static int cmp_entry(const void *a, const void *b)
+{
+    const Entry *ea = (const Entry *)a, *eb = (const Entry *)b;
+    if (ea->row != eb->row) return (ea->row > eb->row) - (ea->row < eb->row);
+    return (ea->col > eb->col) - (ea->col < eb->col);
+}
+
+/* Somme des vecteurs d'entree du reseau, indexee par (ligne, colonne) : les deux chemins
+ * doivent donner exactement la meme. */
+static double add_tile(const OcrModel *m, const OcrImage *img, int row, int col, float *vec)
+{
+    if (ocr_tile_vector(m, img, vec) != 0) return 0.0;
+    double s = 0.0;
+    for (int i = 0; i < m->tile_w * m->tile_h; ++i) s += vec[i] * (double)(i + 1);
+    return s * (double)(row * 1000 + col + 1);
+}
+
+/* Ancien chemin : un PNG par case, puis readdir + sscanf + qsort + decodage de chaque case. */
+static double run_png(const OcrTileSet *tiles, const char *dir, const OcrModel *m, float *vec,
+                      double *w_ms, double *r_ms)
+{
+    double t0 = timing_now_ms();
+    for (size_t i = 0; i < tiles->count; ++i) {
+        char p[600];
+        snprintf(p, sizeof(p), "%s/x%d_y%d.png", dir, tiles->tiles[i].col, tiles->tiles[i].row);
+        ocr_image_save_png(p, &tiles->tiles[i].img);
+    }
+    *w_ms = timing_now_ms() - t0;
+
+    t0 = timing_now_ms();
+    DIR *d = opendir(dir);
+    Entry *list = malloc(tiles->count * sizeof(Entry));
+    size_t n = 0;
+    struct dirent *e;
+    while (d && list && (e = readdir(d)) && n < tiles->count) {
+        int r, c;
+        if (sscanf(e->d_name, "x%d_y%d.png", &c, &r) != 2) continue;
+        list[n].row = r;
+        list[n].col = c;
+        snprintf(list[n].path, sizeof(list[n].path), "%s/%s", dir, e->d_name);
+        n++;
+    }
+    if (d) closedir(d);
+    int ok = list != NULL;
+    if (list) {
+        qsort(list, n, sizeof(Entry), cmp_entry);
+        for (size_t i = 0; i < n; ++i)
+            if (ocr_image_load(list[i].path, 1, &list[i].img) != 0) ok = 0;
+    }
+    *r_ms = timing_now_ms() - t0;
+
+    double sum = 0.0;
+    for (size_t i = 0; list && i < n; ++i) {
+        if (ok) sum += add_tile(m, &list[i].img, list[i].row, list[i].col, vec);
+        ocr_image_free(&list[i].img);
+        unlink(list[i].path);
+    }
+    free(list);
+    return ok ? sum : -1.0;
+}
+
+static double run_atlas(const OcrTileSet *tiles, const char *dir, const OcrModel *m, float *vec,
+                        double *w_ms, double *r_ms)
+{
+    char p[600];
+    snprintf(p, sizeof(p), "%s/%s", dir, ATLAS_FILE);
+    double t0 = timing_now_ms();
+    if (atlas_write(p, tiles) != 0) return -1.0;
+    *w_ms = timing_now_ms() - t0;
+
+    /* lecture : projection, index, et un passage sur les pixels pour payer les defauts de page */
+    t0 = timing_now_ms();
+    double sum = -1.0;
+    TileAtlas a;
+    OcrTileSet views;
+    if (atlas_map(p, &a) == 0) {
+        if (atlas_views(&a, &views) == 0) {
+            volatile unsigned touch = 0;
+            for (size_t i = 0; i < views.count; ++i)
+                for (int k = 0; k < a.tile_w * a.tile_h; k += 64) touch += views.tiles[i].img.pixels[k];
+            *r_ms = timing_now_ms() - t0;
+            sum = 0.0;
+            for (size_t i = 0; i < views.count; ++i)
+                sum += add_tile(m, &views.tiles[i].img, views.tiles[i].row, views.tiles[i].col, vec);
+            atlas_views_free(&views);
+        }
+        atlas_unmap(&a);
+    }
+    unlink(p);
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    const char *sizes = argc > 1 ? argv[1] : "17,50,100";
+    const char *root = argc > 2 ? argv[2] : "/tmp";
+    const int reps = 3;
+
+    GenOptions go;
+    gen_default_options(&go);
+    GenGlyphs glyphs;
+    if (gen_load_glyphs(go.glyphs, &glyphs) != 0) return 2;
+    OcrModel model;
+    if (ocr_model_load("../nn/weights.txt", &model) != 0) {
+        gen_free_glyphs(&glyphs);
+        return 2;
+    }
+    float *vec = malloc(sizeof(float) * (size_t)model.tile_w * (size_t)model.tile_h);
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s/bench_atlas_%ld", root, (long)getpid());
+    if (!vec || mkdir(dir, 0755) != 0) {
+        perror(dir);
+        return 2;
+    }
+
+    printf("Ecriture et relecture des cases (sans reseau), meilleur de %d ; cache disque chaud.\n", reps);
+    printf("taille   cases   png ecr/lec (ms)     atlas ecr/lec (ms)   lecture x   fichier\n");
+    int status = 0;
+    for (const char *p = sizes; *p;) {
+        char *end;
+        long size = strtol(p, &end, 10);
+        if (end == p) break;
+        p = *end ? end + 1 : end;
+        if (size < 2) continue;
+
+        go.rows = go.cols = (int)size;
+        go.cell = 2800 / (int)size;
+        if (go.cell > 34) go.cell = 34;
+        if (go.cell < 20) go.cell = 20;
+        GenPuzzle puz;
+        OcrImage bw;
+        OcrBinarizeOptions bo;
+        OcrTileSet tiles;
+        ocr_binarize_default_options(&bo);
+        if (gen_puzzle(&go, &glyphs, &puz) != 0) continue;
+        if (ocr_binarize(&puz.image, &bw, &bo, NULL) != 0 || ocr_split_grid(&bw, &tiles) != 0) {
+            gen_free(&puz);
+            continue;
+        }
+
+        double pw = TIMING_NONE, pr = TIMING_NONE, aw = TIMING_NONE, ar = TIMING_NONE, s_png = 0.0, s_atlas = 0.0;
+        for (int r = 0; r < reps; ++r) {
+            double w, rd;
+            s_png = run_png(&tiles, dir, &model, vec, &w, &rd);
+            if (w < pw) pw = w;
+            if (rd < pr) pr = rd;
+            s_atlas = run_atlas(&tiles, dir, &model, vec, &w, &rd);
+            if (w < aw) aw = w;
+            if (rd < ar) ar = rd;
+        }
+        size_t bytes = (size_t)ATLAS_HEADER + tiles.count * (ATLAS_ENTRY + OCR_TILE_SIZE * OCR_TILE_SIZE);
+        printf("%4ldx%-4ld %6zu   %8.2f / %-8.2f   %8.2f / %-8.2f   %7.1fx   %zu Ko%s\n", size, size,
+               tiles.count, pw, pr, aw, ar, ar > 0.0 ? pr / ar : 0.0, bytes / 1024,
+               s_png == s_atlas && s_png >= 0.0 ? "" : "   DIFFERENT");
+        if (s_png != s_atlas || s_png < 0.0) status = 1;
+
+        ocr_tiles_free(&tiles);
+        ocr_image_free(&bw);
+        gen_free(&puz);
+    }
+    rmdir(dir);
+    free(vec);
+    ocr_model_free(&model);
+    gen_free_glyphs(&glyphs);
+    return status;
+}
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccl.h"
+#include "gen.h"
+#include "timing.h"
+
+/* Remplissage par pile tel qu'il etait dans grid.c, words.c et find_words.c :
+ * tableau visite W*H octets + pile W*H entiers. */
+static int flood_label(const unsigned char *pix, int W, int H, int ink_max, int connectivity, CclSet *out)
+{
+    static const int V[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+    memset(out, 0, sizeof(*out));
+    unsigned char *vis = calloc((size_t)W * (size_t)H, 1);
+    int *stack = malloc(sizeof(int) * (size_t)W * (size_t)H);
+    if (!vis || !stack) {
+        free(vis);
+        free(stack);
+        return -1;
+    }
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            int id = y * W + x;
+            if (vis[id] || pix[id] > ink_max) continue;
+            int x0 = x, x1 = x, y0 = y, y1 = y, sp = 0;
+            size_t n = 0;
+            double sx = 0.0, sy = 0.0;
+            stack[sp++] = id;
+            vis[id] = 1;
+            while (sp) {
+                int cur = stack[--sp];
+                int cy = cur / W, cx = cur % W;
+                if (cx < x0) x0 = cx;
+                if (cx > x1) x1 = cx;
+                if (cy < y0) y0 = cy;
+                if (cy > y1) y1 = cy;
+                n++;
+                sx += cx;
+                sy += cy;
+                for (int k = 0; k < connectivity; k++) {
+                    int nx = cx + V[k][0], ny = cy + V[k][1];
+                    if (nx < 0 || ny < 0 || nx >= W || ny >= H) continue;
+                    int nid = ny * W + nx;
+                    if (!vis[nid] && pix[nid] <= ink_max) {
+                        vis[nid] = 1;
+                        stack[sp++] = nid;
+                    }
+                }
+            }
+            if (out->count == out->cap) {
+                size_t cap = out->cap ? out->cap * 2 : 256;
+                CclComponent *tmp = realloc(out->items, cap * sizeof(CclComponent));
+                if (!tmp) break;
+                out->items = tmp;
+                out->cap = cap;
+            }
+            out->items[out->count++] = (CclComponent){ x0, y0, x1, y1, n, sx / n, sy / n };
+        }
+    }
+    free(vis);
+    free(stack);
+    return 0;
+}
+
+static int same_components(const CclSet *a, const CclSet *b)
+{
+    if (a->count != b->count) return 0;
+    for (size_t i = 0; i < a->count; ++i) {
+        const CclComponent *p = &a->items[i], *q = &b->items[i];
+        if (p->x0 != q->x0 || p->y0 != q->y0 || p->x1 != q->x1 || p->y1 != q->y1 || p->pixels != q->pixels)
+            return 0;
+        double dx = p->xc - q->xc, dy = p->yc - q->yc;
+        if (dx * dx + dy * dy > 1e-12) return 0;
+    }
+    return 1;
+}
+
+static int bench_plane(const char *name, const unsigned char *pix, int w, int h, int reps)
+{
+    int status = 0;
+    printf("%s : %dx%d\n", name, w, h);
+    for (int conn = 4; conn <= 8; conn += 4) {
+        CclSet ref = {0}, got = {0};
+        double t_flood = TIMING_NONE, t_ccl = TIMING_NONE;
+        for (int r = 0; r < reps; ++r) {
+            ccl_free(&ref);
+            double t0 = timing_now_ms();
+            flood_label(pix, w, h, 200, conn, &ref);
+            t_flood = timing_keep_best(t_flood, t0);
+            ccl_free(&got);
+            t0 = timing_now_ms();
+            ccl_label(pix, w, h, (size_t)w, 200, conn, &got);
+            t_ccl = timing_keep_best(t_ccl, t0);
+        }
+        int same = same_components(&ref, &got);
+        if (!same) status = 1;
+        printf("  %d-connexe  %8zu composantes  pile %9.2f ms  segments %9.2f ms  x%.2f  %s\n", conn,
+               got.count, t_flood, t_ccl, t_flood / t_ccl, same ? "identique" : "DIFFERENT");
+        /* image deja codee en segments (rle.h) : seul l'etiquetage est mesure */
+        RleImage rle;
+        double t_rle = TIMING_NONE;
+        if (rle_encode(pix, w, h, (size_t)w, 200, &rle) == 0) {
+            for (int r = 0; r < reps; ++r) {
+                ccl_free(&got);
+                double t0 = timing_now_ms();
+                ccl_label_runs(&rle, conn, &got);
+                t_rle = timing_keep_best(t_rle, t0);
+            }
+            rle_free(&rle);
+        }
+        same = same_components(&ref, &got);
+        if (!same) status = 1;
+        printf("  %d-connexe  %8zu composantes  pile %9.2f ms  rle      %9.2f ms  x%.2f  %s\n", conn,
+               got.count, t_flood, t_rle, t_flood / t_rle, same ? "identique" : "DIFFERENT");
+        ccl_free(&ref);
+        ccl_free(&got);
+    }
+    return status;
+}
+
+/* bench_ccl [passes] [image...] : grilles synthetiques binarisees, bruit, puis images donnees. */
+int main(int argc, char **argv)
+{
+    int reps = argc > 1 ? atoi(argv[1]) : 3;
+    if (reps < 1) reps = 1;
+    int status = 0;
+
+    GenGlyphs glyphs;
+    if (gen_load_glyphs("../nn/dataset/train", &glyphs) == 0) {
+        static const int sizes[] = { 17, 64, 200 };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            GenOptions o;
+            gen_default_options(&o);
+            o.rows = o.cols = sizes[i];
+            o.cell = sizes[i] > 64 ? 20 : 34;
+            GenPuzzle p;
+            OcrImage bw;
+            OcrBinarizeOptions bo;
+            ocr_binarize_default_options(&bo);
+            if (gen_puzzle(&o, &glyphs, &p) != 0) continue;
+            if (ocr_binarize(&p.image, &bw, &bo, NULL) == 0) {
+                char name[64];
+                snprintf(name, sizeof(name), "grille %dx%d", sizes[i], sizes[i]);
+                status |= bench_plane(name, bw.pixels, bw.width, bw.height, reps);
+                ocr_image_free(&bw);
+            }
+            gen_free(&p);
+        }
+        gen_free_glyphs(&glyphs);
+    }
+
+    /* bruit : beaucoup de petites composantes et de fusions */
+    const int nw = 2048, nh = 2048;
+    unsigned char *noise = malloc((size_t)nw * nh);
+    if (noise) {
+        unsigned int s = 12345u;
+        for (size_t i = 0; i < (size_t)nw * nh; ++i) {
+            s = s * 1664525u + 1013904223u;
+            noise[i] = (s >> 24) < 110 ? 0 : 255;
+        }
+        status |= bench_plane("bruit 43%", noise, nw, nh, reps);
+        free(noise);
+    }
+
+    for (int i = 2; i < argc; ++i) {
+        OcrImage img;
+        if (ocr_image_load(argv[i], 1, &img) != 0) {
+            fprintf(stderr, "Echec : %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        status |= bench_plane(argv[i], img.pixels, img.width, img.height, reps);
+        ocr_image_free(&img);
+    }
+    return status;
+}
@@ -0,0 +1,214 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dense.h"
+#include "timing.h"
+
+static unsigned int rng_state = 12345u;
+
+static float rnd(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / 8388608.0f - 1.0f;
+}
+
+/* Dimensions du reseau (entree 32x32, couche cachee, sorties, cases par lot, pixels d'encre),
+ * puis des tailles qui ne tombent juste pour aucune largeur de vecteur. */
+typedef struct {
+    const char *name;
+    int in, hid, out, lot, nidx;
+} Forme;
+
+static const Forme formes[] = {
+    { "reseau", 1024, 96, 26, 32, 200 },
+    { "bords", 1001, 90, 27, 7, 137 },
+};
+
+typedef struct {
+    Forme f;
+    float *W1;   /* hid x in, relu aussi comme W1t (in x hid) */
+    float *W2;   /* out x hid */
+    float *H;    /* lot x hid */
+    float *b, *x, *alpha, *init;
+    unsigned short *idx;
+    int8_t *Q1t, *Q2; /* memes formes que W1t et W2, en int8 */
+    uint8_t *Hq;      /* lot x hid, 0..127 */
+    int32_t *acc;     /* sortie entiere, convertie en float apres l'appel */
+} Donnees;
+
+static float *tableau(size_t n, float echelle)
+{
+    float *p = malloc(n * sizeof(float));
+    for (size_t i = 0; p && i < n; ++i) p[i] = rnd() * echelle;
+    return p;
+}
+
+static int donnees_init(const Forme *f, Donnees *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->f = *f;
+    d->W1 = tableau((size_t)f->hid * f->in, 0.1f);
+    d->W2 = tableau((size_t)f->out * f->hid, 0.5f);
+    d->H = tableau((size_t)f->lot * f->hid, 8.0f);
+    d->b = tableau((size_t)f->hid, 1.0f);
+    d->x = tableau((size_t)f->in, 1.0f);
+    d->alpha = tableau((size_t)f->hid, 0.01f);
+    d->init = tableau((size_t)f->hid, 4.0f);
+    d->idx = malloc((size_t)f->nidx * sizeof(unsigned short));
+    d->Q1t = malloc((size_t)f->hid * f->in);
+    d->Q2 = malloc((size_t)f->out * f->hid);
+    d->Hq = malloc((size_t)f->lot * f->hid);
+    d->acc = malloc((size_t)f->lot * f->out * sizeof(int32_t) + (size_t)f->hid * sizeof(int32_t));
+    if (!d->W1 || !d->W2 || !d->H || !d->b || !d->x || !d->alpha || !d->init || !d->idx || !d->Q1t ||
+        !d->Q2 || !d->Hq || !d->acc)
+        return -1;
+    for (int k = 0; k < f->nidx; ++k) d->idx[k] = (unsigned short)((size_t)k * f->in / f->nidx);
+    /* int8 pleine echelle, y compris -128 */
+    for (size_t i = 0; i < (size_t)f->hid * f->in; ++i) d->Q1t[i] = (int8_t)(rnd() * 128.0f);
+    for (size_t i = 0; i < (size_t)f->out * f->hid; ++i) d->Q2[i] = (int8_t)(rnd() * 128.0f);
+    for (size_t i = 0; i < (size_t)f->lot * f->hid; ++i) d->Hq[i] = (uint8_t)((rnd() + 1.0f) * 63.9f);
+    return 0;
+}
+
+static void donnees_free(Donnees *d)
+{
+    free(d->W1); free(d->W2); free(d->H); free(d->b);
+    free(d->x); free(d->alpha); free(d->init); free(d->idx);
+    free(d->Q1t); free(d->Q2); free(d->Hq); free(d->acc);
+}
+
+static size_t taille_sortie(const Forme *f, int op)
+{
+    switch (op) {
+    case DENSE_OP_GEMM_NT:
+    case DENSE_OP_GEMM_U8I8: return (size_t)f->lot * f->out;
+    case DENSE_OP_BIAS_SIGMOID: return (size_t)f->lot * f->hid;
+    case DENSE_OP_GER: return (size_t)f->hid * f->in;
+    default: return (size_t)f->hid;
+    }
+}
+
+/* Sortie de depart des noyaux qui travaillent en place. */
+static void preparer(const Donnees *d, int op, float *out)
+{
+    if (op == DENSE_OP_BIAS_SIGMOID) memcpy(out, d->H, taille_sortie(&d->f, op) * sizeof(float));
+    if (op == DENSE_OP_GER) memcpy(out, d->W1, taille_sortie(&d->f, op) * sizeof(float));
+}
+
+static void lancer(const DenseOps *k, const Donnees *d, int op, float *out)
+{
+    const Forme *f = &d->f;
+    switch (op) {
+    case DENSE_OP_GEMV:
+        k->gemv(d->W1, (size_t)f->in, f->hid, f->in, d->x, out);
+        break;
+    case DENSE_OP_GEMM_NT:
+        k->gemm_nt(d->H, (size_t)f->hid, f->lot, d->W2, (size_t)f->hid, f->out, f->hid, out, (size_t)f->out);
+        break;
+    case DENSE_OP_BIAS_SIGMOID:
+        for (int i = 0; i < f->lot; ++i) k->bias_sigmoid(out + (size_t)i * f->hid, d->b, f->hid);
+        break;
+    case DENSE_OP_GER:
+        k->ger(out, (size_t)f->in, f->hid, f->in, d->alpha, d->x);
+        break;
+    case DENSE_OP_SUB_ROWS:
+        k->sub_rows(d->W1, (size_t)f->hid, d->idx, f->nidx, d->init, out, f->hid);
+        break;
+    case DENSE_OP_SUM_ROWS_I8:
+        k->sum_rows_i8(d->Q1t, (size_t)f->hid, d->idx, f->nidx, d->acc, f->hid);
+        for (int j = 0; j < f->hid; ++j) out[j] = (float)d->acc[j];
+        break;
+    case DENSE_OP_GEMM_U8I8:
+        k->gemm_u8i8(d->Hq, (size_t)f->hid, f->lot, d->Q2, (size_t)f->hid, f->out, f->hid, d->acc, (size_t)f->out);
+        for (size_t i = 0; i < (size_t)f->lot * f->out; ++i) out[i] = (float)d->acc[i];
+        break;
+    }
+}
+
+/* bench_dense [passes] : chaque jeu de noyaux face a la reference scalaire ;
+ * ecart : max |v - v scalaire| / max(1, |v scalaire|), nul attendu pour les noyaux int8.
+ * '*' : jeu pris par AUTO pour ce noyau ; signale quand un autre jeu va plus de 10 % plus vite. */
+int main(int argc, char **argv)
+{
+    int reps = argc > 1 ? atoi(argv[1]) : 5;
+    if (reps < 1) reps = 1;
+    const double tolerance = 1e-5;
+    const DenseKernel kernels[] = { DENSE_KERNEL_SCALAR, DENSE_KERNEL_SSE2, DENSE_KERNEL_AVX2, DENSE_KERNEL_AVX512 };
+    const size_t nk = sizeof(kernels) / sizeof(kernels[0]);
+
+    printf("Noyaux denses, actif : %s, meilleur de %d.\nAUTO :", dense_kernel_name(dense_active_kernel()), reps);
+    for (int op = 0; op < DENSE_OP_COUNT; ++op)
+        printf(" %s=%s", dense_op_name((DenseOp)op), dense_kernel_name(dense_op_kernel((DenseOp)op)));
+    printf("\n");
+    printf("forme    noyau      jeu      us/appel   gain   ecart\n");
+    int status = 0;
+    for (size_t fi = 0; fi < sizeof(formes) / sizeof(formes[0]); ++fi) {
+        Donnees d;
+        if (donnees_init(&formes[fi], &d) != 0) {
+            fprintf(stderr, "pas assez de mémoire\n");
+            return 2;
+        }
+        for (int op = 0; op < DENSE_OP_COUNT; ++op) {
+            const size_t n = taille_sortie(&d.f, op);
+            float *ref = malloc(n * sizeof(float)), *got = malloc(n * sizeof(float));
+            if (!ref || !got) {
+                fprintf(stderr, "pas assez de mémoire\n");
+                return 2;
+            }
+            /* environ 2e7 elements traites par mesure */
+            const int lignes = op == DENSE_OP_SUB_ROWS || op == DENSE_OP_SUM_ROWS_I8;
+            const int produits = op == DENSE_OP_GEMM_NT || op == DENSE_OP_GEMM_U8I8;
+            int iters = (int)(2e7 / (double)(lignes ? (size_t)d.f.nidx * d.f.hid
+                                             : produits ? n * (size_t)d.f.hid : n * 16));
+            if (op == DENSE_OP_GEMV) iters = (int)(2e7 / ((double)d.f.hid * d.f.in));
+            if (iters < 1) iters = 1;
+            preparer(&d, op, ref);
+            lancer(dense_ops(DENSE_KERNEL_SCALAR), &d, op, ref);
+            const DenseKernel choisi = dense_op_kernel((DenseOp)op);
+            double base = 0.0, t_choisi = 0.0, t_min = TIMING_NONE;
+            DenseKernel k_min = choisi;
+            for (size_t ki = 0; ki < nk; ++ki) {
+                const DenseOps *k = dense_ops(kernels[ki]);
+                if (!k) {
+                    printf("%-8s %-10s %-7s non supporte\n", d.f.name, dense_op_name((DenseOp)op),
+                           dense_kernel_name(kernels[ki]));
+                    continue;
+                }
+                preparer(&d, op, got);
+                lancer(k, &d, op, got);
+                double ecart = 0.0;
+                for (size_t i = 0; i < n; ++i)
+                    ecart = fmax(ecart, fabs((double)got[i] - ref[i]) / fmax(1.0, fabs((double)ref[i])));
+                double best = TIMING_NONE;
+                for (int r = 0; r < reps; ++r) {
+                    preparer(&d, op, got);
+                    double t0 = timing_now_ms();
+                    for (int it = 0; it < iters; ++it) lancer(k, &d, op, got);
+                    double dt = (timing_now_ms() - t0) / iters;
+                    if (dt < best) best = dt;
+                }
+                if (kernels[ki] == DENSE_KERNEL_SCALAR) base = best;
+                if (kernels[ki] == choisi) t_choisi = best;
+                if (best < t_min) {
+                    t_min = best;
+                    k_min = kernels[ki];
+                }
+                const int faux = ecart > tolerance || (op >= DENSE_OP_SUM_ROWS_I8 && ecart != 0.0);
+                printf("%-8s %-10s %-6s%c %9.3f  x%5.2f   %.1e%s\n", d.f.name, dense_op_name((DenseOp)op),
+                       dense_kernel_name(kernels[ki]), kernels[ki] == choisi ? '*' : ' ', best * 1e3,
+                       base > 0.0 ? base / best : 1.0, ecart, faux ? "   HORS TOLERANCE" : "");
+                if (faux) status = 1;
+            }
+            if (t_choisi > 1.1 * t_min)
+                printf("%-8s %-10s AUTO prend %s, %s va x%.2f plus vite\n", d.f.name, dense_op_name((DenseOp)op),
+                       dense_kernel_name(choisi), dense_kernel_name(k_min), t_choisi / t_min);
+            free(ref);
+            free(got);
+        }
+        donnees_free(&d);
+    }
+    return status;
+}
@@ -0,0 +1,159 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dense.h"
+#include "gen.h"
+#include "timing.h"
+#include "weights.h"
+
+/* Cases d'une grille generee, deja mises au format du reseau : vecteurs float de reference
+ * et tuiles sur 1 bit par pixel, avec la lettre attendue. */
+typedef struct {
+    size_t n;
+    float *vec;
+    uint64_t *bits;
+    char *truth;
+} Cases;
+
+static int collect(const OcrModel *m, const GenGlyphs *glyphs, int size, Cases *c)
+{
+    memset(c, 0, sizeof(*c));
+    GenOptions go;
+    gen_default_options(&go);
+    go.rows = go.cols = size;
+    go.cell = 2800 / size;
+    if (go.cell > 34) go.cell = 34;
+    if (go.cell < 20) go.cell = 20;
+    go.seed = (unsigned)size;
+    GenPuzzle puz;
+    OcrImage bw;
+    OcrBinarizeOptions bo;
+    OcrTileSet tiles;
+    ocr_binarize_default_options(&bo);
+    if (gen_puzzle(&go, glyphs, &puz) != 0) return -1;
+    if (ocr_binarize(&puz.image, &bw, &bo, NULL) != 0 || ocr_split_grid(&bw, &tiles) != 0) {
+        gen_free(&puz);
+        return -1;
+    }
+    const size_t len = (size_t)m->input_dim, words = OCR_BITS_WORDS(len);
+    c->vec = malloc(tiles.count * len * sizeof(float));
+    c->bits = malloc(tiles.count * words * sizeof(uint64_t));
+    c->truth = malloc(tiles.count);
+    for (size_t i = 0; c->vec && c->bits && c->truth && i < tiles.count; ++i) {
+        const OcrTile *t = &tiles.tiles[i];
+        if (t->row >= puz.rows || t->col >= puz.cols) continue;
+        if (ocr_tile_vector(m, &t->img, c->vec + c->n * len) != 0 ||
+            ocr_tile_bits(m, &t->img, c->bits + c->n * words) != 0)
+            continue;
+        c->truth[c->n++] = puz.grid[t->row * puz.cols + t->col];
+    }
+    ocr_tiles_free(&tiles);
+    ocr_image_free(&bw);
+    gen_free(&puz);
+    return c->vec && c->bits && c->truth ? 0 : -1;
+}
+
+static void cases_free(Cases *c)
+{
+    free(c->vec);
+    free(c->bits);
+    free(c->truth);
+}
+
+enum { MODE_FLOAT, MODE_BITS, MODE_BATCH, MODE_INT8, MODE_COUNT };
+static const char *const mode_names[MODE_COUNT] = { "float", "bits", "lots", "int8" };
+
+/* q8 : modele quantifie (mode int8), meme lots que "lots". */
+static void run(const OcrModel *m, const OcrModel *q8, const Cases *c, int mode, char *out, float *scores)
+{
+    const size_t len = (size_t)m->input_dim, words = OCR_BITS_WORDS(len);
+    if (mode == MODE_BATCH || mode == MODE_INT8) {
+        ocr_predict_bits_batch(mode == MODE_INT8 ? q8 : m, c->bits, c->n, out, scores);
+        return;
+    }
+    for (size_t i = 0; i < c->n; ++i) {
+        float *s = scores + i * (size_t)m->output_dim;
+        if (mode == MODE_FLOAT) out[i] = ocr_predict_scores(m, c->vec + i * len, s);
+        else out[i] = ocr_predict_bits(m, c->bits + i * words, s);
+    }
+}
+
+/* bench_infer [tailles] [poids] [poids int8] : reseau seul (cases deja normalisees),
+ * meilleur de 5. Sans modele int8 lisible, la ligne int8 est omise. */
+int main(int argc, char **argv)
+{
+    const char *sizes = argc > 1 ? argv[1] : "17,50,100";
+    const char *weights = argc > 2 ? argv[2] : "../nn/weights.txt";
+    const char *weights_q8 = argc > 3 ? argv[3] : "../nn/weights_q8.bin";
+    const int reps = 5;
+    /* ecart toleré sur les sorties du reseau (sigmoides) face a la reference float ; le
+     * modele int8 arrondit ses poids, seul un ecart grossier y est une erreur */
+    const double tolerance = 1e-4, tolerance_q8 = 5e-2;
+
+    GenOptions go;
+    gen_default_options(&go);
+    GenGlyphs glyphs;
+    if (gen_load_glyphs(go.glyphs, &glyphs) != 0) return 2;
+    OcrModel model;
+    if (ocr_model_load(weights, &model) != 0) {
+        gen_free_glyphs(&glyphs);
+        return 2;
+    }
+    OcrModel q8;
+    const int q8_charge = weights_is_binary(weights_q8) && ocr_model_load(weights_q8, &q8) == 0;
+    const int has_q8 = q8_charge && q8.Q1t && q8.input_dim == model.input_dim &&
+                       q8.hidden_dim == model.hidden_dim && q8.output_dim == model.output_dim;
+
+    printf("Reseau %dx%dx%d, noyaux %s, meilleur de %d ; ecart : max |score - score float|.\n",
+           model.input_dim, model.hidden_dim, model.output_dim, dense_kernel_name(dense_active_kernel()), reps);
+    printf("grille   cases   mode      total (ms)   us/case   justes   = float   ecart\n");
+    int status = 0;
+    for (const char *p = sizes; *p;) {
+        char *end;
+        long size = strtol(p, &end, 10);
+        if (end == p) break;
+        p = *end ? end + 1 : end;
+        Cases c = {0};
+        if (size < 2 || collect(&model, &glyphs, (int)size, &c) != 0 || c.n == 0) {
+            cases_free(&c);
+            continue;
+        }
+        const size_t ns = c.n * (size_t)model.output_dim;
+        char *ref = malloc(c.n), *got = malloc(c.n);
+        float *ref_s = malloc(ns * sizeof(float)), *got_s = malloc(ns * sizeof(float));
+        if (!ref || !got || !ref_s || !got_s) return 2;
+        run(&model, &q8, &c, MODE_FLOAT, ref, ref_s);
+        for (int mode = 0; mode < MODE_COUNT; ++mode) {
+            if (mode == MODE_INT8 && !has_q8) continue;
+            const double tol = mode == MODE_INT8 ? tolerance_q8 : tolerance;
+            double best = TIMING_NONE;
+            for (int r = 0; r < reps; ++r) {
+                double t0 = timing_now_ms();
+                run(&model, &q8, &c, mode, got, got_s);
+                best = timing_keep_best(best, t0);
+            }
+            size_t ok = 0, same = 0;
+            double diff = 0.0;
+            for (size_t i = 0; i < c.n; ++i) {
+                ok += got[i] == c.truth[i];
+                same += got[i] == ref[i];
+            }
+            for (size_t i = 0; i < ns; ++i) diff = fmax(diff, fabs((double)got_s[i] - ref_s[i]));
+            printf("%4ldx%-4ld %6zu   %-8s %10.2f   %7.2f   %5.1f%%   %5.1f%%   %.1e%s\n", size, size, c.n,
+                   mode_names[mode], best, best * 1e3 / (double)c.n, 100.0 * ok / c.n,
+                   100.0 * same / c.n, diff, diff > tol ? "   HORS TOLERANCE" : "");
+            if (diff > tol) status = 1;
+        }
+        free(ref);
+        free(got);
+        free(ref_s);
+        free(got_s);
+        cases_free(&c);
+    }
+    ocr_model_free(&model);
+    if (q8_charge) ocr_model_free(&q8);
+    gen_free_glyphs(&glyphs);
+    return status;
+}
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gen.h"
+#include "timing.h"
+
+typedef struct {
+    const char *sizes;
+    int reps;
+    int cell;
+    const char *weights;
+    const char *csv;
+    const char *keep;
+    GenOptions gen;
+} BenchOptions;
+
+typedef struct {
+    const char *stage;
+    double ms;
+    double units;     /* pixels, cases, lettres ou mots traites par passe */
+    const char *unit;
+    double accuracy;  /* fraction, < 0 si non mesuree */
+} StageResult;
+
+/* Fraction de pixels dont la binarisation correspond au rendu sans bruit seuille a 128. */
+static double bw_agreement(const OcrImage *bw, const OcrImage *clean)
+{
+    if (bw->width != clean->width || bw->height != clean->height) return -1.0;
+    size_t same = 0, n = (size_t)bw->width * (size_t)bw->height;
+    for (int y = 0; y < bw->height; ++y) {
+        const unsigned char *b = bw->pixels + (size_t)y * bw->stride;
+        const unsigned char *c = clean->pixels + (size_t)y * clean->stride;
+        for (int x = 0; x < bw->width; ++x) {
+            const unsigned char *p = c + (size_t)x * 4;
+            int ink = (p[0] * 299 + p[1] * 587 + p[2] * 114) < 128000;
+            same += (b[x] == 0) == ink;
+        }
+    }
+    return (double)same / (double)n;
+}
+
+static int word_at(const GenWord *w, OcrCoord s, OcrCoord e)
+{
+    return ((int)s.x == w->x0 && (int)s.y == w->y0 && (int)e.x == w->x1 && (int)e.y == w->y1) ||
+           ((int)s.x == w->x1 && (int)s.y == w->y1 && (int)e.x == w->x0 && (int)e.y == w->y0);
+}
+
+static int run_size(const BenchOptions *bo, const GenGlyphs *glyphs, const OcrModel *model, int size,
+                    StageResult res[5], GenPuzzle *puzzle_out)
+{
+    GenOptions go = bo->gen;
+    go.rows = go.cols = size;
+    if (bo->cell > 0) {
+        go.cell = bo->cell;
+    } else {
+        go.cell = 2800 / size;
+        if (go.cell > 34) go.cell = 34;
+        if (go.cell < 20) go.cell = 20;
+    }
+
+    GenPuzzle p, clean;
+    if (gen_puzzle(&go, glyphs, &p) != 0) return -1;
+    GenOptions co = go;
+    co.noise = 0.0;
+    if (gen_puzzle(&co, glyphs, &clean) != 0) {
+        gen_free(&p);
+        return -1;
+    }
+
+    const int reps = bo->reps;
+    const size_t npx = (size_t)p.image.width * (size_t)p.image.height;
+    OcrBinarizeOptions bopts;
+    ocr_binarize_default_options(&bopts);
+    OcrImage bw = {0};
+    RleImage runs = {0};
+    OcrTileSet tiles = {0};
+    OcrWordSet words = {0};
+    char *grid = NULL;
+    int rows = 0, cols = 0;
+    for (int i = 0; i < 5; ++i) res[i].ms = TIMING_NONE;
+
+    /* les segments d'encre sont codes avec la binarisation et servent aux deux etapes
+     * suivantes ; encode_ms : leur part, mesuree a part */
+    double encode_ms = TIMING_NONE, words_dense_ms = TIMING_NONE;
+    for (int r = 0; r < reps; ++r) {
+        ocr_image_free(&bw);
+        rle_free(&runs);
+        double t0 = timing_now_ms();
+        if (ocr_binarize_runs(&p.image, &bw, &runs, &bopts, NULL) != 0) break;
+        res[0].ms = timing_keep_best(res[0].ms, t0);
+    }
+    for (int r = 0; bw.pixels && r < reps; ++r) {
+        RleImage tmp;
+        double t0 = timing_now_ms();
+        if (rle_encode(bw.pixels, bw.width, bw.height, bw.stride, 0, &tmp) != 0) break;
+        encode_ms = timing_keep_best(encode_ms, t0);
+        rle_free(&tmp);
+    }
+    res[0] = (StageResult){ "binarisation", res[0].ms, (double)npx, "px", bw_agreement(&bw, &clean.image) };
+
+    /* une arene pour toutes les passes de decoupage et de mots, videe avant chaque image
+     * comme dans grid_splitter --jobs */
+    Arena scratch;
+    arena_init(&scratch, 0);
+    for (int r = 0; r < reps; ++r) {
+        ocr_tiles_free(&tiles);
+        double t0 = timing_now_ms();
+        int rc = ocr_split_grid_scratch(&bw, &runs, NULL, &tiles, 0, &scratch);
+        res[1].ms = timing_keep_best(res[1].ms, t0);
+        if (rc != 0) break;
+    }
+
+    for (int r = 0; r < reps; ++r) {
+        ocr_words_free(&words);
+        double t0 = timing_now_ms();
+        int rc = ocr_extract_words_scratch(&bw, &runs, &words, &scratch);
+        res[2].ms = timing_keep_best(res[2].ms, t0);
+        if (rc != 0) break;
+    }
+    for (int r = 0; r < reps; ++r) {
+        OcrWordSet again;
+        double t0 = timing_now_ms();
+        int rc = ocr_extract_words(&bw, &again);
+        words_dense_ms = timing_keep_best(words_dense_ms, t0);
+        ocr_words_free(&again);
+        if (rc != 0) break;
+    }
+    size_t nletters = 0;
+    for (size_t i = 0; i < words.count; ++i) nletters += (size_t)words.words[i].count;
+
+    char **recognized = calloc(words.count ? words.count : 1, sizeof(char *));
+    for (int r = 0; r < reps; ++r) {
+        free(grid);
+        for (size_t i = 0; recognized && i < words.count; ++i) {
+            free(recognized[i]);
+            recognized[i] = NULL;
+        }
+        double t0 = timing_now_ms();
+        grid = ocr_recognize_grid(model, &tiles, &rows, &cols);
+        for (size_t i = 0; recognized && i < words.count; ++i)
+            recognized[i] = ocr_recognize_word(model, &words.words[i]);
+        res[3].ms = timing_keep_best(res[3].ms, t0);
+    }
+
+    /* resolution seule sur la vraie grille, puis de bout en bout sur la grille reconnue */
+    OcrCoord s, e;
+    int found = 0, found_e2e = 0;
+    for (int r = 0; r < reps; ++r) {
+        double t0 = timing_now_ms();
+        found = 0;
+        for (int i = 0; i < p.nwords; ++i)
+            if (ocr_search_word(p.grid, (unsigned)size, (unsigned)size, p.words[i].word, &s, &e) == 0 &&
+                word_at(&p.words[i], s, e))
+                found++;
+        res[4].ms = timing_keep_best(res[4].ms, t0);
+    }
+    for (int i = 0; grid && i < p.nwords; ++i)
+        if (ocr_search_word(grid, (unsigned)rows, (unsigned)cols, p.words[i].word, &s, &e) == 0 &&
+            word_at(&p.words[i], s, e))
+            found_e2e++;
+
+    /* decoupage : cases a la bonne position ; mots : nombre de lettres exact par mot */
+    const double ncells = (double)size * (double)size;
+    size_t placed = 0;
+    for (size_t i = 0; i < tiles.count; ++i)
+        placed += tiles.tiles[i].row < size && tiles.tiles[i].col < size;
+    int dims_ok = rows == size && cols == size;
+    res[1] = (StageResult){ "decoupage", res[1].ms, (double)tiles.count, "cases",
+                            dims_ok ? (double)placed / ncells : 0.0 };
+
+    int words_ok = 0, words_exact = 0;
+    for (int i = 0; i < p.nwords && (size_t)i < words.count; ++i) {
+        words_ok += words.words[i].count == (int)strlen(p.words[i].word);
+        words_exact += recognized && recognized[i] && strcmp(recognized[i], p.words[i].word) == 0;
+    }
+    res[2] = (StageResult){ "mots", res[2].ms, (double)words.count, "mots",
+                            p.nwords ? (double)words_ok / p.nwords : -1.0 };
+
+    size_t cells_ok = 0;
+    for (size_t i = 0; dims_ok && grid && i < (size_t)size * (size_t)size; ++i)
+        cells_ok += grid[i] == p.grid[i];
+    /* lettres de la grille justes, puis mots de la liste lus sans faute */
+    res[3] = (StageResult){ "reconnaissance", res[3].ms, (double)tiles.count + (double)nletters, "lettres",
+                            (double)cells_ok / ncells };
+    res[4] = (StageResult){ "resolution", res[4].ms, (double)p.nwords, "mots",
+                            p.nwords ? (double)found / p.nwords : -1.0 };
+
+    printf("%3dx%-3d %5dx%-5d %3d mots  grille %s, mots lus %d/%d, trouves de bout en bout %d/%d\n",
+           size, size, p.image.width, p.image.height, p.nwords, dims_ok ? "ok" : "KO", words_exact,
+           p.nwords, found_e2e, p.nwords);
+    printf("        memoire de travail au plus haut : decoupage %zu Ko, mots %zu Ko ; "
+           "%zu blocs d'arene alloues pour %d passes\n",
+           tiles.scratch_peak / 1024, words.scratch_peak / 1024, scratch.blocs, 2 * reps);
+    printf("        segments : codage %.3f ms (dans la binarisation), %zu segments ; mots %.3f ms, "
+           "%.3f ms en recodant l'image\n",
+           encode_ms, runs.count, res[2].ms, words_dense_ms);
+
+    for (size_t i = 0; recognized && i < words.count; ++i) free(recognized[i]);
+    free(recognized);
+    free(grid);
+    ocr_words_free(&words);
+    ocr_tiles_free(&tiles);
+    arena_free(&scratch);
+    ocr_image_free(&bw);
+    rle_free(&runs);
+    gen_free(&clean);
+    *puzzle_out = p;
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [--sizes 8,16,32,64,100,150,200] [--reps N] [--cell PX] [--scale F]\n"
+            "       [--rotate DEG] [--noise SIGMA] [--seed S] [--weights poids.txt] [--glyphs dossier]\n"
+            "       [--csv resultats.csv] [--keep dossier]\n",
+            prog);
+}
+
+static int parse_args(int argc, char **argv, BenchOptions *o)
+{
+    memset(o, 0, sizeof(*o));
+    gen_default_options(&o->gen);
+    o->sizes = "8,16,32,64,100,150,200";
+    o->reps = 3;
+    o->weights = "../nn/weights.txt";
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        int more = i + 1 < argc;
+        if (strcmp(a, "--sizes") == 0 && more) o->sizes = argv[++i];
+        else if (strcmp(a, "--reps") == 0 && more) o->reps = atoi(argv[++i]);
+        else if (strcmp(a, "--cell") == 0 && more) o->cell = atoi(argv[++i]);
+        else if (strcmp(a, "--scale") == 0 && more) o->gen.scale = atof(argv[++i]);
+        else if (strcmp(a, "--rotate") == 0 && more) o->gen.rotate = atof(argv[++i]);
+        else if (strcmp(a, "--noise") == 0 && more) o->gen.noise = atof(argv[++i]);
+        else if (strcmp(a, "--seed") == 0 && more) o->gen.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(a, "--weights") == 0 && more) o->weights = argv[++i];
+        else if (strcmp(a, "--glyphs") == 0 && more) o->gen.glyphs = argv[++i];
+        else if (strcmp(a, "--csv") == 0 && more) o->csv = argv[++i];
+        else if (strcmp(a, "--keep") == 0 && more) o->keep = argv[++i];
+        else {
+            fprintf(stderr, "Argument inconnu: %s\n", a);
+            return -1;
+        }
+    }
+    if (o->reps < 1) o->reps = 1;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions bo;
+    if (parse_args(argc, argv, &bo) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    GenGlyphs glyphs;
+    if (gen_load_glyphs(bo.gen.glyphs, &glyphs) != 0) return 2;
+    OcrModel model;
+    if (ocr_model_load(bo.weights, &model) != 0) {
+        gen_free_glyphs(&glyphs);
+        return 2;
+    }
+    FILE *csv = bo.csv ? fopen(bo.csv, "w") : NULL;
+    if (bo.csv && !csv) perror(bo.csv);
+    if (csv) fprintf(csv, "taille,etape,ms,unites,debit_par_s,precision\n");
+
+    int status = 0;
+    const char *p = bo.sizes;
+    while (*p) {
+        char *end;
+        long size = strtol(p, &end, 10);
+        if (end == p) break;
+        p = *end ? end + 1 : end;
+        if (size < 2) continue;
+
+        StageResult res[5];
+        GenPuzzle puzzle;
+        if (run_size(&bo, &glyphs, &model, (int)size, res, &puzzle) != 0) {
+            fprintf(stderr, "Echec de la generation %ldx%ld\n", size, size);
+            status = 3;
+            continue;
+        }
+        for (int i = 0; i < 5; ++i) {
+            double rate = res[i].ms > 0.0 ? res[i].units / (res[i].ms * 1e-3) : 0.0;
+            printf("    %-15s %10.3f ms %12.0f %s/s", res[i].stage, res[i].ms, rate, res[i].unit);
+            if (res[i].accuracy >= 0.0) printf("   %6.2f %%", res[i].accuracy * 100.0);
+            putchar('\n');
+            if (csv)
+                fprintf(csv, "%ld,%s,%.3f,%.0f,%.0f,%.4f\n", size, res[i].stage, res[i].ms,
+                        res[i].units, rate, res[i].accuracy);
+        }
+        if (bo.keep) {
+            char prefix[1024];
+            snprintf(prefix, sizeof(prefix), "%s/grille_%ld", bo.keep, size);
+            gen_write(&puzzle, prefix);
+        }
+        gen_free(&puzzle);
+    }
+
+    if (csv) fclose(csv);
+    ocr_model_free(&model);
+    gen_free_glyphs(&glyphs);
+    return status;
+}
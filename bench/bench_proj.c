@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gen.h"
+#include "projection.h"
+#include "rle.h"
+#include "timing.h"
+
+/* Les deux parcours de l'ancien collecter_lignes : par lignes, puis colonne par colonne. */
+static void two_pass(const unsigned char *pix, int W, int H, int *rows, int *cols)
+{
+    for (int y = 0; y < H; y++) {
+        int c = 0;
+        for (int x = 0; x < W; x++)
+            if (pix[y * W + x] == 0) c++;
+        rows[y] = c;
+    }
+    for (int x = 0; x < W; x++) {
+        int c = 0;
+        for (int y = 0; y < H; y++)
+            if (pix[y * W + x] == 0) c++;
+        cols[x] = c;
+    }
+}
+
+static int bench_plane(const char *name, const unsigned char *pix, int w, int h, int reps)
+{
+    int *r0 = malloc(sizeof(int) * h), *c0 = malloc(sizeof(int) * w);
+    int *r1 = malloc(sizeof(int) * h), *c1 = malloc(sizeof(int) * w);
+    if (!r0 || !c0 || !r1 || !c1) {
+        free(r0); free(c0); free(r1); free(c1);
+        return 1;
+    }
+    double base = TIMING_NONE;
+    for (int r = 0; r < reps; ++r) {
+        double t0 = timing_now_ms();
+        two_pass(pix, w, h, r0, c0);
+        base = timing_keep_best(base, t0);
+    }
+    printf("%s : %dx%d\n  deux passes      %8.2f ms\n", name, w, h, base);
+    int status = 0;
+    static const int threads[] = { 1, 2, 4 };
+    for (size_t k = 0; k < sizeof(threads) / sizeof(threads[0]); ++k) {
+        double best = TIMING_NONE;
+        for (int r = 0; r < reps; ++r) {
+            double t0 = timing_now_ms();
+            proj_ink_counts(pix, w, h, (size_t)w, r1, c1, threads[k]);
+            best = timing_keep_best(best, t0);
+        }
+        int same = memcmp(r0, r1, sizeof(int) * h) == 0 && memcmp(c0, c1, sizeof(int) * w) == 0;
+        if (!same) status = 1;
+        printf("  un passage x%d   %8.2f ms  x%.2f  %s\n", threads[k], best, base / best,
+               same ? "identique" : "DIFFERENT");
+    }
+    /* segments : codage une fois apres la binarisation, puis profils sur les segments */
+    double t_enc = TIMING_NONE, t_prof = TIMING_NONE;
+    size_t runs = 0;
+    for (int r = 0; r < reps; ++r) {
+        RleImage rle;
+        double t0 = timing_now_ms();
+        if (rle_encode(pix, w, h, (size_t)w, 0, &rle) != 0) {
+            status = 1;
+            break;
+        }
+        t_enc = timing_keep_best(t_enc, t0);
+        t0 = timing_now_ms();
+        rle_profiles(&rle, r1, c1);
+        t_prof = timing_keep_best(t_prof, t0);
+        runs = rle.count;
+        rle_free(&rle);
+    }
+    int same = memcmp(r0, r1, sizeof(int) * h) == 0 && memcmp(c0, c1, sizeof(int) * w) == 0;
+    if (!same) status = 1;
+    printf("  segments         %8.2f ms  x%.2f  %s  (codage %.2f ms, %zu segments)\n", t_prof,
+           base / t_prof, same ? "identique" : "DIFFERENT", t_enc, runs);
+    free(r0); free(c0); free(r1); free(c1);
+    return status;
+}
+
+/* bench_proj [passes] [image...] */
+int main(int argc, char **argv)
+{
+    int reps = argc > 1 ? atoi(argv[1]) : 5;
+    if (reps < 1) reps = 1;
+    int status = 0;
+
+    GenGlyphs glyphs;
+    if (gen_load_glyphs("../nn/dataset/train", &glyphs) == 0) {
+        static const int sizes[] = { 17, 64, 200 };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            GenOptions o;
+            gen_default_options(&o);
+            o.rows = o.cols = sizes[i];
+            o.cell = sizes[i] > 64 ? 20 : 34;
+            GenPuzzle p;
+            OcrImage bw;
+            OcrBinarizeOptions bo;
+            ocr_binarize_default_options(&bo);
+            if (gen_puzzle(&o, &glyphs, &p) != 0) continue;
+            if (ocr_binarize(&p.image, &bw, &bo, NULL) == 0) {
+                char name[64];
+                snprintf(name, sizeof(name), "grille %dx%d", sizes[i], sizes[i]);
+                status |= bench_plane(name, bw.pixels, bw.width, bw.height, reps);
+                ocr_image_free(&bw);
+            }
+            gen_free(&p);
+        }
+        gen_free_glyphs(&glyphs);
+    }
+
+    /* largeur non multiple de 16 et plus de 255 lignes par bande */
+    const int nw = 3001, nh = 1999;
+    unsigned char *noise = malloc((size_t)nw * nh);
+    if (noise) {
+        unsigned int s = 12345u;
+        for (size_t i = 0; i < (size_t)nw * nh; ++i) {
+            s = s * 1664525u + 1013904223u;
+            noise[i] = (s >> 24) < 200 ? 0 : 255;
+        }
+        status |= bench_plane("bruit", noise, nw, nh, reps);
+        free(noise);
+    }
+
+    for (int i = 2; i < argc; ++i) {
+        OcrImage img;
+        if (ocr_image_load(argv[i], 1, &img) != 0) {
+            fprintf(stderr, "Echec : %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        status |= bench_plane(argv[i], img.pixels, img.width, img.height, reps);
+        ocr_image_free(&img);
+    }
+    return status;
+}
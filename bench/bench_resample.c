@@ -0,0 +1,211 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gen.h"
+#include "resample.h"
+#include "timing.h"
+
+/* Ancien normalize_letter / normalize_letter_bitmap / ocr_tile_vector : rognage par
+ * balayage des lignes et colonnes, round() en double pour chaque pixel de la tuile. */
+static void ancien(const unsigned char *src, int w, int h, int tw, int th, int margin, int flags,
+                   unsigned char *dst)
+{
+    memset(dst, 255, (size_t)tw * th);
+    int top = 0, bottom = h - 1, left = 0, right = w - 1;
+    if (flags & RESAMPLE_TRIM) {
+        const double border_ratio = 0.98;
+        while (top < h) {
+            int n = 0;
+            for (int x = 0; x < w; ++x) n += src[top * w + x] < 200;
+            if (n > (int)(border_ratio * w)) top++;
+            else break;
+        }
+        while (bottom >= top) {
+            int n = 0;
+            for (int x = 0; x < w; ++x) n += src[bottom * w + x] < 200;
+            if (n > (int)(border_ratio * w)) bottom--;
+            else break;
+        }
+        while (left < w) {
+            int n = 0;
+            for (int y = 0; y < h; ++y) n += src[y * w + left] < 200;
+            if (n > (int)(border_ratio * h)) left++;
+            else break;
+        }
+        while (right >= left) {
+            int n = 0;
+            for (int y = 0; y < h; ++y) n += src[y * w + right] < 200;
+            if (n > (int)(border_ratio * h)) right--;
+            else break;
+        }
+    }
+    int x0 = w, y0 = h, x1 = -1, y1 = -1, dark = 0;
+    for (int y = top; y <= bottom; ++y)
+        for (int x = left; x <= right; ++x)
+            if (src[y * w + x] < 200) {
+                if (x < x0) x0 = x;
+                if (x > x1) x1 = x;
+                if (y < y0) y0 = y;
+                if (y > y1) y1 = y;
+                dark++;
+            }
+    if (x1 < x0 || y1 < y0) {
+        x0 = 0; y0 = 0; x1 = w - 1; y1 = h - 1;
+    }
+    int bw = x1 - x0 + 1, bh = y1 - y0 + 1;
+    double avail_w = (double)(tw - margin * 2), avail_h = (double)(th - margin * 2);
+    if (avail_w < 1.0) avail_w = (double)tw;
+    if (avail_h < 1.0) avail_h = (double)th;
+    double scale = fmin(avail_w / (double)bw, avail_h / (double)bh);
+    if (scale <= 0.0) scale = 1.0;
+    int dw = (int)(bw * scale + 0.5), dh = (int)(bh * scale + 0.5);
+    if (dw < 1) dw = 1;
+    if (dh < 1) dh = 1;
+    if (dw > tw) dw = tw;
+    if (dh > th) dh = th;
+    int offx = (tw - dw) / 2, offy = (th - dh) / 2;
+    int invert = (flags & RESAMPLE_INVERT) && dark > (w * h) / 2;
+    for (int ty = 0; ty < dh; ++ty) {
+        double ry = (dh <= 1) ? 0.0 : (double)ty / (double)(dh - 1);
+        int sy = y0 + (int)round(ry * (double)(bh - 1));
+        if (sy < y0) sy = y0;
+        if (sy > y1) sy = y1;
+        for (int tx = 0; tx < dw; ++tx) {
+            double rx = (dw <= 1) ? 0.0 : (double)tx / (double)(dw - 1);
+            int sx = x0 + (int)round(rx * (double)(bw - 1));
+            if (sx < x0) sx = x0;
+            if (sx > x1) sx = x1;
+            unsigned char v = src[sy * w + sx];
+            int is_letter = invert ? (v > 200) : (v < 200);
+            dst[(offy + ty) * tw + offx + tx] = is_letter ? 0 : 255;
+        }
+    }
+}
+
+typedef struct {
+    unsigned char *pix;
+    int w, h;
+} Cell;
+
+/* Cases brutes (cadre compris) d'une grille generee, puis les memes en niveaux de gris
+ * autour du seuil 200 pour exercer les comparaisons. */
+static int collect_cells(int size, const GenGlyphs *glyphs, Cell **out, size_t *n)
+{
+    GenOptions go;
+    gen_default_options(&go);
+    go.rows = go.cols = size;
+    go.cell = 2800 / size;
+    if (go.cell > 60) go.cell = 60;
+    if (go.cell < 20) go.cell = 20;
+    go.seed = (unsigned)size;
+    GenPuzzle puz;
+    OcrImage bw;
+    OcrBinarizeOptions bo;
+    OcrTileSet tiles;
+    ocr_binarize_default_options(&bo);
+    if (gen_puzzle(&go, glyphs, &puz) != 0) return -1;
+    if (ocr_binarize(&puz.image, &bw, &bo, NULL) != 0 || ocr_split_grid(&bw, &tiles) != 0) {
+        gen_free(&puz);
+        return -1;
+    }
+    Cell *c = malloc(2 * tiles.count * sizeof(Cell));
+    size_t k = 0;
+    unsigned int seed = 12345u;
+    for (size_t i = 0; c && i < tiles.count; ++i) {
+        const OcrTile *t = &tiles.tiles[i];
+        int x0 = t->x0 < 0 ? 0 : t->x0, y0 = t->y0 < 0 ? 0 : t->y0;
+        int x1 = t->x1 >= bw.width ? bw.width - 1 : t->x1, y1 = t->y1 >= bw.height ? bw.height - 1 : t->y1;
+        int w = x1 - x0 + 1, h = y1 - y0 + 1;
+        if (w <= 0 || h <= 0) continue;
+        for (int g = 0; g < 2; ++g) {
+            unsigned char *p = malloc((size_t)w * h);
+            if (!p) break;
+            for (int y = 0; y < h; ++y)
+                for (int x = 0; x < w; ++x) {
+                    unsigned char v = bw.pixels[(size_t)(y0 + y) * bw.stride + x0 + x];
+                    seed = seed * 1103515245u + 12345u;
+                    if (g) v = v ? (unsigned char)(190 + (seed >> 16) % 66) : (unsigned char)((seed >> 16) % 205);
+                    p[y * w + x] = v;
+                }
+            c[k++] = (Cell){ p, w, h };
+        }
+    }
+    ocr_tiles_free(&tiles);
+    ocr_image_free(&bw);
+    gen_free(&puz);
+    *out = c;
+    *n = k;
+    return c ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *sizes = argc > 1 ? argv[1] : "10,20,50";
+    const int reps = 3;
+    static const struct {
+        const char *name;
+        int tile, margin, flags;
+    } modes[] = {
+        { "grille", OCR_TILE_SIZE, 2, RESAMPLE_TRIM | RESAMPLE_INVERT },
+        { "mots", OCR_TILE_SIZE, 2, 0 },
+        { "reseau", OCR_TILE_SIZE, 1, RESAMPLE_INVERT },
+    };
+
+    GenOptions go;
+    gen_default_options(&go);
+    GenGlyphs glyphs;
+    if (gen_load_glyphs(go.glyphs, &glyphs) != 0) return 2;
+    unsigned char *a = malloc(OCR_TILE_SIZE * OCR_TILE_SIZE), *b = malloc(OCR_TILE_SIZE * OCR_TILE_SIZE);
+    if (!a || !b) return 2;
+    Arena scratch;
+    arena_init(&scratch, 0);
+
+    printf("Normalisation des cases en %dx%d, meilleur de %d.\n", OCR_TILE_SIZE, OCR_TILE_SIZE, reps);
+    printf("grille   cases   mode       ancien (ms)   tables (ms)   gain\n");
+    int status = 0;
+    for (const char *p = sizes; *p;) {
+        char *end;
+        long size = strtol(p, &end, 10);
+        if (end == p) break;
+        p = *end ? end + 1 : end;
+        Cell *cells;
+        size_t n;
+        if (size < 2 || collect_cells((int)size, &glyphs, &cells, &n) != 0) continue;
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+            const int t = modes[m].tile;
+            size_t diff = 0;
+            for (size_t i = 0; i < n; ++i) {
+                ancien(cells[i].pix, cells[i].w, cells[i].h, t, t, modes[m].margin, modes[m].flags, a);
+                resample_letter(cells[i].pix, cells[i].w, cells[i].h, (size_t)cells[i].w, t, t,
+                                modes[m].margin, modes[m].flags, b, NULL);
+                diff += memcmp(a, b, (size_t)t * t) != 0;
+            }
+            double to = TIMING_NONE, tn = TIMING_NONE;
+            for (int r = 0; r < reps; ++r) {
+                double t0 = timing_now_ms();
+                for (size_t i = 0; i < n; ++i)
+                    ancien(cells[i].pix, cells[i].w, cells[i].h, t, t, modes[m].margin, modes[m].flags, a);
+                to = timing_keep_best(to, t0);
+                t0 = timing_now_ms();
+                for (size_t i = 0; i < n; ++i)
+                    resample_letter(cells[i].pix, cells[i].w, cells[i].h, (size_t)cells[i].w, t, t,
+                                    modes[m].margin, modes[m].flags, b, &scratch);
+                tn = timing_keep_best(tn, t0);
+            }
+            printf("%4ldx%-4ld %6zu   %-8s %10.2f    %10.2f   %5.1fx", size, size, n, modes[m].name, to, tn,
+                   tn > 0.0 ? to / tn : 0.0);
+            if (diff) printf("   %zu DIFFERENTES", diff);
+            printf("\n");
+            if (diff) status = 1;
+        }
+        for (size_t i = 0; i < n; ++i) free(cells[i].pix);
+        free(cells);
+    }
+    arena_free(&scratch);
+    free(a);
+    free(b);
+    gen_free_glyphs(&glyphs);
+    return status;
+}
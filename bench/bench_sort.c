@@ -0,0 +1,123 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sort.h"
+#include "timing.h"
+
+typedef struct {
+    int x0, y0, x1, y1;
+    double yc;
+} Box;
+
+static int key_yc(const void *a)
+{
+    const Box *b = (const Box *)a;
+    return b->y0 + b->y1;
+}
+
+static int cmp_x0(const void *a, const void *b)
+{
+    const Box *ba = (const Box *)a;
+    const Box *bb = (const Box *)b;
+    return (ba->x0 > bb->x0) - (ba->x0 < bb->x0);
+}
+
+/* Regroupement en lignes des decoupeurs : seuil sur l'ecart a la premiere boite de la ligne. */
+static int group_rows(Box *b, int nb, double th, int *start)
+{
+    int nl = 0;
+    for (int st = 0; st < nb;) {
+        int ed = st + 1;
+        while (ed < nb && fabs(b[ed].yc - b[st].yc) < th) ed++;
+        start[nl++] = st;
+        st = ed;
+    }
+    start[nl] = nb;
+    return nl;
+}
+
+static int old_sort(Box *b, int nb, double th, int *start)
+{
+    for (int i = 0; i < nb; i++)
+        for (int j = i + 1; j < nb; j++)
+            if (b[j].yc < b[i].yc) {
+                Box t = b[i]; b[i] = b[j]; b[j] = t;
+            }
+    int nl = group_rows(b, nb, th, start);
+    for (int r = 0; r < nl; r++) {
+        int s = start[r], c = start[r + 1] - s;
+        for (int a = 0; a < c; a++)
+            for (int k = a + 1; k < c; k++)
+                if (b[s + k].x0 < b[s + a].x0) {
+                    Box t = b[s + a]; b[s + a] = b[s + k]; b[s + k] = t;
+                }
+    }
+    return nl;
+}
+
+static int new_sort(Box *b, int nb, int max_key, double th, int *start)
+{
+    sort_by_key(b, (size_t)nb, sizeof(Box), key_yc, max_key);
+    int nl = group_rows(b, nb, th, start);
+    for (int r = 0; r < nl; r++)
+        sort_stable(b + start[r], (size_t)(start[r + 1] - start[r]), sizeof(Box), cmp_x0);
+    return nl;
+}
+
+/* n lettres sur une grille carree, ligne de base legerement bruitee, en ordre de balayage. */
+static int make_boxes(Box *b, int n, unsigned int seed)
+{
+    int side = (int)ceil(sqrt((double)n));
+    int k = 0;
+    for (int r = 0; r < side && k < n; ++r)
+        for (int c = 0; c < side && k < n; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            int h = 14 + (int)((seed >> 24) % 6);
+            int y0 = 6 + r * 34 + (int)((seed >> 16) % 5);
+            int x0 = 8 + c * 34 + (int)((seed >> 8) % 5);
+            b[k++] = (Box){ x0, y0, x0 + 10, y0 + h - 1, (y0 + y0 + h - 1) / 2.0 };
+        }
+    /* ordre de balayage : par y0 puis x0, comme a la sortie de l'etiquetage */
+    for (int i = 1; i < k; ++i) {
+        Box t = b[i];
+        int j = i;
+        while (j > 0 && (b[j - 1].y0 > t.y0 || (b[j - 1].y0 == t.y0 && b[j - 1].x0 > t.x0))) {
+            b[j] = b[j - 1];
+            --j;
+        }
+        b[j] = t;
+    }
+    return side * 34 + 40;
+}
+
+int main(int argc, char **argv)
+{
+    int max_n = argc > 1 ? atoi(argv[1]) : 40000;
+    static const int counts[] = { 100, 300, 1000, 3000, 10000, 40000, 100000 };
+    int status = 0;
+    printf("%8s %8s %12s %12s %9s\n", "boites", "lignes", "ancien ms", "nouveau ms", "gain");
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]) && counts[i] <= max_n; ++i) {
+        int n = counts[i];
+        Box *src = malloc(sizeof(Box) * n), *a = malloc(sizeof(Box) * n), *b = malloc(sizeof(Box) * n);
+        int *sa = malloc(sizeof(int) * (n + 1)), *sb = malloc(sizeof(int) * (n + 1));
+        if (!src || !a || !b || !sa || !sb) return 1;
+        int H = make_boxes(src, n, 42u);
+        memcpy(a, src, sizeof(Box) * n);
+        memcpy(b, src, sizeof(Box) * n);
+        double t0 = timing_now_ms();
+        int na = old_sort(a, n, 16 * 0.6, sa);
+        double t_old = timing_now_ms() - t0;
+        t0 = timing_now_ms();
+        int nbl = new_sort(b, n, 2 * H, 16 * 0.6, sb);
+        double t_new = timing_now_ms() - t0;
+        int same = na == nbl && memcmp(sa, sb, sizeof(int) * (na + 1)) == 0 &&
+                   memcmp(a, b, sizeof(Box) * n) == 0;
+        if (!same) status = 1;
+        printf("%8d %8d %12.3f %12.3f %8.1fx  %s\n", n, nbl, t_old, t_new, t_old / t_new,
+               same ? "identique" : "DIFFERENT");
+        free(src); free(a); free(b); free(sa); free(sb);
+    }
+    return status;
+}
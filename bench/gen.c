@@ -0,0 +1,451 @@
+#define _DEFAULT_SOURCE
+#include "gen.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *builtin_words[] = {
+    "IMAGINE", "RELAX", "COOL", "RESTING", "BREATHE", "EASY", "TENSION", "STRESS", "CALM",
+    "OCEAN", "RIVER", "FOREST", "MOUNTAIN", "VALLEY", "DESERT", "ISLAND", "CANYON", "MEADOW",
+    "PLANET", "COMET", "GALAXY", "ORBIT", "ROCKET", "NEBULA", "ECLIPSE", "METEOR", "SATURN",
+    "PIXEL", "BINARY", "KERNEL", "THREAD", "BUFFER", "VECTOR", "MATRIX", "SOLVER", "NEURON",
+    "APPLE", "CHERRY", "LEMON", "MANGO", "PEACH", "GRAPE", "BANANA", "TOMATO", "PEPPER",
+    "GUITAR", "PIANO", "VIOLIN", "TRUMPET", "DRUM", "FLUTE", "HARP", "CELLO", "BANJO",
+    "WINTER", "SPRING", "SUMMER", "AUTUMN", "STORM", "THUNDER", "RAINBOW", "BREEZE", "FROST",
+    "CASTLE", "BRIDGE", "TOWER", "GARDEN", "PALACE", "TEMPLE", "HARBOR", "VILLAGE", "MARKET",
+    "ZEBRA", "JAGUAR", "FALCON", "DOLPHIN", "OTTER", "KOALA", "WALRUS", "PYTHON", "LYNX",
+    "QUARTZ", "AMBER", "COPPER", "SILVER", "COBALT", "ONYX", "JADE", "TOPAZ", "GRANITE",
+};
+
+#define NB_BUILTIN ((int)(sizeof(builtin_words) / sizeof(builtin_words[0])))
+
+static const int dirs[8][2] = {
+    {1, 0}, {0, 1}, {1, 1}, {1, -1}, {-1, 0}, {0, -1}, {-1, -1}, {-1, 1}
+};
+
+typedef struct {
+    unsigned long long s;
+} Rng;
+
+static unsigned int rng_next(Rng *r)
+{
+    r->s ^= r->s << 13;
+    r->s ^= r->s >> 7;
+    r->s ^= r->s << 17;
+    return (unsigned int)(r->s >> 32);
+}
+
+static int rng_below(Rng *r, int n)
+{
+    return n > 0 ? (int)(rng_next(r) % (unsigned int)n) : 0;
+}
+
+static double rng_gauss(Rng *r)
+{
+    double u = (rng_next(r) + 1.0) / 4294967297.0;
+    double v = (rng_next(r) + 1.0) / 4294967297.0;
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+void gen_default_options(GenOptions *o)
+{
+    memset(o, 0, sizeof(*o));
+    o->rows = 17;
+    o->cols = 17;
+    o->cell = 34;
+    o->scale = 0.55;
+    o->seed = 1;
+    o->glyphs = "../nn/dataset/train";
+}
+
+/* ---- Lettres ---- */
+
+static int cmp_str(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Recadre la tuile sur l'encre (< 128). */
+static int crop_ink(OcrImage *img)
+{
+    int x0 = img->width, y0 = img->height, x1 = -1, y1 = -1;
+    for (int y = 0; y < img->height; ++y)
+        for (int x = 0; x < img->width; ++x)
+            if (img->pixels[(size_t)y * img->stride + (size_t)x] < 128) {
+                if (x < x0) x0 = x;
+                if (x > x1) x1 = x;
+                if (y < y0) y0 = y;
+                if (y > y1) y1 = y;
+            }
+    if (x1 < x0) return -1;
+    OcrImage c;
+    if (ocr_image_crop(img, x0, y0, x1 - x0 + 1, y1 - y0 + 1, &c) != 0) return -1;
+    ocr_image_free(img);
+    *img = c;
+    return 0;
+}
+
+int gen_load_glyphs(const char *dir, GenGlyphs *g)
+{
+    memset(g, 0, sizeof(*g));
+    char path[1024];
+    int total = 0;
+    for (int l = 0; l < 26; ++l) {
+        snprintf(path, sizeof(path), "%s/%c", dir, 'A' + l);
+        DIR *d = opendir(path);
+        if (!d) continue;
+        char *names[64];
+        int n = 0;
+        struct dirent *e;
+        while ((e = readdir(d)) && n < 64) {
+            /* seulement les tuiles propres "A_0.png", pas les cases x*_y* decoupees d'une grille */
+            const char *dot = strrchr(e->d_name, '.');
+            if (!dot || strcmp(dot, ".png") != 0 || e->d_name[0] != 'A' + l || e->d_name[1] != '_')
+                continue;
+            names[n] = strdup(e->d_name);
+            if (names[n]) n++;
+        }
+        closedir(d);
+        qsort(names, (size_t)n, sizeof(char *), cmp_str);
+        for (int i = 0; i < n; ++i) {
+            snprintf(path, sizeof(path), "%s/%c/%s", dir, 'A' + l, names[i]);
+            OcrImage *img = &g->letters[l][g->count[l]];
+            if (g->count[l] < 8 && ocr_image_load(path, 1, img) == 0) {
+                if (crop_ink(img) == 0) g->count[l]++;
+                else ocr_image_free(img);
+            }
+            free(names[i]);
+        }
+        total += g->count[l] > 0;
+    }
+    if (total < 26) {
+        fprintf(stderr, "Lettres manquantes dans %s (%d/26)\n", dir, total);
+        gen_free_glyphs(g);
+        return -1;
+    }
+    return 0;
+}
+
+void gen_free_glyphs(GenGlyphs *g)
+{
+    for (int l = 0; l < 26; ++l)
+        for (int i = 0; i < g->count[l]; ++i)
+            ocr_image_free(&g->letters[l][i]);
+    memset(g, 0, sizeof(*g));
+}
+
+/* ---- Mots ---- */
+
+static char **load_word_list(const char *path, int *count)
+{
+    *count = 0;
+    if (!path) {
+        char **list = malloc(NB_BUILTIN * sizeof(char *));
+        if (!list) return NULL;
+        for (int i = 0; i < NB_BUILTIN; ++i) list[i] = strdup(builtin_words[i]);
+        *count = NB_BUILTIN;
+        return list;
+    }
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    char **list = NULL;
+    int cap = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        int k = 0;
+        for (int i = 0; line[i] && k < 31; ++i)
+            if (isalpha((unsigned char)line[i])) line[k++] = (char)toupper((unsigned char)line[i]);
+        line[k] = '\0';
+        if (k < 2) continue;
+        if (*count == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **tmp = realloc(list, (size_t)cap * sizeof(char *));
+            if (!tmp) break;
+            list = tmp;
+        }
+        list[(*count)++] = strdup(line);
+    }
+    fclose(f);
+    return list;
+}
+
+static int try_place(GenPuzzle *p, const char *w, Rng *r)
+{
+    int len = (int)strlen(w);
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        const int *d = dirs[rng_below(r, 8)];
+        int x0 = rng_below(r, p->cols), y0 = rng_below(r, p->rows);
+        int x1 = x0 + d[0] * (len - 1), y1 = y0 + d[1] * (len - 1);
+        if (x1 < 0 || x1 >= p->cols || y1 < 0 || y1 >= p->rows) continue;
+        int ok = 1;
+        for (int k = 0; k < len && ok; ++k) {
+            char c = p->grid[(size_t)(y0 + d[1] * k) * (size_t)p->cols + (size_t)(x0 + d[0] * k)];
+            ok = c == 0 || c == w[k];
+        }
+        if (!ok) continue;
+        for (int k = 0; k < len; ++k)
+            p->grid[(size_t)(y0 + d[1] * k) * (size_t)p->cols + (size_t)(x0 + d[0] * k)] = w[k];
+        GenWord *gw = &p->words[p->nwords++];
+        snprintf(gw->word, sizeof(gw->word), "%s", w);
+        gw->x0 = x0;
+        gw->y0 = y0;
+        gw->x1 = x1;
+        gw->y1 = y1;
+        return 0;
+    }
+    return -1;
+}
+
+/* ---- Rendu ---- */
+
+static double glyph_scale(const OcrImage *glyph, double gh, double max_w, int *dw, int *dh)
+{
+    double s = gh / glyph->height;
+    if (glyph->width * s > max_w) s = max_w / glyph->width;
+    *dw = (int)(glyph->width * s + 0.5);
+    *dh = (int)(glyph->height * s + 0.5);
+    if (*dw < 1) *dw = 1;
+    if (*dh < 1) *dh = 1;
+    return s;
+}
+
+/* Lettre de hauteur gh (largeur <= max_w) centree sur (cx, cy), composee en minimum. */
+static void draw_glyph(OcrImage *canvas, const OcrImage *glyph, double cx, double cy, double gh,
+                       double max_w)
+{
+    int dw, dh;
+    double s = glyph_scale(glyph, gh, max_w, &dw, &dh);
+    int ox = (int)(cx - dw / 2.0 + 0.5), oy = (int)(cy - dh / 2.0 + 0.5);
+    for (int y = 0; y < dh; ++y) {
+        int py = oy + y;
+        if (py < 0 || py >= canvas->height) continue;
+        double sy = (y + 0.5) / s - 0.5;
+        int y0 = (int)floor(sy);
+        double fy = sy - y0;
+        for (int x = 0; x < dw; ++x) {
+            int px = ox + x;
+            if (px < 0 || px >= canvas->width) continue;
+            double sx = (x + 0.5) / s - 0.5;
+            int x0 = (int)floor(sx);
+            double fx = sx - x0;
+            double v = 0.0;
+            for (int k = 0; k < 4; ++k) {
+                int xx = x0 + (k & 1), yy = y0 + (k >> 1);
+                if (xx < 0) xx = 0;
+                if (yy < 0) yy = 0;
+                if (xx >= glyph->width) xx = glyph->width - 1;
+                if (yy >= glyph->height) yy = glyph->height - 1;
+                double wgt = ((k & 1) ? fx : 1.0 - fx) * ((k >> 1) ? fy : 1.0 - fy);
+                v += wgt * glyph->pixels[(size_t)yy * glyph->stride + (size_t)xx];
+            }
+            unsigned char *q = canvas->pixels + (size_t)py * canvas->stride + (size_t)px * 4;
+            unsigned char g = (unsigned char)(v + 0.5);
+            for (int c = 0; c < 3; ++c)
+                if (g < q[c]) q[c] = g;
+        }
+    }
+}
+
+static void set_px(OcrImage *img, int x, int y, unsigned char r, unsigned char g, unsigned char b)
+{
+    if (x < 0 || y < 0 || x >= img->width || y >= img->height) return;
+    unsigned char *q = img->pixels + (size_t)y * img->stride + (size_t)x * 4;
+    q[0] = r;
+    q[1] = g;
+    q[2] = b;
+}
+
+static int rotate_canvas(OcrImage *img, double deg)
+{
+    double a = deg * M_PI / 180.0, ca = cos(a), sa = sin(a);
+    int w = img->width, h = img->height;
+    int nw = (int)ceil(fabs(w * ca) + fabs(h * sa)), nh = (int)ceil(fabs(w * sa) + fabs(h * ca));
+    OcrImage out;
+    if (ocr_image_init(&out, nw, nh, 4) != 0) return -1;
+    memset(out.pixels, 255, out.stride * (size_t)nh);
+    double cx = w / 2.0, cy = h / 2.0, ncx = nw / 2.0, ncy = nh / 2.0;
+    for (int y = 0; y < nh; ++y) {
+        for (int x = 0; x < nw; ++x) {
+            double dx = x + 0.5 - ncx, dy = y + 0.5 - ncy;
+            /* rotation inverse ; y vers le bas */
+            double sx = ca * dx - sa * dy + cx - 0.5;
+            double sy = sa * dx + ca * dy + cy - 0.5;
+            /* plus proche voisin : un trait de 1 px garde son contraste, comme sur un scan
+             * d'une feuille de travers (le bilineaire l'eclaircit jusqu'a l'effacer) */
+            int xx = (int)lround(sx), yy = (int)lround(sy);
+            if (xx >= 0 && yy >= 0 && xx < w && yy < h)
+                memcpy(out.pixels + (size_t)y * out.stride + (size_t)x * 4,
+                       img->pixels + (size_t)yy * img->stride + (size_t)xx * 4, 3);
+        }
+    }
+    ocr_image_free(img);
+    *img = out;
+    return 0;
+}
+
+static void add_noise(OcrImage *img, double sigma, Rng *r)
+{
+    for (int y = 0; y < img->height; ++y) {
+        unsigned char *row = img->pixels + (size_t)y * img->stride;
+        for (int x = 0; x < img->width; ++x) {
+            double n = rng_gauss(r) * sigma;
+            for (int c = 0; c < 3; ++c) {
+                double v = row[x * 4 + c] + n;
+                row[x * 4 + c] = (unsigned char)(v < 0.0 ? 0.0 : v > 255.0 ? 255.0 : v + 0.5);
+            }
+        }
+    }
+}
+
+static const OcrImage *pick_glyph(const GenGlyphs *g, char c, Rng *r)
+{
+    int l = c - 'A';
+    if (l < 0 || l >= 26 || g->count[l] == 0) return NULL;
+    return &g->letters[l][rng_below(r, g->count[l])];
+}
+
+int gen_puzzle(const GenOptions *o, const GenGlyphs *g, GenPuzzle *p)
+{
+    memset(p, 0, sizeof(*p));
+    if (o->rows < 2 || o->cols < 2 || o->cell < 8) return -1;
+    Rng r = { 0x9e3779b97f4a7c15ull ^ ((unsigned long long)o->seed * 0x100000001b3ull) };
+    if (r.s == 0) r.s = 1;
+
+    p->rows = o->rows;
+    p->cols = o->cols;
+    p->grid = calloc((size_t)o->rows * (size_t)o->cols, 1);
+    int nlist = 0;
+    char **list = load_word_list(o->words_file, &nlist);
+    int maxw = o->nwords > 0 ? o->nwords : o->rows;
+    if (maxw > o->rows) maxw = o->rows; /* une ligne de la liste par ligne de la grille */
+    p->words = calloc((size_t)(maxw > 0 ? maxw : 1), sizeof(GenWord));
+    if (!p->grid || !list || !p->words) {
+        for (int i = 0; i < nlist; ++i) free(list[i]);
+        free(list);
+        gen_free(p);
+        return -1;
+    }
+
+    for (int i = nlist - 1; i > 0; --i) {
+        int j = rng_below(&r, i + 1);
+        char *t = list[i];
+        list[i] = list[j];
+        list[j] = t;
+    }
+    int longest = o->rows > o->cols ? o->rows : o->cols;
+    for (int i = 0; i < nlist && p->nwords < maxw; ++i) {
+        if (!list[i] || (int)strlen(list[i]) > longest) continue;
+        try_place(p, list[i], &r);
+    }
+    for (int i = 0; i < nlist; ++i) free(list[i]);
+    free(list);
+    for (size_t i = 0; i < (size_t)o->rows * (size_t)o->cols; ++i)
+        if (!p->grid[i]) p->grid[i] = (char)('A' + rng_below(&r, 26));
+
+    const int cell = o->cell;
+    const double gh = cell * o->scale;
+    const double pitch = gh * 0.85; /* chasse maximale d'une lettre de la liste */
+    int maxlen = 0;
+    for (int i = 0; i < p->nwords; ++i) {
+        int len = (int)strlen(p->words[i].word);
+        if (len > maxlen) maxlen = len;
+    }
+    const int margin = cell;
+    const int list_w = (int)(maxlen * pitch) + 3 * cell;
+    const int gx = margin + list_w, gy = margin;
+    const int W = gx + o->cols * cell + margin + 1, H = gy + o->rows * cell + margin + 1;
+    if (ocr_image_init(&p->image, W, H, 4) != 0) {
+        gen_free(p);
+        return -1;
+    }
+    memset(p->image.pixels, 255, p->image.stride * (size_t)H);
+
+    for (int i = 0; i <= o->rows; ++i)
+        for (int x = gx; x <= gx + o->cols * cell; ++x)
+            set_px(&p->image, x, gy + i * cell, 127, 127, 255);
+    for (int j = 0; j <= o->cols; ++j)
+        for (int y = gy; y <= gy + o->rows * cell; ++y)
+            set_px(&p->image, gx + j * cell, y, 127, 127, 255);
+
+    for (int i = 0; i < o->rows; ++i)
+        for (int j = 0; j < o->cols; ++j) {
+            const OcrImage *gl = pick_glyph(g, p->grid[(size_t)i * (size_t)o->cols + (size_t)j], &r);
+            if (gl) draw_glyph(&p->image, gl, gx + j * cell + cell / 2.0, gy + i * cell + cell / 2.0,
+                               gh, cell * 0.8);
+        }
+    for (int i = 0; i < p->nwords; ++i) {
+        double cy = gy + i * cell + cell / 2.0, x = margin;
+        for (int k = 0; p->words[i].word[k]; ++k) {
+            const OcrImage *gl = pick_glyph(g, p->words[i].word[k], &r);
+            if (!gl) continue;
+            int dw, dh;
+            glyph_scale(gl, gh, pitch, &dw, &dh);
+            draw_glyph(&p->image, gl, x + dw / 2.0, cy, gh, pitch);
+            x += dw + gh * 0.15;
+        }
+    }
+
+    if (o->rotate != 0.0 && rotate_canvas(&p->image, o->rotate) != 0) {
+        gen_free(p);
+        return -1;
+    }
+    if (o->noise > 0.0) add_noise(&p->image, o->noise, &r);
+    return 0;
+}
+
+void gen_free(GenPuzzle *p)
+{
+    ocr_image_free(&p->image);
+    free(p->grid);
+    free(p->words);
+    memset(p, 0, sizeof(*p));
+}
+
+int gen_write(const GenPuzzle *p, const char *prefix)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s.png", prefix);
+    if (ocr_image_save_png(path, &p->image) != 0) {
+        fprintf(stderr, "Ecriture impossible : %s\n", path);
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s_grid.txt", prefix);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    for (int i = 0; i < p->rows; ++i)
+        for (int j = 0; j < p->cols; ++j)
+            fprintf(f, "%c%c", p->grid[(size_t)i * (size_t)p->cols + (size_t)j], j + 1 < p->cols ? ' ' : '\n');
+    fclose(f);
+
+    snprintf(path, sizeof(path), "%s_words.txt", prefix);
+    f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    for (int i = 0; i < p->nwords; ++i) fprintf(f, "%s\n", p->words[i].word);
+    fclose(f);
+
+    snprintf(path, sizeof(path), "%s_solution.txt", prefix);
+    f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    for (int i = 0; i < p->nwords; ++i)
+        fprintf(f, "%s %d %d %d %d\n", p->words[i].word, p->words[i].x0, p->words[i].y0,
+                p->words[i].x1, p->words[i].y1);
+    fclose(f);
+    return 0;
+}
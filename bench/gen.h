@@ -0,0 +1,50 @@
+#ifndef GEN_H
+#define GEN_H
+
+#include "ocr.h"
+
+/* Generateur de mots meles synthetiques : grille a traits bleus, liste de mots a gauche
+ * (meme mise en page que binary/samples), lettres tirees du jeu d'entrainement du reseau. */
+
+typedef struct {
+    int rows;
+    int cols;
+    int cell;          /* cote d'une case en pixels */
+    double scale;      /* hauteur des lettres / cote de la case */
+    double rotate;     /* degres, sens trigonometrique */
+    double noise;      /* ecart type du bruit gaussien, en niveaux de gris */
+    int nwords;        /* 0 : autant que la liste en place */
+    unsigned int seed;
+    const char *glyphs;     /* dossier A/ .. Z/ de tuiles 32x32 */
+    const char *words_file; /* un mot par ligne, NULL : liste integree */
+} GenOptions;
+
+typedef struct {
+    char word[32];
+    int x0, y0, x1, y1; /* colonne, ligne de la premiere et de la derniere lettre */
+} GenWord;
+
+typedef struct {
+    OcrImage image;  /* RGBA */
+    int rows;
+    int cols;
+    char *grid;      /* rows x cols lettres */
+    GenWord *words;
+    int nwords;
+} GenPuzzle;
+
+typedef struct {
+    OcrImage letters[26][8];
+    int count[26];
+} GenGlyphs;
+
+void gen_default_options(GenOptions *o);
+int gen_load_glyphs(const char *dir, GenGlyphs *g);
+void gen_free_glyphs(GenGlyphs *g);
+int gen_puzzle(const GenOptions *o, const GenGlyphs *g, GenPuzzle *p);
+void gen_free(GenPuzzle *p);
+/* prefix.png, prefix_grid.txt (format de solver/grid), prefix_words.txt,
+ * prefix_solution.txt ("MOT x0 y0 x1 y1"). */
+int gen_write(const GenPuzzle *p, const char *prefix);
+
+#endif
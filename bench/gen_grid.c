@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gen.h"
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [--size N | --rows R --cols C] [--cell PX] [--scale F] [--rotate DEG]\n"
+            "       [--noise SIGMA] [--words mots.txt] [--nwords N] [--seed S] [--glyphs dossier]\n"
+            "       prefixe\n"
+            "Ecrit prefixe.png, prefixe_grid.txt, prefixe_words.txt et prefixe_solution.txt\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    GenOptions o;
+    gen_default_options(&o);
+    const char *prefix = NULL;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        int more = i + 1 < argc;
+        if (strcmp(a, "--size") == 0 && more) {
+            o.rows = o.cols = atoi(argv[++i]);
+        } else if (strcmp(a, "--rows") == 0 && more) {
+            o.rows = atoi(argv[++i]);
+        } else if (strcmp(a, "--cols") == 0 && more) {
+            o.cols = atoi(argv[++i]);
+        } else if (strcmp(a, "--cell") == 0 && more) {
+            o.cell = atoi(argv[++i]);
+        } else if (strcmp(a, "--scale") == 0 && more) {
+            o.scale = atof(argv[++i]);
+        } else if (strcmp(a, "--rotate") == 0 && more) {
+            o.rotate = atof(argv[++i]);
+        } else if (strcmp(a, "--noise") == 0 && more) {
+            o.noise = atof(argv[++i]);
+        } else if (strcmp(a, "--words") == 0 && more) {
+            o.words_file = argv[++i];
+        } else if (strcmp(a, "--nwords") == 0 && more) {
+            o.nwords = atoi(argv[++i]);
+        } else if (strcmp(a, "--seed") == 0 && more) {
+            o.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(a, "--glyphs") == 0 && more) {
+            o.glyphs = argv[++i];
+        } else if (a[0] == '-' && a[1] == '-') {
+            fprintf(stderr, "Argument inconnu: %s\n", a);
+            usage(argv[0]);
+            return 1;
+        } else {
+            prefix = a;
+        }
+    }
+    if (!prefix || o.rows < 2 || o.cols < 2 || o.cell < 8 || o.scale <= 0.0 || o.scale > 1.0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    GenGlyphs glyphs;
+    if (gen_load_glyphs(o.glyphs, &glyphs) != 0) return 2;
+    GenPuzzle p;
+    int rc = gen_puzzle(&o, &glyphs, &p);
+    gen_free_glyphs(&glyphs);
+    if (rc != 0) {
+        fprintf(stderr, "X mémoire\n");
+        return 3;
+    }
+    rc = gen_write(&p, prefix);
+    if (rc == 0)
+        printf("%s.png : %dx%d px, grille %dx%d, %d mots\n", prefix, p.image.width, p.image.height,
+               p.rows, p.cols, p.nwords);
+    gen_free(&p);
+    return rc == 0 ? 0 : 4;
+}
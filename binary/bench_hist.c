@@ -0,0 +1,126 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "histogram.h"
+#include "ocr.h"
+#include "timing.h"
+
+static unsigned int rng_state = 12345u;
+
+static unsigned int rng(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+/* Papier bruite, traits de grille tous les 64 pixels et taches d'encre. */
+static void fill_grid(unsigned char *gray, int w, int h)
+{
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            unsigned int r = rng();
+            unsigned char v = (unsigned char)(200u + r % 56u);
+            if (x % 64 < 3 || y % 64 < 3) v = (unsigned char)(r % 60u);
+            else if ((r & 31u) == 0) v = (unsigned char)(20u + (r >> 5) % 100u);
+            gray[(size_t)y * (size_t)w + (size_t)x] = v;
+        }
+    }
+}
+
+static double cdf_gap(const unsigned int a[256], double na, const unsigned int b[256], double nb)
+{
+    double ca = 0.0, cb = 0.0, gap = 0.0;
+    for (int t = 0; t < 256; ++t) {
+        ca += a[t];
+        cb += b[t];
+        double d = fabs(ca / na - cb / nb);
+        if (d > gap) gap = d;
+    }
+    return gap;
+}
+
+static int bench_plane(const char *name, const unsigned char *gray, int w, int h, int reps)
+{
+    const size_t n = (size_t)w * (size_t)h;
+    unsigned int ref[256] = {0}, hist[256];
+    double best = TIMING_NONE;
+    for (int r = 0; r < reps; ++r) {
+        memset(ref, 0, sizeof(ref));
+        double t0 = timing_now_ms();
+        hist_gray(gray, w, h, (size_t)w, ref);
+        best = timing_keep_best(best, t0);
+    }
+    const double base = best;
+    const int t_ref = hist_otsu(ref, n, 128);
+    int status = 0;
+    printf("%s : %dx%d, seuil %d\n", name, w, h, t_ref);
+    printf("  serie        %8.2f ms  %7.1f Mpx/s\n", base, (double)n / base * 1e-3);
+
+    const int threads[] = { 2, 4, 8 };
+    for (size_t k = 0; k < sizeof(threads) / sizeof(threads[0]); ++k) {
+        best = TIMING_NONE;
+        for (int r = 0; r < reps; ++r) {
+            memset(hist, 0, sizeof(hist));
+            double t0 = timing_now_ms();
+            hist_gray_parallel(gray, w, h, (size_t)w, hist, threads[k]);
+            best = timing_keep_best(best, t0);
+        }
+        int same = memcmp(hist, ref, sizeof(ref)) == 0;
+        if (!same) status = 1;
+        printf("  %d threads    %8.2f ms  x%.2f  %s\n", threads[k], best, base / best,
+               same ? "identique" : "DIFFERENT");
+    }
+
+    /* seul l'ecart de repartition est borne (et verifie) ; la derive du seuil est mesuree */
+    const double eps[] = { 0.05, 0.02, 0.01, 0.005 };
+    for (size_t k = 0; k < sizeof(eps) / sizeof(eps[0]); ++k) {
+        int step = hist_sample_step(w, h, eps[k], 0.01);
+        size_t m = 0;
+        best = TIMING_NONE;
+        for (int r = 0; r < reps; ++r) {
+            memset(hist, 0, sizeof(hist));
+            double t0 = timing_now_ms();
+            m = hist_gray_sampled(gray, w, h, (size_t)w, step, hist);
+            best = timing_keep_best(best, t0);
+        }
+        double gap = cdf_gap(hist, (double)m, ref, (double)n);
+        int t = hist_otsu(hist, m, 128);
+        if (gap > eps[k]) status = 1;
+        printf("  eps %.3f    %8.2f ms  x%.1f  pas %d, %zu px, ecart cdf %.4f, seuil %d (derive %+d)\n",
+               eps[k], best, base / best, step, m, gap, t, t - t_ref);
+    }
+    return status;
+}
+
+/* bench_hist [Mpx] [passes] [image...] : plan synthetique puis images donnees. */
+int main(int argc, char **argv)
+{
+    double mpix = argc > 1 ? atof(argv[1]) : 24.0;
+    int reps = argc > 2 ? atoi(argv[2]) : 5;
+    if (mpix <= 0.0) mpix = 24.0;
+    if (reps < 1) reps = 1;
+
+    int side = (int)sqrt(mpix * 1e6);
+    unsigned char *gray = malloc((size_t)side * (size_t)side);
+    if (!gray) {
+        fprintf(stderr, "pas assez de mémoire\n");
+        return 1;
+    }
+    fill_grid(gray, side, side);
+    int status = bench_plane("synthetique", gray, side, side, reps);
+    free(gray);
+
+    for (int i = 3; i < argc; ++i) {
+        OcrImage img;
+        if (ocr_image_load(argv[i], 1, &img) != 0) {
+            fprintf(stderr, "Echec : %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        status |= bench_plane(argv[i], img.pixels, img.width, img.height, reps);
+        ocr_image_free(&img);
+    }
+    return status;
+}
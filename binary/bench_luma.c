@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "luma.h"
+#include "timing.h"
+
+static unsigned int rng_state = 12345u;
+
+static unsigned int rng(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+/* Meme repartition qu'un scan : surtout du papier opaque, un peu d'encre et d'alpha. */
+static void fill_scan(unsigned char *rgba, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        unsigned int r = rng();
+        unsigned char *px = rgba + i * 4;
+        if ((r & 15u) == 0) {
+            px[0] = (unsigned char)rng();
+            px[1] = (unsigned char)rng();
+            px[2] = (unsigned char)rng();
+            px[3] = (unsigned char)((r >> 4) & 1u ? rng() : 255u);
+        } else {
+            unsigned char v = (unsigned char)(220u + (r >> 4) % 36u);
+            px[0] = v; px[1] = v; px[2] = v; px[3] = 255;
+        }
+    }
+}
+
+static int check_exhaustive(LumaKernel k)
+{
+    const size_t n = 256u * 256u * 256u;
+    unsigned char *rgba = malloc(n * 4);
+    unsigned char *ref = malloc(n);
+    unsigned char *out = malloc(n);
+    if (!rgba || !ref || !out) {
+        free(rgba); free(ref); free(out);
+        return -1;
+    }
+    int bad = 0;
+    for (unsigned int a = 0; a < 256 && !bad; a += 17) {
+        for (size_t i = 0; i < n; ++i) {
+            rgba[i * 4 + 0] = (unsigned char)(i >> 16);
+            rgba[i * 4 + 1] = (unsigned char)(i >> 8);
+            rgba[i * 4 + 2] = (unsigned char)i;
+            rgba[i * 4 + 3] = (unsigned char)a;
+        }
+        unsigned int h_ref[256] = {0}, h_out[256] = {0};
+        luma_rgba_hist_scalar(rgba, n, ref, h_ref);
+        luma_select(k);
+        luma_rgba_hist(rgba, n, out, h_out);
+        if (memcmp(ref, out, n) != 0 || memcmp(h_ref, h_out, sizeof(h_ref)) != 0)
+            bad = 1;
+    }
+    free(rgba); free(ref); free(out);
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    double mpix = argc > 1 ? atof(argv[1]) : 24.0;
+    int reps = argc > 2 ? atoi(argv[2]) : 5;
+    int exhaustive = argc > 3 && strcmp(argv[3], "--exhaustive") == 0;
+    if (mpix <= 0.0) mpix = 24.0;
+    if (reps < 1) reps = 1;
+
+    size_t n = (size_t)(mpix * 1e6);
+    unsigned char *rgba = malloc(n * 4);
+    unsigned char *ref = malloc(n);
+    unsigned char *gray = malloc(n);
+    if (!rgba || !ref || !gray) {
+        fprintf(stderr, "pas assez de mémoire\n");
+        return 1;
+    }
+    fill_scan(rgba, n);
+
+    unsigned int h_ref[256] = {0};
+    luma_rgba_hist_scalar(rgba, n, ref, h_ref);
+
+    const LumaKernel kernels[] = { LUMA_KERNEL_SCALAR, LUMA_KERNEL_SSE2, LUMA_KERNEL_AVX2 };
+    double base = 0.0;
+    int status = 0;
+    printf("%.1f Mpx, %d passes\n", mpix, reps);
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        if (luma_select(kernels[k]) != 0) {
+            printf("%-7s non supporte\n", luma_kernel_name(kernels[k]));
+            continue;
+        }
+        double best = TIMING_NONE;
+        unsigned int hist[256];
+        for (int r = 0; r < reps; ++r) {
+            memset(hist, 0, sizeof(hist));
+            double t0 = timing_now_ms();
+            luma_rgba_hist(rgba, n, gray, hist);
+            best = timing_keep_best(best, t0);
+        }
+        int same = memcmp(gray, ref, n) == 0 && memcmp(hist, h_ref, sizeof(hist)) == 0;
+        if (!same) status = 1;
+        if (kernels[k] == LUMA_KERNEL_SCALAR) base = best;
+        printf("%-7s %8.2f ms  %7.1f Mpx/s  x%.2f  %s\n",
+               luma_kernel_name(kernels[k]), best, (double)n / best * 1e-3,
+               base > 0.0 ? base / best : 1.0, same ? "identique" : "DIFFERENT");
+        if (exhaustive && kernels[k] != LUMA_KERNEL_SCALAR) {
+            int bad = check_exhaustive(kernels[k]);
+            printf("        exhaustif: %s\n", bad ? "DIFFERENT" : "identique");
+            if (bad) status = 1;
+        }
+    }
+
+    free(rgba);
+    free(ref);
+    free(gray);
+    return status;
+}
@@ -1,9 +1,9 @@
-#define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -14,8 +14,11 @@
 #define MKDIR(path) mkdir(path, 0755)
 #endif
 
-#include "stb_image.h"
-#include "stb_image_write.h"
+#include "ocr.h"
+#include "stream.h"
+#include "pool.h"
+#include "bitimg.h"
+#include "timing.h"
 
 static void basename_no_ext(const char* path, char* out, size_t n) 
 {
@@ -42,137 +45,450 @@ static void basename_no_ext(const char* path, char* out, size_t n)
     out[len] = '\0';
 }
 
-static int otsu_threshold(const unsigned int hist[256], unsigned int total) 
+typedef enum 
 {
-    double sum = 0.0;
-    for (int t = 0; t < 256; ++t) 
-    {
-        sum += t * (double)hist[t];
-    }
+    MODE_OTSU = 0,
+    MODE_FORCED,
+    MODE_ADAPTIVE
+} ThresholdMode;
 
-    double sumB = 0.0;
-    unsigned int wB = 0;
-    unsigned int wF = 0;
-    double varMax = -1.0;
-    int threshold = 128;
+typedef struct 
+{
+    const char* input;
+    const char* batch;
+    int jobs;
+    ThresholdMode mode;
+    int threshold;
+    int stream;
+    int strip_rows;
+    int png;
+    AdaptiveOptions adaptive;
+} BinaryOptions;
 
-    for (int t = 0; t < 256; ++t) 
-    {
-        wB += hist[t];
-        if (wB == 0) continue;
-        wF = total - wB;
-        if (wF == 0) break;
+typedef struct 
+{
+    int width;
+    int height;
+    double decode_ms;
+    double convert_ms;
+    double encode_ms;
+} ImageTiming;
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s image [seuil] [--sauvola|--niblack] [--window N] [--k X] [--threads N]\n"
+            "       [--stream] [--strip N] [--png]\n"
+            "       %s --batch dossier|liste.txt [--jobs N] [seuil] [options]\n",
+            prog, prog);
+}
 
-        sumB += t * (double)hist[t];
-        double mB = sumB / wB;
-        double mF = (sum - sumB) / wF;
+static int parse_args(int argc, char** argv, BinaryOptions* opts)
+{
+    opts->input = NULL;
+    opts->batch = NULL;
+    opts->jobs = 0;
+    opts->mode = MODE_OTSU;
+    opts->threshold = 128;
+    opts->stream = 0;
+    opts->strip_rows = STREAM_DEFAULT_STRIP;
+    opts->png = 0;
+    adaptive_default_options(&opts->adaptive, ADAPTIVE_SAUVOLA);
 
-        double varBetween = (double)wB * (double)wF * (mB - mF) * (mB - mF);
-        if (varBetween > varMax) 
+    const char* positional[2] = { NULL, NULL };
+    int npos = 0;
+    int k_set = 0;
+    double k = 0.0;
+    for (int i = 1; i < argc; ++i) 
+    {
+        const char* a = argv[i];
+        if (strcmp(a, "--sauvola") == 0 || strcmp(a, "--niblack") == 0) 
+        {
+            int window = opts->adaptive.window;
+            int threads = opts->adaptive.threads;
+            adaptive_default_options(&opts->adaptive,
+                                     a[2] == 'n' ? ADAPTIVE_NIBLACK : ADAPTIVE_SAUVOLA);
+            opts->adaptive.window = window;
+            opts->adaptive.threads = threads;
+            opts->mode = MODE_ADAPTIVE;
+        }
+        else if (strcmp(a, "--window") == 0 && i + 1 < argc) 
+        {
+            opts->adaptive.window = atoi(argv[++i]) | 1;
+        }
+        else if (strcmp(a, "--k") == 0 && i + 1 < argc) 
+        {
+            k = atof(argv[++i]);
+            k_set = 1;
+        }
+        else if (strcmp(a, "--threads") == 0 && i + 1 < argc) 
+        {
+            opts->adaptive.threads = atoi(argv[++i]);
+        }
+        else if (strcmp(a, "--stream") == 0) 
+        {
+            opts->stream = 1;
+        }
+        else if (strcmp(a, "--strip") == 0 && i + 1 < argc) 
+        {
+            opts->strip_rows = atoi(argv[++i]);
+            opts->stream = 1;
+        }
+        else if (strcmp(a, "--png") == 0) 
+        {
+            opts->png = 1;
+        }
+        else if (strcmp(a, "--batch") == 0 && i + 1 < argc) 
+        {
+            opts->batch = argv[++i];
+        }
+        else if (strcmp(a, "--jobs") == 0 && i + 1 < argc) 
+        {
+            opts->jobs = atoi(argv[++i]);
+        }
+        else if (a[0] == '-' && a[1] == '-') 
+        {
+            fprintf(stderr, "Argument inconnu: %s\n", a);
+            return -1;
+        }
+        else if (npos < 2) 
+        {
+            positional[npos++] = a;
+        }
+        else 
         {
-            varMax = varBetween;
-            threshold = t;
+            fprintf(stderr, "Argument en trop: %s\n", a);
+            return -1;
         }
     }
-    return threshold;
-}
 
-int main(int argc, char** argv)
-{ 
-    if (argc < 2) 
+    int p = 0;
+    if (!opts->batch) 
     {
-        return 1;
+        opts->input = positional[p++];
+        if (!opts->input) return -1;
+    }
+    if (p < npos) 
+    {
+        opts->threshold = atoi(positional[p]);
+        if (opts->threshold < 0) opts->threshold = 0;
+        if (opts->threshold > 255) opts->threshold = 255;
+        if (opts->mode != MODE_ADAPTIVE) opts->mode = MODE_FORCED;
+    }
+    if (k_set) opts->adaptive.k = k;
+    if (opts->adaptive.window < 3 || opts->adaptive.window > ADAPTIVE_MAX_WINDOW) 
+    {
+        fprintf(stderr, "Fenetre invalide (3..%d)\n", ADAPTIVE_MAX_WINDOW);
+        return -1;
+    }
+    if (opts->stream && opts->mode == MODE_ADAPTIVE) 
+    {
+        fprintf(stderr, "--stream ne gere que le seuil global\n");
+        return -1;
     }
+    if (opts->strip_rows < 1) opts->strip_rows = 1;
+    return 0;
+}
 
-    int use_forced_threshold = 0;
-    int threshold = 128;
-    if (argc >= 3) 
+static int binarize_stream(const BinaryOptions* opts, const char* in_path, const char* out_path, ImageTiming* t)
+{
+    StreamStats st = {0};
+    int threshold = opts->threshold;
+    double t0 = timing_now_ms();
+    if (opts->mode == MODE_OTSU) 
     {
-        threshold = atoi(argv[2]);
-        if (threshold < 0) threshold = 0;
-        if (threshold > 255) threshold = 255;
-        use_forced_threshold = 1;
+        unsigned int hist[256] = {0};
+        int rc = stream_png_histogram(in_path, opts->strip_rows, hist, &st);
+        if (rc != STREAM_OK) return rc;
+        threshold = ocr_otsu_threshold(hist, (unsigned long long)st.width * (unsigned long long)st.height);
     }
+    int rc = opts->png
+        ? stream_png_threshold(in_path, out_path, opts->strip_rows, threshold, &st)
+        : stream_png_threshold_bits(in_path, out_path, opts->strip_rows, threshold, &st);
+    t->width = st.width;
+    t->height = st.height;
+    t->convert_ms = timing_now_ms() - t0;
+    return rc;
+}
 
-    char in_path[512];
-    snprintf(in_path, sizeof(in_path), "samples/%s", argv[1]);
+static int binarize_file(const BinaryOptions* opts, const char* in_path, const char* out_path, ImageTiming* t)
+{
+    memset(t, 0, sizeof(*t));
+    if (opts->stream) 
+    {
+        int rc = binarize_stream(opts, in_path, out_path, t);
+        if (rc == STREAM_OK) 
+        {
+            return 0;
+        }
+        if (rc != STREAM_UNSUPPORTED) 
+        {
+            fprintf(stderr, "Echec : %s\n", in_path);
+            return 2;
+        }
+        fprintf(stderr, "--stream: PNG non entrelace uniquement, chargement complet\n");
+    }
 
-    int w, h, comp;
-    unsigned char* img = stbi_load(in_path, &w, &h, &comp, 4);
-    if (!img) 
+    double t0 = timing_now_ms();
+    OcrImage img;
+    if (ocr_image_load(in_path, 4, &img) != 0) 
     {
         fprintf(stderr, "Echec : %s\n", in_path);
         return 2;
     }
-    const int src_c = 4;
-    const int stride = w * src_c;
+    double t1 = timing_now_ms();
+    t->width = img.width;
+    t->height = img.height;
+    t->decode_ms = t1 - t0;
+
+    OcrBinarizeOptions bopts;
+    ocr_binarize_default_options(&bopts);
+    bopts.mode = opts->mode == MODE_ADAPTIVE ? OCR_THRESHOLD_ADAPTIVE
+               : opts->mode == MODE_FORCED ? OCR_THRESHOLD_FIXED : OCR_THRESHOLD_OTSU;
+    bopts.threshold = opts->threshold;
+    bopts.adaptive = opts->adaptive;
+    bopts.threads = opts->adaptive.threads;
 
-    unsigned char* gray = (unsigned char*)malloc((size_t)w * (size_t)h);
-    if (!gray) 
+    OcrImage bw;
+    int rc = ocr_binarize(&img, &bw, &bopts, NULL);
+    ocr_image_free(&img);
+    if (rc != 0) 
     {
-        stbi_image_free(img);
-        fprintf(stderr, "pas assez de mémoire\n");
+        fprintf(stderr, "X mémoire\n");
         return 3;
     }
+    double t2 = timing_now_ms();
+    t->convert_ms = t2 - t1;
+
+    int written = opts->png ? ocr_image_save_png(out_path, &bw) == 0
+                            : bitimg_write(out_path, bw.pixels, bw.width, bw.height) == 0;
+    if (!written) 
+    {
+        fprintf(stderr, "Echec ecriture: %s\n", out_path);
+        ocr_image_free(&bw);
+        return 4;
+    }
+    t->encode_ms = timing_now_ms() - t2;
+
+    ocr_image_free(&bw);
+    return 0;
+}
+
+static void output_path_for(const BinaryOptions* opts, const char* input, char* out, size_t n)
+{
+    char base[256];
+    basename_no_ext(input, base, sizeof(base));
+    snprintf(out, n, "out/%s_bw.%s", base, opts->png ? "png" : BITIMG_EXT);
+}
+
+static int is_image_name(const char* name)
+{
+    const char* dot = strrchr(name, '.');
+    if (!dot) return 0;
+    char e[8] = {0};
+    size_t len = strlen(dot + 1);
+    if (len >= sizeof(e)) return 0;
+    for (size_t i = 0; i < len; ++i) e[i] = (char)tolower((unsigned char)dot[1 + i]);
+    return !strcmp(e, "png") || !strcmp(e, "jpg") || !strcmp(e, "jpeg") || !strcmp(e, "bmp");
+}
+
+static int cmp_path(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static int push_path(char*** list, size_t* count, size_t* cap, const char* path)
+{
+    if (*count == *cap) 
+    {
+        size_t ncap = *cap ? *cap * 2 : 64;
+        char** tmp = (char**)realloc(*list, ncap * sizeof(char*));
+        if (!tmp) return -1;
+        *list = tmp;
+        *cap = ncap;
+    }
+    size_t len = strlen(path);
+    char* copy = (char*)malloc(len + 1);
+    if (!copy) return -1;
+    memcpy(copy, path, len + 1);
+    (*list)[(*count)++] = copy;
+    return 0;
+}
 
-    unsigned int hist[256] = {0};
+static char** collect_inputs(const char* src, size_t* count)
+{
+    char** list = NULL;
+    size_t cap = 0;
+    *count = 0;
 
-    for (int y = 0; y < h; y++) 
+    DIR* d = opendir(src);
+    if (d) 
     {
-        const unsigned char* row = img + (size_t)y * (size_t)stride;
-        for (int x = 0; x < w; x++) 
+        struct dirent* e;
+        while ((e = readdir(d))) 
         {
-            const unsigned char* px = row + (size_t)x * (size_t)src_c;
-            unsigned int r = px[0], g = px[1], b = px[2], a = px[3];
+            if (e->d_name[0] == '.' || !is_image_name(e->d_name)) continue;
+            char p[1024];
+            size_t len = strlen(src);
+            snprintf(p, sizeof(p), (len && src[len - 1] == '/') ? "%s%s" : "%s/%s", src, e->d_name);
+            if (push_path(&list, count, &cap, p) != 0) break;
+        }
+        closedir(d);
+        qsort(list, *count, sizeof(char*), cmp_path);
+        return list;
+    }
 
-            r = (r * a + 255u * (255u - a)) / 255u;
-            g = (g * a + 255u * (255u - a)) / 255u;
-            b = (b * a + 255u * (255u - a)) / 255u;
+    FILE* f = fopen(src, "r");
+    if (!f) return NULL;
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) 
+    {
+        size_t len = strlen(line);
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r' || line[len - 1] == ' ')) line[--len] = '\0';
+        if (len == 0 || line[0] == '#') continue;
+        if (push_path(&list, count, &cap, line) != 0) break;
+    }
+    fclose(f);
+    return list;
+}
 
-            unsigned int y8 = (unsigned int)(0.299 * r + 0.587 * g + 0.114 * b + 0.5);
-            if (y8 > 255u) y8 = 255u;
+typedef struct 
+{
+    const BinaryOptions* opts;
+    const char* in_path;
+    char out_path[512];
+    ImageTiming timing;
+    int status;
+    size_t index;
+    size_t total;
+    size_t* done;
+    pthread_mutex_t* print_lock;
+} BatchItem;
 
-            gray[(size_t)y * (size_t)w + (size_t)x] = (unsigned char)y8;
-            hist[y8]++;
-        }
+static void batch_task(void* arg)
+{
+    BatchItem* it = (BatchItem*)arg;
+    it->status = binarize_file(it->opts, it->in_path, it->out_path, &it->timing);
+
+    pthread_mutex_lock(it->print_lock);
+    size_t n = ++*it->done;
+    const ImageTiming* t = &it->timing;
+    if (it->status == 0) 
+    {
+        printf("[%zu/%zu] %s %dx%d  decodage %.1f ms  conversion %.1f ms  encodage %.1f ms -> %s\n",
+               n, it->total, it->in_path, t->width, t->height,
+               t->decode_ms, t->convert_ms, t->encode_ms, it->out_path);
     }
+    else 
+    {
+        printf("[%zu/%zu] %s ECHEC (%d)\n", n, it->total, it->in_path, it->status);
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(it->print_lock);
+}
 
-    if (!use_forced_threshold) 
+static int run_batch(const BinaryOptions* opts)
+{
+    size_t count = 0;
+    char** inputs = collect_inputs(opts->batch, &count);
+    if (!inputs || count == 0) 
     {
-        threshold = otsu_threshold(hist, (unsigned int)((unsigned long long)w * (unsigned long long)h));
+        fprintf(stderr, "Aucune image dans %s\n", opts->batch);
+        free(inputs);
+        return 2;
     }
 
-    unsigned char* bw = (unsigned char*)malloc((size_t)w * (size_t)h);
-    if (!bw) 
+    BinaryOptions item_opts = *opts;
+    if (item_opts.adaptive.threads <= 0) item_opts.adaptive.threads = 1;
+
+    BatchItem* items = (BatchItem*)calloc(count, sizeof(BatchItem));
+    Pool* pool = items ? pool_create(opts->jobs) : NULL;
+    if (!pool) 
     {
-        free(gray);
-        stbi_image_free(img);
         fprintf(stderr, "X mémoire\n");
+        free(items);
+        for (size_t i = 0; i < count; ++i) free(inputs[i]);
+        free(inputs);
         return 3;
     }
-    for (int i = 0, n = w * h; i < n; ++i) 
+
+    MKDIR("out");
+    pthread_mutex_t print_lock = PTHREAD_MUTEX_INITIALIZER;
+    size_t done = 0;
+    double t0 = timing_now_ms();
+    for (size_t i = 0; i < count; ++i) 
+    {
+        items[i].opts = &item_opts;
+        items[i].in_path = inputs[i];
+        output_path_for(opts, inputs[i], items[i].out_path, sizeof(items[i].out_path));
+        items[i].index = i;
+        items[i].total = count;
+        items[i].done = &done;
+        items[i].print_lock = &print_lock;
+        if (pool_submit(pool, batch_task, &items[i]) != 0) 
+        {
+            items[i].status = 3;
+        }
+    }
+    pool_wait(pool);
+    double wall_s = (timing_now_ms() - t0) * 1e-3;
+
+    size_t ok = 0;
+    double mpx = 0.0, decode = 0.0, convert = 0.0, encode = 0.0;
+    for (size_t i = 0; i < count; ++i) 
+    {
+        if (items[i].status != 0) continue;
+        ok++;
+        mpx += (double)items[i].timing.width * (double)items[i].timing.height * 1e-6;
+        decode += items[i].timing.decode_ms;
+        convert += items[i].timing.convert_ms;
+        encode += items[i].timing.encode_ms;
+    }
+    printf("%zu/%zu images en %.2f s sur %d threads : %.2f images/s, %.1f Mpx/s\n",
+           ok, count, wall_s, pool_size(pool),
+           wall_s > 0.0 ? (double)ok / wall_s : 0.0, wall_s > 0.0 ? mpx / wall_s : 0.0);
+    if (ok > 0) 
     {
-        bw[i] = (gray[i] >= threshold) ? 255 : 0;
+        printf("moyenne par image : decodage %.1f ms  conversion %.1f ms  encodage %.1f ms\n",
+               decode / (double)ok, convert / (double)ok, encode / (double)ok);
     }
 
+    pool_destroy(pool);
+    pthread_mutex_destroy(&print_lock);
+    free(items);
+    for (size_t i = 0; i < count; ++i) free(inputs[i]);
+    free(inputs);
+    return ok == count ? 0 : 5;
+}
+
+int main(int argc, char** argv)
+{ 
+    BinaryOptions opts;
+    if (parse_args(argc, argv, &opts) != 0) 
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (opts.batch) 
+    {
+        return run_batch(&opts);
+    }
+
+    char in_path[512];
+    snprintf(in_path, sizeof(in_path), "samples/%s", opts.input);
+
     MKDIR("out");
-    char base[256];
-    basename_no_ext(argv[1], base, sizeof(base));
     char out_path[512];
-    snprintf(out_path, sizeof(out_path), "out/%s_bw.png", base);
+    output_path_for(&opts, opts.input, out_path, sizeof(out_path));
 
-    if (!stbi_write_png(out_path, w, h, 1, bw, w)) 
+    ImageTiming timing;
+    int rc = binarize_file(&opts, in_path, out_path, &timing);
+    if (rc != 0) 
     {
-        fprintf(stderr, "Echec ecriture: %s\n", out_path);
-        free(bw);
-        free(gray);
-        stbi_image_free(img);
-        return 4;
+        return rc;
     }
 
     printf("OK -> %s", out_path);
-    free(bw);
-    free(gray);
-    stbi_image_free(img);
     return 0;
 }
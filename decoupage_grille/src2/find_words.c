@@ -13,16 +13,36 @@
 #define MKDIR(path) mkdir(path, 0755)
 #endif
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
+#include "ccl.h"
+#include "ocr.h"
+#include "sort.h"
 
 typedef struct {
     int x0, y0, x1, y1;
     double xc, yc;
 } Box;
 
+/* yc = (y0+y1)/2 : y0+y1 est une cle entiere equivalente */
+static int box_key_yc(const void *a)
+{
+    const Box *b = (const Box *)a;
+    return b->y0 + b->y1;
+}
+
+static int box_cmp_yc(const void *a, const void *b)
+{
+    const Box *ba = (const Box *)a;
+    const Box *bb = (const Box *)b;
+    return (ba->yc > bb->yc) - (ba->yc < bb->yc);
+}
+
+static int box_cmp_x0(const void *a, const void *b)
+{
+    const Box *ba = (const Box *)a;
+    const Box *bb = (const Box *)b;
+    return (ba->x0 > bb->x0) - (ba->x0 < bb->x0);
+}
+
 static int cmp_int(const void *a, const void *b)
 {
     int aa = *(const int *)a;
@@ -54,61 +74,35 @@ int main(int argc, char **argv)
     const char *in = argv[1];
     const char *out = argv[2];
 
-    int W, H, C;
-    unsigned char *pix = stbi_load(in, &W, &H, &C, 1);
-    if (!pix) return 1;
+    OcrImage img;
+    if (ocr_image_load(in, 1, &img) != 0) return 1;
+    int W = img.width, H = img.height;
+    unsigned char *pix = img.pixels;
 
-    unsigned char *vis = calloc(W*H,1);
-    int *stack = malloc(W*H*sizeof(int));
-    Box *L = malloc(sizeof(Box)*5000);
+    CclSet cc;
+    if (ccl_label(pix, W, H, img.stride, 199, 4, &cc) != 0) return 1;
+    Box *L = malloc(sizeof(Box)*(cc.count+1));
+    if (!L) {
+        ccl_free(&cc);
+        return 1;
+    }
     int nb = 0;
 
-    for (int y=0;y<H;y++)
-    for (int x=0;x<W;x++){
-        int id=y*W+x;
-        if (vis[id] || pix[id]>200) continue;
-
-        int x0=x,x1=x,y0=y,y1=y;
-        int sp=0;
-        vis[id]=1;
-        stack[sp++]=id;
-
-        while (sp){
-            int p=stack[--sp];
-            int py=p/W, px=p%W;
-
-            if(px<x0)x0=px;
-            if(px>x1)x1=px;
-            if(py<y0)y0=py;
-            if(py>y1)y1=py;
-
-            static int V[4][2]={{1,0},{-1,0},{0,1},{0,-1}};
-            for(int k=0;k<4;k++){
-                int nx=px+V[k][0];
-                int ny=py+V[k][1];
-                if(nx<0||ny<0||nx>=W||ny>=H) continue;
-                int nid=ny*W+nx;
-                if(!vis[nid] && pix[nid]<200){
-                    vis[nid]=1;
-                    stack[sp++]=nid;
-                }
-            }
-        }
-
-        int w=x1-x0+1, h=y1-y0+1;
+    for (size_t k=0;k<cc.count;k++){
+        const CclComponent *c=&cc.items[k];
+        int w=c->x1-c->x0+1, h=c->y1-c->y0+1;
         if (w<5 || h<5) continue;
 
-        L[nb].x0=x0;
-        L[nb].x1=x1;
-        L[nb].y0=y0;
-        L[nb].y1=y1;
-        L[nb].xc=(x0+x1)/2.0;
-        L[nb].yc=(y0+y1)/2.0;
+        L[nb].x0=c->x0;
+        L[nb].x1=c->x1;
+        L[nb].y0=c->y0;
+        L[nb].y1=c->y1;
+        L[nb].xc=(c->x0+c->x1)/2.0;
+        L[nb].yc=(c->y0+c->y1)/2.0;
         nb++;
     }
+    ccl_free(&cc);
 
-    free(vis);
-    free(stack);
     if (nb == 0) {
         free(L);
         return 0;
@@ -176,11 +170,8 @@ int main(int argc, char **argv)
         return 0;
     }
 
-    for(int i=0;i<nb;i++)
-    for(int j=i+1;j<nb;j++)
-        if(L[j].yc < L[i].yc){
-            Box t=L[i]; L[i]=L[j]; L[j]=t;
-        }
+    if (sort_by_key(L, nb, sizeof(Box), box_key_yc, 2*(H-1)) != 0)
+        sort_stable(L, nb, sizeof(Box), box_cmp_yc);
 
     int *start = malloc(nb*sizeof(int));
     int *count = malloc(nb*sizeof(int));
@@ -214,11 +205,7 @@ int main(int argc, char **argv)
         int st=start[r];
         int n=count[r];
 
-        for(int a=0;a<n;a++)
-        for(int b=a+1;b<n;b++)
-            if(L[st+b].x0<L[st+a].x0){
-                Box t=L[st+a]; L[st+a]=L[st+b]; L[st+b]=t;
-            }
+        sort_stable(L+st, n, sizeof(Box), box_cmp_x0);
 
         int gap_count = (n>1)? n-1 : 0;
         int *gaps = gap_count? malloc(sizeof(int)*gap_count) : NULL;
@@ -261,7 +248,8 @@ int main(int argc, char **argv)
 
             char fn[256];
             snprintf(fn,sizeof(fn),"%s/word_%d.png",out,word_id++);
-            stbi_write_png(fn,w,h,1,cut,w);
+            OcrImage word = {w, h, 1, (size_t)w, cut};
+            ocr_image_save_png(fn,&word);
 
             free(cut);
             a = b;
@@ -272,6 +260,6 @@ int main(int argc, char **argv)
     free(L);
     free(start);
     free(count);
-    stbi_image_free(pix);
+    ocr_image_free(&img);
     return 0;
 }
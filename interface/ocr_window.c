@@ -1,4 +1,5 @@
 #include "ocr_window.h"
+#include "histogram.h"
 #include <glib/gstdio.h>
 #include <math.h>
 #include <stdlib.h>
@@ -447,6 +448,8 @@ static GdkPixbuf* scale_pixbuf_to_max(const GdkPixbuf *src, int max_w, int max_h
 }
 
 static void binarize(const unsigned char *gray, unsigned char *bin, int w, int h);
+static void binarize_at(const unsigned char *gray, unsigned char *bin, int w, int h, int t);
+static int otsu_threshold_sampled(const unsigned char *gray, int w, int h);
 static int evaluate_angle_projection_x(const unsigned char *bin, int w, int h, double angle_deg);
 static int evaluate_angle_projection_y(const unsigned char *bin, int w, int h, double angle_deg);
 
@@ -508,7 +511,7 @@ static gdouble detect_grid_angle(const unsigned char *rgba, int w, int h) {
         }
     }
 
-    binarize(gray, bin, w, h);
+    binarize_at(gray, bin, w, h, otsu_threshold_sampled(gray, w, h));
 
     gdouble best_angle = 0.0;
     int best_score = -1;
@@ -565,41 +568,29 @@ static gdouble detect_grid_angle(const unsigned char *rgba, int w, int h) {
 }
 
 static int otsu_threshold(const unsigned char *gray, int w, int h) {
-    int hist[256] = {0};
-    int total = w * h;
-    for (int i = 0; i < total; ++i) hist[gray[i]]++;
-
-    double sum = 0.0;
-    for (int t = 0; t < 256; ++t) sum += t * hist[t];
-
-    double sumB = 0.0;
-    int wB = 0;
-    int wF = 0;
-    double varMax = -1.0;
-    int threshold = 127;
-
-    for (int t = 0; t < 256; ++t) {
-        wB += hist[t];
-        if (wB == 0) continue;
-        wF = total - wB;
-        if (wF == 0) break;
-        sumB += (double)t * hist[t];
-        double mB = sumB / wB;
-        double mF = (sum - sumB) / wF;
-        double varBetween = (double)wB * (double)wF * (mB - mF) * (mB - mF);
-        if (varBetween > varMax) {
-            varMax = varBetween;
-            threshold = t;
-        }
-    }
-    return threshold;
+    unsigned int hist[256] = {0};
+    hist_gray(gray, w, h, (size_t)w, hist);
+    return hist_otsu(hist, (unsigned long long)w * h, 127);
 }
 
-static void binarize(const unsigned char *gray, unsigned char *bin, int w, int h) {
-    int t = otsu_threshold(gray, w, h);
+/* Seuil approche pour la recherche d'angle seulement : l'histogramme d'un echantillon
+ * suffit a scorer les projections (cf. histogram.h pour ce qui est borne). Le bouton
+ * Binariser garde le seuil exact. */
+static int otsu_threshold_sampled(const unsigned char *gray, int w, int h) {
+    unsigned int hist[256] = {0};
+    int step = hist_sample_step(w, h, 0.01, 0.01);
+    size_t total = hist_gray_sampled(gray, w, h, (size_t)w, step, hist);
+    return hist_otsu(hist, total, 127);
+}
+
+static void binarize_at(const unsigned char *gray, unsigned char *bin, int w, int h, int t) {
     for (int i = 0; i < w*h; ++i) bin[i] = (gray[i] > t) ? 255 : 0;
 }
 
+static void binarize(const unsigned char *gray, unsigned char *bin, int w, int h) {
+    binarize_at(gray, bin, w, h, otsu_threshold(gray, w, h));
+}
+
 static int evaluate_angle_projection_x(const unsigned char *bin, int w, int h, double angle_deg) {
     double rad = angle_deg * M_PI / 180.0;
     double sinr = sin(rad);
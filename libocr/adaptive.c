@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L
+#include "adaptive.h"
+#include "pool.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Les tables sont en uint32 modulo 2^32 : une difference de 4 coins reste exacte tant
+ * que la vraie somme de la fenetre tient sur 32 bits, ce qui est garanti pour
+ * window <= 255 (255*255*255^2 < 2^32). 8 octets par pixel au lieu de 16. */
+typedef struct {
+    const unsigned char *gray;
+    unsigned char *bw;
+    uint32_t *sum;
+    uint32_t *sq;
+    int w, h;
+    int nthreads;
+    int phase;
+    const AdaptiveOptions *opts;
+} AdaptiveJob;
+
+typedef struct {
+    AdaptiveJob *job;
+    int index;
+} AdaptiveWorker;
+
+static void band(int n, int parts, int index, int *start, int *end)
+{
+    *start = (int)((long long)n * index / parts);
+    *end = (int)((long long)n * (index + 1) / parts);
+}
+
+static void row_prefix(AdaptiveJob *job, int index)
+{
+    const size_t stride = (size_t)job->w + 1;
+    int y0, y1;
+    band(job->h, job->nthreads, index, &y0, &y1);
+    for (int y = y0; y < y1; ++y) {
+        const unsigned char *src = job->gray + (size_t)y * (size_t)job->w;
+        uint32_t *s = job->sum + (size_t)(y + 1) * stride;
+        uint32_t *q = job->sq + (size_t)(y + 1) * stride;
+        uint32_t acc = 0, acc2 = 0;
+        s[0] = 0;
+        q[0] = 0;
+        for (int x = 0; x < job->w; ++x) {
+            uint32_t v = src[x];
+            acc += v;
+            acc2 += v * v;
+            s[x + 1] = acc;
+            q[x + 1] = acc2;
+        }
+    }
+}
+
+static void column_accumulate(AdaptiveJob *job, int index)
+{
+    const size_t stride = (size_t)job->w + 1;
+    int x0, x1;
+    band(job->w + 1, job->nthreads, index, &x0, &x1);
+    for (int y = 2; y <= job->h; ++y) {
+        uint32_t *s = job->sum + (size_t)y * stride;
+        uint32_t *q = job->sq + (size_t)y * stride;
+        const uint32_t *sp = s - stride;
+        const uint32_t *qp = q - stride;
+        for (int x = x0; x < x1; ++x) {
+            s[x] += sp[x];
+            q[x] += qp[x];
+        }
+    }
+}
+
+static void threshold_rows(AdaptiveJob *job, int index)
+{
+    const AdaptiveOptions *o = job->opts;
+    const size_t stride = (size_t)job->w + 1;
+    const int half = o->window / 2;
+    int y0, y1;
+    band(job->h, job->nthreads, index, &y0, &y1);
+    for (int y = y0; y < y1; ++y) {
+        int ya = y - half < 0 ? 0 : y - half;
+        int yb = y + half + 1 > job->h ? job->h : y + half + 1;
+        const uint32_t *sa = job->sum + (size_t)ya * stride;
+        const uint32_t *sb = job->sum + (size_t)yb * stride;
+        const uint32_t *qa = job->sq + (size_t)ya * stride;
+        const uint32_t *qb = job->sq + (size_t)yb * stride;
+        const unsigned char *src = job->gray + (size_t)y * (size_t)job->w;
+        unsigned char *dst = job->bw + (size_t)y * (size_t)job->w;
+        for (int x = 0; x < job->w; ++x) {
+            int xa = x - half < 0 ? 0 : x - half;
+            int xb = x + half + 1 > job->w ? job->w : x + half + 1;
+            double n = (double)(yb - ya) * (double)(xb - xa);
+            uint32_t s = sb[xb] - sb[xa] - sa[xb] + sa[xa];
+            uint32_t q = qb[xb] - qb[xa] - qa[xb] + qa[xa];
+            double mean = (double)s / n;
+            double var = (double)q / n - mean * mean;
+            double sd = var > 0.0 ? sqrt(var) : 0.0;
+            double t;
+            if (o->method == ADAPTIVE_NIBLACK)
+                t = mean + o->k * sd;
+            else
+                t = mean * (1.0 + o->k * (sd / o->r - 1.0));
+            dst[x] = ((double)src[x] >= t) ? 255 : 0;
+        }
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    AdaptiveWorker *wk = (AdaptiveWorker *)arg;
+    switch (wk->job->phase) {
+    case 0: row_prefix(wk->job, wk->index); break;
+    case 1: column_accumulate(wk->job, wk->index); break;
+    default: threshold_rows(wk->job, wk->index); break;
+    }
+    return NULL;
+}
+
+static void run_phase(AdaptiveJob *job, int phase)
+{
+    pthread_t tids[64];
+    AdaptiveWorker workers[64];
+    int started = 0;
+    job->phase = phase;
+    for (int t = 1; t < job->nthreads; ++t) {
+        workers[t].job = job;
+        workers[t].index = t;
+        if (pthread_create(&tids[t], NULL, worker_main, &workers[t]) != 0)
+            break;
+        started = t;
+    }
+    workers[0].job = job;
+    workers[0].index = 0;
+    worker_main(&workers[0]);
+    for (int t = started + 1; t < job->nthreads; ++t) {
+        workers[t].job = job;
+        workers[t].index = t;
+        worker_main(&workers[t]);
+    }
+    for (int t = 1; t <= started; ++t)
+        pthread_join(tids[t], NULL);
+}
+
+void adaptive_default_options(AdaptiveOptions *opts, AdaptiveMethod method)
+{
+    opts->method = method;
+    opts->window = 31;
+    opts->k = (method == ADAPTIVE_NIBLACK) ? -0.2 : 0.34;
+    opts->r = 128.0;
+    opts->threads = 0;
+}
+
+int adaptive_threshold(const unsigned char *gray, int w, int h, unsigned char *bw,
+                       const AdaptiveOptions *opts)
+{
+    if (!gray || !bw || !opts || w <= 0 || h <= 0) return -1;
+    if (opts->window < 1 || opts->window > ADAPTIVE_MAX_WINDOW) return -1;
+
+    const size_t cells = ((size_t)w + 1) * ((size_t)h + 1);
+    uint32_t *sum = calloc(cells, sizeof(uint32_t));
+    uint32_t *sq = calloc(cells, sizeof(uint32_t));
+    if (!sum || !sq) {
+        free(sum);
+        free(sq);
+        return -1;
+    }
+
+    AdaptiveJob job = {0};
+    job.gray = gray;
+    job.bw = bw;
+    job.sum = sum;
+    job.sq = sq;
+    job.w = w;
+    job.h = h;
+    job.opts = opts;
+    job.nthreads = opts->threads > 0 ? opts->threads : pool_default_threads();
+    if (job.nthreads > 64) job.nthreads = 64;
+    if (job.nthreads > h) job.nthreads = h;
+
+    run_phase(&job, 0);
+    run_phase(&job, 1);
+    run_phase(&job, 2);
+
+    free(sum);
+    free(sq);
+    return 0;
+}
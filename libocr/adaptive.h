@@ -0,0 +1,27 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#define ADAPTIVE_MAX_WINDOW 255
+
+typedef enum {
+    ADAPTIVE_SAUVOLA = 0,
+    ADAPTIVE_NIBLACK
+} AdaptiveMethod;
+
+typedef struct {
+    AdaptiveMethod method;
+    int window;
+    double k;
+    double r;
+    int threads;
+} AdaptiveOptions;
+
+void adaptive_default_options(AdaptiveOptions *opts, AdaptiveMethod method);
+
+/* Seuil local calcule sur une fenetre window x window centree (tronquee aux bords).
+ * Moyenne et variance viennent de tables sommees (somme et somme des carres),
+ * donc O(1) par pixel quelle que soit la fenetre. window <= ADAPTIVE_MAX_WINDOW. */
+int adaptive_threshold(const unsigned char *gray, int w, int h, unsigned char *bw,
+                       const AdaptiveOptions *opts);
+
+#endif
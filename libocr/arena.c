@@ -0,0 +1,105 @@
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_BLOC_DEFAUT (64u * 1024u)
+
+struct ArenaBloc {
+    ArenaBloc *suite;
+    size_t taille;
+    size_t pos;
+    size_t pad_;   /* en-tete de 32 octets : data reste aligne sur 16 */
+    unsigned char data[];
+};
+
+static ArenaBloc *nouveau_bloc(Arena *a, size_t taille)
+{
+    ArenaBloc *b = malloc(sizeof(ArenaBloc) + taille);
+    if (!b) return NULL;
+    b->suite = NULL;
+    b->taille = taille;
+    b->pos = 0;
+    a->blocs++;
+    return b;
+}
+
+void arena_init(Arena *a, size_t bloc_min)
+{
+    memset(a, 0, sizeof(*a));
+    a->bloc_min = bloc_min ? bloc_min : ARENA_BLOC_DEFAUT;
+}
+
+void *arena_alloc(Arena *a, size_t n)
+{
+    n = (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (n == 0) n = ARENA_ALIGN;
+    ArenaBloc *b = a->courant;
+    /* les blocs apres le courant sont libres (release/reset) : on les reprend */
+    while (b && b->pos + n > b->taille) {
+        b = b->suite;
+        if (b) b->pos = 0;
+    }
+    if (!b) {
+        size_t taille = a->bloc_min;
+        if (a->courant && a->courant->taille * 2 > taille) taille = a->courant->taille * 2;
+        if (taille < n) taille = n;
+        b = nouveau_bloc(a, taille);
+        if (!b) return NULL;
+        ArenaBloc *fin = a->premier;
+        while (fin && fin->suite) fin = fin->suite;
+        if (fin) fin->suite = b;
+        else a->premier = b;
+    }
+    a->courant = b;
+    void *p = b->data + b->pos;
+    b->pos += n;
+    a->used += n;
+    if (a->used > a->peak) a->peak = a->used;
+    return p;
+}
+
+ArenaMark arena_mark(const Arena *a)
+{
+    ArenaMark m = { a->courant, a->courant ? a->courant->pos : 0, a->used };
+    return m;
+}
+
+void arena_release(Arena *a, ArenaMark m)
+{
+    if (!m.bloc) {
+        a->courant = a->premier;
+        if (a->courant) a->courant->pos = 0;
+    } else {
+        a->courant = m.bloc;
+        m.bloc->pos = m.pos;
+    }
+    a->used = m.used;
+}
+
+void arena_reset(Arena *a)
+{
+    if (a->premier && a->premier->suite) {
+        size_t total = 0;
+        for (ArenaBloc *b = a->premier; b; b = b->suite) total += b->taille;
+        arena_free(a);
+        a->premier = nouveau_bloc(a, total);
+    }
+    a->courant = a->premier;
+    if (a->courant) a->courant->pos = 0;
+    a->used = 0;
+    a->peak = 0;
+}
+
+void arena_free(Arena *a)
+{
+    ArenaBloc *b = a->premier;
+    while (b) {
+        ArenaBloc *s = b->suite;
+        free(b);
+        b = s;
+    }
+    a->premier = a->courant = NULL;
+    a->used = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Arene d'allocation pour les tampons temporaires d'une image : les allocations avancent
+ * un pointeur dans des blocs chaines, rien n'est libere un par un. arena_release revient
+ * a une marque (fin d'une case, d'un mot). Une arene gardee d'une image a l'autre
+ * (ocr_split_grid_scratch, ocr_extract_words_scratch) est videe par arena_reset avant
+ * chaque image ; le reset fusionne les blocs, l'image suivante tient dans un seul et ne
+ * passe plus par malloc. Pas de verrou : une arene par thread. */
+
+typedef struct ArenaBloc ArenaBloc;
+
+typedef struct {
+    ArenaBloc *premier;
+    ArenaBloc *courant;
+    size_t bloc_min;
+    size_t used;    /* octets pris depuis le dernier reset */
+    size_t peak;    /* maximum de used depuis le dernier reset */
+    size_t blocs;   /* blocs demandes a malloc depuis arena_init */
+} Arena;
+
+typedef struct {
+    ArenaBloc *bloc;
+    size_t pos;
+    size_t used;
+} ArenaMark;
+
+void arena_init(Arena *a, size_t bloc_min);
+/* Aligne sur 16 octets ; NULL si malloc echoue. */
+void *arena_alloc(Arena *a, size_t n);
+ArenaMark arena_mark(const Arena *a);
+void arena_release(Arena *a, ArenaMark m);
+void arena_reset(Arena *a);
+void arena_free(Arena *a);
+
+#endif
@@ -0,0 +1,174 @@
+#define _POSIX_C_SOURCE 200809L
+#include "atlas.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static size_t pixels_offset(size_t count)
+{
+    size_t end = ATLAS_HEADER + count * ATLAS_ENTRY;
+    return (end + 63) / 64 * 64;
+}
+
+int atlas_write(const char *path, const OcrTileSet *tiles)
+{
+    if (!tiles) return -1;
+    const int tw = OCR_TILE_SIZE, th = OCR_TILE_SIZE;
+    for (size_t i = 0; i < tiles->count; ++i) {
+        const OcrImage *img = &tiles->tiles[i].img;
+        if (img->width != tw || img->height != th || img->channels != 1) return -1;
+    }
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+
+    size_t off = pixels_offset(tiles->count);
+    unsigned char *head = calloc(1, off);
+    if (!head) {
+        fclose(f);
+        return -1;
+    }
+    memcpy(head, ATLAS_MAGIC, 4);
+    put_u32(head + 4, ATLAS_VERSION);
+    put_u32(head + 8, (uint32_t)tiles->count);
+    put_u32(head + 12, (uint32_t)tw);
+    put_u32(head + 16, (uint32_t)th);
+    put_u32(head + 20, tiles->fallback ? 1u : 0u);
+    put_u32(head + 24, ATLAS_HEADER);
+    put_u32(head + 28, (uint32_t)off);
+    for (size_t i = 0; i < tiles->count; ++i) {
+        const OcrTile *t = &tiles->tiles[i];
+        unsigned char *e = head + ATLAS_HEADER + i * ATLAS_ENTRY;
+        const int v[6] = { t->row, t->col, t->x0, t->y0, t->x1, t->y1 };
+        for (int k = 0; k < 6; ++k) put_u32(e + 4 * k, (uint32_t)v[k]);
+    }
+    int rc = fwrite(head, 1, off, f) == off ? 0 : -1;
+    free(head);
+    for (size_t i = 0; rc == 0 && i < tiles->count; ++i) {
+        const OcrImage *img = &tiles->tiles[i].img;
+        for (int y = 0; rc == 0 && y < th; ++y)
+            if (fwrite(img->pixels + (size_t)y * img->stride, 1, (size_t)tw, f) != (size_t)tw) rc = -1;
+    }
+    if (fclose(f) != 0) rc = -1;
+    return rc;
+}
+
+static int parse_header(const unsigned char *h, size_t len, TileAtlas *a)
+{
+    if (len < ATLAS_HEADER || memcmp(h, ATLAS_MAGIC, 4) != 0) return -1;
+    if (get_u32(h + 4) != ATLAS_VERSION) return -1;
+    uint32_t n = get_u32(h + 8), tw = get_u32(h + 12), th = get_u32(h + 16);
+    uint32_t idx = get_u32(h + 24), off = get_u32(h + 28);
+    if (n > 0x7fffffff || tw == 0 || th == 0 || tw > 4096 || th > 4096) return -1;
+    if (idx < ATLAS_HEADER || idx > len || (len - idx) / ATLAS_ENTRY < n) return -1;
+    if (off < idx + (size_t)n * ATLAS_ENTRY || off > len) return -1;
+    if (n && (len - off) / ((size_t)tw * th) < n) return -1;
+    a->count = (int)n;
+    a->tile_w = (int)tw;
+    a->tile_h = (int)th;
+    a->fallback = (int)(get_u32(h + 20) & 1u);
+    a->index = h + idx;
+    a->pixels = h + off;
+    return 0;
+}
+
+int atlas_map(const char *path, TileAtlas *a)
+{
+    memset(a, 0, sizeof(*a));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < ATLAS_HEADER) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    if (parse_header((const unsigned char *)map, len, a) != 0) {
+        munmap(map, len);
+        memset(a, 0, sizeof(*a));
+        return -1;
+    }
+    a->map = map;
+    a->map_len = len;
+    return 0;
+}
+
+void atlas_unmap(TileAtlas *a)
+{
+    if (a && a->map) munmap(a->map, a->map_len);
+    if (a) memset(a, 0, sizeof(*a));
+}
+
+void atlas_entry(const TileAtlas *a, int i, AtlasEntry *e)
+{
+    const unsigned char *p = a->index + (size_t)i * ATLAS_ENTRY;
+    e->row = (int)get_u32(p);
+    e->col = (int)get_u32(p + 4);
+    e->x0 = (int)get_u32(p + 8);
+    e->y0 = (int)get_u32(p + 12);
+    e->x1 = (int)get_u32(p + 16);
+    e->y1 = (int)get_u32(p + 20);
+}
+
+int atlas_views(const TileAtlas *a, OcrTileSet *views)
+{
+    memset(views, 0, sizeof(*views));
+    if (a->count == 0) return 0;
+    views->tiles = malloc((size_t)a->count * sizeof(OcrTile));
+    if (!views->tiles) return -1;
+    for (int i = 0; i < a->count; ++i) {
+        AtlasEntry e;
+        atlas_entry(a, i, &e);
+        OcrTile *t = &views->tiles[i];
+        t->row = e.row;
+        t->col = e.col;
+        t->x0 = e.x0;
+        t->y0 = e.y0;
+        t->x1 = e.x1;
+        t->y1 = e.y1;
+        t->img.width = a->tile_w;
+        t->img.height = a->tile_h;
+        t->img.channels = 1;
+        t->img.stride = (size_t)a->tile_w;
+        t->img.pixels = (unsigned char *)atlas_pixels(a, i);
+    }
+    views->count = views->cap = (size_t)a->count;
+    views->fallback = a->fallback;
+    return 0;
+}
+
+void atlas_views_free(OcrTileSet *views)
+{
+    if (!views) return;
+    free(views->tiles);
+    memset(views, 0, sizeof(*views));
+}
+
+int atlas_recognize(const TileAtlas *a, const OcrModel *m, char *letters, float *conf)
+{
+    OcrTileSet views;
+    if (atlas_views(a, &views) != 0) return -1;
+    int rc = ocr_recognize_tiles(m, &views, letters, conf);
+    atlas_views_free(&views);
+    return rc;
+}
@@ -0,0 +1,65 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ocr.h"
+
+/* Atlas des cases d'une grille : un seul fichier brut, lisible par mmap, au lieu d'un PNG
+ * par case. En-tete de 64 octets (petit boutiste) :
+ *   0  "OCA1"    magic
+ *   4  u32       version (1)
+ *   8  u32       nombre de cases N
+ *   12 u32       largeur d'une case
+ *   16 u32       hauteur d'une case
+ *   20 u32       drapeaux (bit 0 : cases issues du repli sans lignes, cf. OcrTileSet)
+ *   24 u32       offset de l'index (64)
+ *   28 u32       offset des pixels (multiple de 64)
+ * puis N entrees d'index de 6 i32 : ligne, colonne, x0, y0, x1, y1 (case dans l'image
+ * binarisee), puis N cases de largeur x hauteur octets contigues (0 = encre, 255 = fond). */
+#define ATLAS_MAGIC "OCA1"
+#define ATLAS_EXT "oca"
+#define ATLAS_FILE "cases." ATLAS_EXT
+#define ATLAS_VERSION 1
+#define ATLAS_HEADER 64
+#define ATLAS_ENTRY 24
+
+typedef struct {
+    int count;
+    int tile_w;
+    int tile_h;
+    int fallback;
+    const uint8_t *index;
+    const uint8_t *pixels;
+    void *map;
+    size_t map_len;
+} TileAtlas;
+
+typedef struct {
+    int row, col;
+    int x0, y0, x1, y1;
+} AtlasEntry;
+
+/* Toutes les cases doivent mesurer OCR_TILE_SIZE x OCR_TILE_SIZE (sorties de ocr_split_grid). */
+int atlas_write(const char *path, const OcrTileSet *tiles);
+
+int atlas_map(const char *path, TileAtlas *atlas);
+void atlas_unmap(TileAtlas *atlas);
+void atlas_entry(const TileAtlas *atlas, int i, AtlasEntry *e);
+
+static inline const uint8_t *atlas_pixels(const TileAtlas *atlas, int i)
+{
+    return atlas->pixels + (size_t)i * (size_t)atlas->tile_w * (size_t)atlas->tile_h;
+}
+
+/* Vues sans copie : les images de views pointent dans la projection de l'atlas.
+ * A liberer avec atlas_views_free (jamais ocr_tiles_free), avant atlas_unmap. */
+int atlas_views(const TileAtlas *atlas, OcrTileSet *views);
+void atlas_views_free(OcrTileSet *views);
+
+/* Toutes les cases de l'atlas par lots (ocr_recognize_tiles) : letters[count] et, si non
+ * NULL, conf[count] = sortie du reseau pour la lettre retenue. */
+int atlas_recognize(const TileAtlas *atlas, const OcrModel *model, char *letters, float *conf);
+
+#endif
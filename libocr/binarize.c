@@ -0,0 +1,101 @@
+#include "ocr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "histogram.h"
+#include "luma.h"
+
+void ocr_binarize_default_options(OcrBinarizeOptions *opts)
+{
+    opts->mode = OCR_THRESHOLD_OTSU;
+    opts->threshold = 128;
+    adaptive_default_options(&opts->adaptive, ADAPTIVE_SAUVOLA);
+    opts->threads = 1;
+    opts->sample_eps = 0.0;
+}
+
+int ocr_otsu_threshold(const unsigned int hist[256], unsigned long long total)
+{
+    return hist_otsu(hist, total, 128);
+}
+
+/* Renvoie le nombre de pixels comptes dans hist (moins que w*h si echantillonne). */
+static unsigned long long to_gray(const OcrImage *src, unsigned char *gray, unsigned int hist[256],
+                                  const OcrBinarizeOptions *opts)
+{
+    const size_t n = (size_t)src->width * (size_t)src->height;
+    if (src->channels == 4) {
+        if (src->stride == (size_t)src->width * 4) {
+            hist_luma_parallel(src->pixels, n, gray, hist, opts->threads);
+        } else {
+            for (int y = 0; y < src->height; ++y)
+                luma_rgba_hist(src->pixels + (size_t)y * src->stride, (size_t)src->width,
+                               gray + (size_t)y * (size_t)src->width, hist);
+        }
+        return n;
+    }
+    if (src->channels != 1) return 0;
+    for (int y = 0; y < src->height; ++y)
+        memcpy(gray + (size_t)y * (size_t)src->width, src->pixels + (size_t)y * src->stride,
+               (size_t)src->width);
+    if (opts->mode != OCR_THRESHOLD_OTSU) return n;
+    if (opts->sample_eps > 0.0) {
+        int step = hist_sample_step(src->width, src->height, opts->sample_eps, 0.01);
+        return hist_gray_sampled(gray, src->width, src->height, (size_t)src->width, step, hist);
+    }
+    hist_gray_parallel(gray, src->width, src->height, (size_t)src->width, hist, opts->threads);
+    return n;
+}
+
+int ocr_binarize(const OcrImage *src, OcrImage *bw, const OcrBinarizeOptions *opts, int *threshold_out)
+{
+    if (!src || !src->pixels || !bw || !opts) return -1;
+    const int w = src->width, h = src->height;
+    const size_t n = (size_t)w * (size_t)h;
+
+    unsigned char *gray = malloc(n);
+    if (!gray) return -1;
+    unsigned int hist[256] = {0};
+    unsigned long long counted = to_gray(src, gray, hist, opts);
+    if (counted == 0) {
+        free(gray);
+        return -1;
+    }
+
+    if (ocr_image_init(bw, w, h, 1) != 0) {
+        free(gray);
+        return -1;
+    }
+
+    int threshold = -1;
+    if (opts->mode == OCR_THRESHOLD_ADAPTIVE) {
+        if (adaptive_threshold(gray, w, h, bw->pixels, &opts->adaptive) != 0) {
+            free(gray);
+            ocr_image_free(bw);
+            return -1;
+        }
+    } else {
+        threshold = opts->mode == OCR_THRESHOLD_OTSU
+            ? ocr_otsu_threshold(hist, counted)
+            : opts->threshold;
+        for (size_t i = 0; i < n; ++i)
+            bw->pixels[i] = (gray[i] >= threshold) ? 255 : 0;
+    }
+    free(gray);
+    if (threshold_out) *threshold_out = threshold;
+    return 0;
+}
+
+int ocr_binarize_runs(const OcrImage *src, OcrImage *bw, RleImage *runs, const OcrBinarizeOptions *opts,
+                      int *threshold_out)
+{
+    if (!runs) return -1;
+    memset(runs, 0, sizeof(*runs));
+    if (ocr_binarize(src, bw, opts, threshold_out) != 0) return -1;
+    if (rle_encode(bw->pixels, bw->width, bw->height, bw->stride, 0, runs) != 0) {
+        ocr_image_free(bw);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bitimg.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct BitWriter {
+    FILE *f;
+    int width;
+    int height;
+    int written;
+    size_t stride;
+    uint8_t *row;
+};
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t bitimg_stride(int width)
+{
+    return (((size_t)width + 63) / 64) * 8;
+}
+
+void bitimg_pack_row(const unsigned char *gray, int width, uint8_t *dst)
+{
+    int x = 0;
+    size_t i = 0;
+    for (; x + 8 <= width; x += 8, ++i) {
+        const unsigned char *g = gray + x;
+        dst[i] = (uint8_t)(((g[0] < 128) << 7) | ((g[1] < 128) << 6) | ((g[2] < 128) << 5) |
+                           ((g[3] < 128) << 4) | ((g[4] < 128) << 3) | ((g[5] < 128) << 2) |
+                           ((g[6] < 128) << 1) | (g[7] < 128));
+    }
+    if (x < width) {
+        uint8_t b = 0;
+        for (int k = 0; x + k < width; ++k)
+            if (gray[x + k] < 128) b |= (uint8_t)(0x80 >> k);
+        dst[i++] = b;
+    }
+    memset(dst + i, 0, bitimg_stride(width) - i);
+}
+
+void bitimg_unpack_row(const uint8_t *src, int width, unsigned char *gray)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        uint8_t b = src[x >> 3];
+        for (int k = 0; k < 8; ++k)
+            gray[x + k] = (b & (0x80 >> k)) ? 0 : 255;
+    }
+    for (; x < width; ++x)
+        gray[x] = (src[x >> 3] & (0x80 >> (x & 7))) ? 0 : 255;
+}
+
+static int parse_header(const unsigned char *h, size_t len, BitImage *img)
+{
+    if (len < BITIMG_HEADER || memcmp(h, BITIMG_MAGIC, 4) != 0) return -1;
+    if (get_u32(h + 4) != BITIMG_VERSION) return -1;
+    uint32_t w = get_u32(h + 8);
+    uint32_t ht = get_u32(h + 12);
+    uint32_t stride = get_u32(h + 16);
+    uint32_t off = get_u32(h + 20);
+    if (w == 0 || ht == 0 || w > 0x7fffffff || ht > 0x7fffffff) return -1;
+    if (stride < bitimg_stride((int)w) || off < BITIMG_HEADER) return -1;
+    if (off > len || (len - off) / stride < ht) return -1;
+    img->width = (int)w;
+    img->height = (int)ht;
+    img->stride = stride;
+    img->bits = h + off;
+    return 0;
+}
+
+int bitimg_is_file(const char *path)
+{
+    unsigned char magic[4];
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    int ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, BITIMG_MAGIC, 4) == 0;
+    fclose(f);
+    return ok;
+}
+
+int bitimg_map(const char *path, BitImage *img)
+{
+    memset(img, 0, sizeof(*img));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < BITIMG_HEADER) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    if (parse_header((const unsigned char *)map, len, img) != 0) {
+        munmap(map, len);
+        memset(img, 0, sizeof(*img));
+        return -1;
+    }
+    img->map = map;
+    img->map_len = len;
+    return 0;
+}
+
+void bitimg_unmap(BitImage *img)
+{
+    if (img && img->map) munmap(img->map, img->map_len);
+    if (img) memset(img, 0, sizeof(*img));
+}
+
+unsigned char *bitimg_load_gray(const char *path, int *width, int *height)
+{
+    BitImage img;
+    if (bitimg_map(path, &img) != 0) return NULL;
+    unsigned char *gray = malloc((size_t)img.width * (size_t)img.height);
+    if (gray) {
+        for (int y = 0; y < img.height; ++y)
+            bitimg_unpack_row(img.bits + (size_t)y * img.stride, img.width,
+                              gray + (size_t)y * (size_t)img.width);
+        *width = img.width;
+        *height = img.height;
+    }
+    bitimg_unmap(&img);
+    return gray;
+}
+
+BitWriter *bitimg_writer_open(const char *path, int width, int height)
+{
+    if (width <= 0 || height <= 0) return NULL;
+    BitWriter *bw = calloc(1, sizeof(BitWriter));
+    if (!bw) return NULL;
+    bw->width = width;
+    bw->height = height;
+    bw->stride = bitimg_stride(width);
+    bw->row = malloc(bw->stride);
+    bw->f = bw->row ? fopen(path, "wb") : NULL;
+    if (!bw->f) {
+        free(bw->row);
+        free(bw);
+        return NULL;
+    }
+
+    unsigned char h[BITIMG_HEADER] = {0};
+    memcpy(h, BITIMG_MAGIC, 4);
+    put_u32(h + 4, BITIMG_VERSION);
+    put_u32(h + 8, (uint32_t)width);
+    put_u32(h + 12, (uint32_t)height);
+    put_u32(h + 16, (uint32_t)bw->stride);
+    put_u32(h + 20, BITIMG_HEADER);
+    if (fwrite(h, 1, sizeof(h), bw->f) != sizeof(h)) {
+        fclose(bw->f);
+        free(bw->row);
+        free(bw);
+        return NULL;
+    }
+    return bw;
+}
+
+int bitimg_writer_rows(BitWriter *bw, const unsigned char *gray, int rows)
+{
+    if (bw->written + rows > bw->height) return -1;
+    for (int y = 0; y < rows; ++y) {
+        bitimg_pack_row(gray + (size_t)y * (size_t)bw->width, bw->width, bw->row);
+        if (fwrite(bw->row, 1, bw->stride, bw->f) != bw->stride) return -1;
+    }
+    bw->written += rows;
+    return 0;
+}
+
+int bitimg_writer_close(BitWriter *bw)
+{
+    if (!bw) return -1;
+    int rc = (bw->written == bw->height) ? 0 : -1;
+    if (fclose(bw->f) != 0) rc = -1;
+    free(bw->row);
+    free(bw);
+    return rc;
+}
+
+int bitimg_write(const char *path, const unsigned char *gray, int width, int height)
+{
+    BitWriter *bw = bitimg_writer_open(path, width, height);
+    if (!bw) return -1;
+    int rc = bitimg_writer_rows(bw, gray, height);
+    if (bitimg_writer_close(bw) != 0) rc = -1;
+    return rc;
+}
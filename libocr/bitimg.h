@@ -0,0 +1,58 @@
+#ifndef BITIMG_H
+#define BITIMG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Image noir/blanc brute a 1 bit par pixel, lisible par mmap sans decompression.
+ * En-tete de 64 octets (petit boutiste) :
+ *   0  "OCB1"    magic
+ *   4  u32       version (1)
+ *   8  u32       largeur
+ *   12 u32       hauteur
+ *   16 u32       stride en octets (multiple de 8)
+ *   20 u32       offset des donnees (64)
+ * puis hauteur lignes de stride octets, bit de poids fort = pixel de gauche,
+ * 1 = encre (noir), 0 = fond (blanc). */
+#define BITIMG_MAGIC "OCB1"
+#define BITIMG_EXT "bw1"
+#define BITIMG_VERSION 1
+#define BITIMG_HEADER 64
+
+typedef struct {
+    int width;
+    int height;
+    size_t stride;
+    const uint8_t *bits;
+    void *map;
+    size_t map_len;
+} BitImage;
+
+static inline int bitimg_get(const BitImage *img, int x, int y)
+{
+    return (img->bits[(size_t)y * img->stride + ((size_t)x >> 3)] >> (7 - (x & 7))) & 1;
+}
+
+size_t bitimg_stride(int width);
+
+/* Lignes 8 bits -> bits : pixel < 128 devient de l'encre. */
+void bitimg_pack_row(const unsigned char *gray, int width, uint8_t *dst);
+/* Bits -> lignes 8 bits : encre = 0, fond = 255. */
+void bitimg_unpack_row(const uint8_t *src, int width, unsigned char *gray);
+
+int bitimg_is_file(const char *path);
+int bitimg_map(const char *path, BitImage *img);
+void bitimg_unmap(BitImage *img);
+
+/* Projette le fichier en memoire et le deplie en niveaux de gris 0/255 (malloc). */
+unsigned char *bitimg_load_gray(const char *path, int *width, int *height);
+
+int bitimg_write(const char *path, const unsigned char *gray, int width, int height);
+
+/* Ecriture incrementale, ligne par ligne, pour les binarisations par bandes. */
+typedef struct BitWriter BitWriter;
+BitWriter *bitimg_writer_open(const char *path, int width, int height);
+int bitimg_writer_rows(BitWriter *bw, const unsigned char *gray, int rows);
+int bitimg_writer_close(BitWriter *bw);
+
+#endif
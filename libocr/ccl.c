@@ -0,0 +1,235 @@
+#include "ccl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Etiquette provisoire : parent dans la foret, statistiques cumulees par segment. */
+typedef struct {
+    int parent;
+    int x0, y0, x1, y1;
+    size_t pixels;
+    double sx, sy;
+} Label;
+
+typedef struct {
+    int xs, xe;
+    int label;
+} Run;
+
+typedef struct {
+    Label *labels;
+    int count;
+    int cap;
+} Forest;
+
+static int forest_new(Forest *f)
+{
+    if (f->count == f->cap) {
+        int cap = f->cap ? f->cap * 2 : 256;
+        Label *tmp = realloc(f->labels, (size_t)cap * sizeof(Label));
+        if (!tmp) return -1;
+        f->labels = tmp;
+        f->cap = cap;
+    }
+    Label *l = &f->labels[f->count];
+    memset(l, 0, sizeof(*l));
+    l->parent = f->count;
+    l->x0 = l->y0 = 0x7fffffff;
+    l->x1 = l->y1 = -1;
+    return f->count++;
+}
+
+static int find_root(Label *labels, int i)
+{
+    int r = i;
+    while (labels[r].parent != r) r = labels[r].parent;
+    while (labels[i].parent != r) {
+        int next = labels[i].parent;
+        labels[i].parent = r;
+        i = next;
+    }
+    return r;
+}
+
+/* La plus petite etiquette reste la racine : c'est celle du premier segment rencontre. */
+static int unite(Label *labels, int a, int b)
+{
+    a = find_root(labels, a);
+    b = find_root(labels, b);
+    if (a == b) return a;
+    if (a < b) {
+        labels[b].parent = a;
+        return a;
+    }
+    labels[a].parent = b;
+    return b;
+}
+
+static void add_run(Label *l, int xs, int xe, int y)
+{
+    size_t n = (size_t)(xe - xs + 1);
+    if (xs < l->x0) l->x0 = xs;
+    if (xe > l->x1) l->x1 = xe;
+    if (y < l->y0) l->y0 = y;
+    if (y > l->y1) l->y1 = y;
+    l->pixels += n;
+    l->sx += (double)(xs + xe) * 0.5 * (double)n;
+    l->sy += (double)y * (double)n;
+}
+
+static void merge_stats(Label *dst, const Label *src)
+{
+    if (src->x0 < dst->x0) dst->x0 = src->x0;
+    if (src->x1 > dst->x1) dst->x1 = src->x1;
+    if (src->y0 < dst->y0) dst->y0 = src->y0;
+    if (src->y1 > dst->y1) dst->y1 = src->y1;
+    dst->pixels += src->pixels;
+    dst->sx += src->sx;
+    dst->sy += src->sy;
+}
+
+/* Etiquetage ligne par ligne : prev garde les segments etiquetes de la ligne precedente. */
+typedef struct {
+    Run *prev, *cur;
+    int nprev;
+    int reach;
+    Forest f;
+} Labeller;
+
+static int labeller_init(Labeller *L, int w, int connectivity)
+{
+    memset(L, 0, sizeof(*L));
+    const size_t max_runs = (size_t)w / 2 + 1;
+    L->reach = connectivity == 8 ? 1 : 0;
+    L->prev = malloc(max_runs * sizeof(Run));
+    L->cur = malloc(max_runs * sizeof(Run));
+    if (!L->prev || !L->cur) {
+        free(L->prev);
+        free(L->cur);
+        return -1;
+    }
+    return 0;
+}
+
+static int labeller_row(Labeller *L, const RleRun *runs, int n, int y)
+{
+    const int reach = L->reach;
+    int j = 0;
+    for (int i = 0; i < n; ++i) {
+        const int xs = runs[i].xs, xe = runs[i].xe;
+        /* segments de la ligne precedente qui touchent [xs - reach, xe + reach] ; j ne recule
+         * jamais : un segment deja depasse ne peut pas toucher les suivants */
+        while (j < L->nprev && L->prev[j].xe < xs - reach) ++j;
+        int label = -1;
+        for (int k = j; k < L->nprev && L->prev[k].xs <= xe + reach; ++k)
+            label = label < 0 ? find_root(L->f.labels, L->prev[k].label)
+                              : unite(L->f.labels, label, L->prev[k].label);
+        if (label < 0 && (label = forest_new(&L->f)) < 0) return -1;
+        add_run(&L->f.labels[label], xs, xe, y);
+        L->cur[i] = (Run){ xs, xe, label };
+    }
+    Run *t = L->prev;
+    L->prev = L->cur;
+    L->cur = t;
+    L->nprev = n;
+    return 0;
+}
+
+/* deuxieme passe : chaque etiquette verse ses statistiques dans sa racine */
+static int labeller_finish(Labeller *L, CclSet *out)
+{
+    free(L->prev);
+    free(L->cur);
+    Forest *f = &L->f;
+    size_t roots = 0;
+    for (int i = 0; i < f->count; ++i) {
+        int r = find_root(f->labels, i);
+        if (r != i) merge_stats(&f->labels[r], &f->labels[i]);
+        else roots++;
+    }
+    out->items = malloc((roots ? roots : 1) * sizeof(CclComponent));
+    if (!out->items) {
+        free(f->labels);
+        return -1;
+    }
+    out->cap = roots;
+    for (int i = 0; i < f->count; ++i) {
+        const Label *l = &f->labels[i];
+        if (l->parent != i) continue;
+        CclComponent *c = &out->items[out->count++];
+        c->x0 = l->x0;
+        c->y0 = l->y0;
+        c->x1 = l->x1;
+        c->y1 = l->y1;
+        c->pixels = l->pixels;
+        c->xc = l->sx / (double)l->pixels;
+        c->yc = l->sy / (double)l->pixels;
+    }
+    free(f->labels);
+    return 0;
+}
+
+static void labeller_abort(Labeller *L)
+{
+    free(L->prev);
+    free(L->cur);
+    free(L->f.labels);
+}
+
+int ccl_label(const unsigned char *pix, int w, int h, size_t stride, int ink_max, int connectivity,
+              CclSet *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!pix || w <= 0 || h <= 0 || (connectivity != 4 && connectivity != 8)) return -1;
+
+    Labeller L;
+    RleRun *runs = malloc(((size_t)w / 2 + 1) * sizeof(RleRun));
+    if (!runs || labeller_init(&L, w, connectivity) != 0) {
+        free(runs);
+        return -1;
+    }
+    for (int y = 0; y < h; ++y) {
+        const unsigned char *row = pix + (size_t)y * stride;
+        int n = 0;
+        for (int x = 0; x < w;) {
+            if (row[x] > ink_max) {
+                ++x;
+                continue;
+            }
+            int xs = x;
+            while (x < w && row[x] <= ink_max) ++x;
+            runs[n++] = (RleRun){ xs, x - 1 };
+        }
+        if (labeller_row(&L, runs, n, y) != 0) {
+            free(runs);
+            labeller_abort(&L);
+            return -1;
+        }
+    }
+    free(runs);
+    return labeller_finish(&L, out);
+}
+
+int ccl_label_runs(const RleImage *img, int connectivity, CclSet *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!img || img->width <= 0 || img->height <= 0 || (connectivity != 4 && connectivity != 8)) return -1;
+
+    Labeller L;
+    if (labeller_init(&L, img->width, connectivity) != 0) return -1;
+    for (int y = 0; y < img->height; ++y) {
+        const size_t k = img->row[y];
+        if (labeller_row(&L, img->runs + k, (int)(img->row[y + 1] - k), y) != 0) {
+            labeller_abort(&L);
+            return -1;
+        }
+    }
+    return labeller_finish(&L, out);
+}
+
+void ccl_free(CclSet *set)
+{
+    if (!set) return;
+    free(set->items);
+    memset(set, 0, sizeof(*set));
+}
@@ -0,0 +1,33 @@
+#ifndef CCL_H
+#define CCL_H
+
+#include <stddef.h>
+
+#include "rle.h"
+
+/* Composantes connexes en deux passes par segments (union-find sur les segments
+ * d'encre de chaque ligne). Les lignes sont lues une seule fois, dans l'ordre, et la
+ * memoire de travail depend du nombre de segments, pas du nombre de pixels. */
+
+typedef struct {
+    int x0, y0, x1, y1; /* boite englobante, bornes incluses */
+    size_t pixels;
+    double xc, yc;      /* centroide des pixels */
+} CclComponent;
+
+typedef struct {
+    CclComponent *items;
+    size_t count;
+    size_t cap;
+} CclSet;
+
+/* Pixel d'encre : valeur <= ink_max. connectivity = 4 ou 8.
+ * Les composantes sortent dans l'ordre de leur premier pixel en balayage ligne par
+ * ligne, comme un remplissage par pile lance depuis chaque pixel non visite. */
+int ccl_label(const unsigned char *pix, int w, int h, size_t stride, int ink_max, int connectivity,
+              CclSet *out);
+/* Meme etiquetage sur des segments deja codes (rle.h) : aucun pixel n'est relu. */
+int ccl_label_runs(const RleImage *img, int connectivity, CclSet *out);
+void ccl_free(CclSet *set);
+
+#endif
@@ -0,0 +1,982 @@
+#include "dense.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DENSE_X86 1
+#include <immintrin.h>
+#endif
+
+/* Reference scalaire : sommes dans l'ordre, expf de la libm. */
+
+static void gemv_scalar(const float *A, size_t lda, int rows, int cols, const float *x, float *y)
+{
+    for (int r = 0; r < rows; ++r) {
+        const float *a = A + (size_t)r * lda;
+        float s = 0.0f;
+        for (int c = 0; c < cols; ++c) s += a[c] * x[c];
+        y[r] = s;
+    }
+}
+
+static void gemm_nt_scalar(const float *X, size_t ldx, int n, const float *W, size_t ldw, int m, int k,
+                           float *C, size_t ldc)
+{
+    for (int i = 0; i < n; ++i)
+        gemv_scalar(W, ldw, m, k, X + (size_t)i * ldx, C + (size_t)i * ldc);
+}
+
+static void bias_sigmoid_scalar(float *y, const float *b, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        float v = b ? y[i] + b[i] : y[i];
+        y[i] = 1.0f / (1.0f + expf(-v));
+    }
+}
+
+static void ger_scalar(float *A, size_t lda, int rows, int cols, const float *alpha, const float *x)
+{
+    for (int r = 0; r < rows; ++r) {
+        float *a = A + (size_t)r * lda;
+        for (int c = 0; c < cols; ++c) a[c] += alpha[r] * x[c];
+    }
+}
+
+static void sub_rows_scalar(const float *A, size_t lda, const uint16_t *idx, int nidx, const float *init,
+                            float *y, int n)
+{
+    for (int j = 0; j < n; ++j) {
+        float s = init[j];
+        for (int k = 0; k < nidx; ++k) s -= A[(size_t)idx[k] * lda + j];
+        y[j] = s;
+    }
+}
+
+static void sum_rows_i8_scalar(const int8_t *A, size_t lda, const uint16_t *idx, int nidx, int32_t *sum, int n)
+{
+    for (int j = 0; j < n; ++j) {
+        int32_t s = 0;
+        for (int k = 0; k < nidx; ++k) s += A[(size_t)idx[k] * lda + j];
+        sum[j] = s;
+    }
+}
+
+static void gemm_u8i8_scalar(const uint8_t *X, size_t ldx, int n, const int8_t *W, size_t ldw, int m, int k,
+                             int32_t *C, size_t ldc)
+{
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < m; ++j) {
+            const uint8_t *x = X + (size_t)i * ldx;
+            const int8_t *w = W + (size_t)j * ldw;
+            int32_t s = 0;
+            for (int t = 0; t < k; ++t) s += x[t] * w[t];
+            C[(size_t)i * ldc + j] = s;
+        }
+}
+
+static const DenseOps ops_scalar = {
+    gemv_scalar, gemm_nt_scalar, bias_sigmoid_scalar, ger_scalar, sub_rows_scalar,
+    sum_rows_i8_scalar, gemm_u8i8_scalar
+};
+
+/* gemv et gemm_nt de chaque jeu reposent sur son dot4 : 4 produits scalaires qui partagent
+ * les chargements du vecteur commun (x pour gemv, une ligne de W pour gemm_nt). */
+typedef void (*Dot4Fn)(const float *const p[4], const float *v, int k, float *out);
+
+static void gemv_dot4(Dot4Fn dot4, const float *A, size_t lda, int rows, int cols, const float *x, float *y)
+{
+    int r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const float *p[4] = { A + (size_t)r * lda, A + (size_t)(r + 1) * lda, A + (size_t)(r + 2) * lda,
+                              A + (size_t)(r + 3) * lda };
+        dot4(p, x, cols, y + r);
+    }
+    for (; r < rows; ++r) {
+        const float *a = A + (size_t)r * lda;
+        const float *p[4] = { a, a, a, a };
+        float s[4];
+        dot4(p, x, cols, s);
+        y[r] = s[0];
+    }
+}
+
+static void gemm_nt_dot4(Dot4Fn dot4, const float *X, size_t ldx, int n, const float *W, size_t ldw, int m,
+                         int k, float *C, size_t ldc)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float *p[4] = { X + (size_t)i * ldx, X + (size_t)(i + 1) * ldx, X + (size_t)(i + 2) * ldx,
+                              X + (size_t)(i + 3) * ldx };
+        for (int j = 0; j < m; ++j) {
+            float s[4];
+            dot4(p, W + (size_t)j * ldw, k, s);
+            for (int q = 0; q < 4; ++q) C[(size_t)(i + q) * ldc + j] = s[q];
+        }
+    }
+    for (; i < n; ++i) gemv_dot4(dot4, W, ldw, m, k, X + (size_t)i * ldx, C + (size_t)i * ldc);
+}
+
+/* Meme schema en int8 : 4 lignes de X partagent chaque morceau de ligne de W ; les lignes
+ * manquantes du dernier groupe repetent la derniere. */
+typedef void (*Dot4I8Fn)(const uint8_t *const x[4], const int8_t *w, int k, int32_t *out);
+
+static void gemm_u8i8_dot4(Dot4I8Fn dot4, const uint8_t *X, size_t ldx, int n, const int8_t *W, size_t ldw,
+                           int m, int k, int32_t *C, size_t ldc)
+{
+    for (int i = 0; i < n; i += 4) {
+        const uint8_t *x[4];
+        for (int q = 0; q < 4; ++q) x[q] = X + (size_t)(i + q < n ? i + q : n - 1) * ldx;
+        for (int j = 0; j < m; ++j) {
+            int32_t s[4];
+            dot4(x, W + (size_t)j * ldw, k, s);
+            for (int q = 0; q < 4 && i + q < n; ++q) C[(size_t)(i + q) * ldc + j] = s[q];
+        }
+    }
+}
+
+/* sum_rows_i8 accumule sur 16 bits (|somme| <= 256 x 128) et verse en 32 bits tous les
+ * I8_BLOC pixels. */
+#define I8_BLOC 256
+
+#ifdef DENSE_X86
+
+/* exp(x) en simple precision (polynome de Cephes) : x = n ln2 + r, |r| <= ln2 / 2,
+ * exp(r) en degre 7 puis 2^n par l'exposant. */
+#define EXP_HI 88.3762626647949f
+#define EXP_LO -88.3762626647949f
+#define EXP_LOG2E 1.44269504088896341f
+#define EXP_C1 0.693359375f
+#define EXP_C2 -2.12194440e-4f
+#define EXP_P0 1.9875691500e-4f
+#define EXP_P1 1.3981999507e-3f
+#define EXP_P2 8.3334519073e-3f
+#define EXP_P3 4.1665795894e-2f
+#define EXP_P4 1.6666665459e-1f
+#define EXP_P5 5.0000001201e-1f
+
+/* ---------- SSE2 ---------- */
+
+__attribute__((target("sse2")))
+static __m128 exp_sse2(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_LO)), _mm_set1_ps(EXP_HI));
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E)), _mm_set1_ps(0.5f));
+    /* floor : troncature, moins 1 si elle a arrondi vers le haut */
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    fx = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, fx), _mm_set1_ps(1.0f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C1)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C2)));
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(EXP_P0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P5));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), _mm_set1_ps(1.0f));
+    __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(y, _mm_castsi128_ps(e));
+}
+
+__attribute__((target("sse2")))
+static void dot4_sse2(const float *const p[4], const float *v, int k, float *out)
+{
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= k; i += 4) {
+        __m128 x = _mm_loadu_ps(v + i);
+        a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(p[0] + i), x));
+        a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(p[1] + i), x));
+        a2 = _mm_add_ps(a2, _mm_mul_ps(_mm_loadu_ps(p[2] + i), x));
+        a3 = _mm_add_ps(a3, _mm_mul_ps(_mm_loadu_ps(p[3] + i), x));
+    }
+    _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+    float s[4];
+    _mm_storeu_ps(s, _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)));
+    for (; i < k; ++i)
+        for (int q = 0; q < 4; ++q) s[q] += p[q][i] * v[i];
+    for (int q = 0; q < 4; ++q) out[q] = s[q];
+}
+
+static void gemv_sse2(const float *A, size_t lda, int rows, int cols, const float *x, float *y)
+{
+    gemv_dot4(dot4_sse2, A, lda, rows, cols, x, y);
+}
+
+static void gemm_nt_sse2(const float *X, size_t ldx, int n, const float *W, size_t ldw, int m, int k,
+                         float *C, size_t ldc)
+{
+    gemm_nt_dot4(dot4_sse2, X, ldx, n, W, ldw, m, k, C, ldc);
+}
+
+__attribute__((target("sse2")))
+static void bias_sigmoid_sse2(float *y, const float *b, int n)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(y + i);
+        if (b) v = _mm_add_ps(v, _mm_loadu_ps(b + i));
+        __m128 e = exp_sse2(_mm_sub_ps(_mm_setzero_ps(), v));
+        _mm_storeu_ps(y + i, _mm_div_ps(one, _mm_add_ps(one, e)));
+    }
+    bias_sigmoid_scalar(y + i, b ? b + i : NULL, n - i);
+}
+
+__attribute__((target("sse2")))
+static void ger_sse2(float *A, size_t lda, int rows, int cols, const float *alpha, const float *x)
+{
+    for (int r = 0; r < rows; ++r) {
+        float *a = A + (size_t)r * lda;
+        const __m128 s = _mm_set1_ps(alpha[r]);
+        int c = 0;
+        for (; c + 4 <= cols; c += 4)
+            _mm_storeu_ps(a + c, _mm_add_ps(_mm_loadu_ps(a + c), _mm_mul_ps(s, _mm_loadu_ps(x + c))));
+        for (; c < cols; ++c) a[c] += alpha[r] * x[c];
+    }
+}
+
+/* Tranches de 16 sorties gardees en registres pendant tout le parcours de idx. */
+__attribute__((target("sse2")))
+static void sub_rows_sse2(const float *A, size_t lda, const uint16_t *idx, int nidx, const float *init,
+                          float *y, int n)
+{
+    int j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m128 a0 = _mm_loadu_ps(init + j), a1 = _mm_loadu_ps(init + j + 4);
+        __m128 a2 = _mm_loadu_ps(init + j + 8), a3 = _mm_loadu_ps(init + j + 12);
+        for (int k = 0; k < nidx; ++k) {
+            const float *w = A + (size_t)idx[k] * lda + j;
+            a0 = _mm_sub_ps(a0, _mm_loadu_ps(w));
+            a1 = _mm_sub_ps(a1, _mm_loadu_ps(w + 4));
+            a2 = _mm_sub_ps(a2, _mm_loadu_ps(w + 8));
+            a3 = _mm_sub_ps(a3, _mm_loadu_ps(w + 12));
+        }
+        _mm_storeu_ps(y + j, a0);
+        _mm_storeu_ps(y + j + 4, a1);
+        _mm_storeu_ps(y + j + 8, a2);
+        _mm_storeu_ps(y + j + 12, a3);
+    }
+    for (; j + 4 <= n; j += 4) {
+        __m128 a = _mm_loadu_ps(init + j);
+        for (int k = 0; k < nidx; ++k) a = _mm_sub_ps(a, _mm_loadu_ps(A + (size_t)idx[k] * lda + j));
+        _mm_storeu_ps(y + j, a);
+    }
+    if (j < n) sub_rows_scalar(A + j, lda, idx, nidx, init + j, y + j, n - j);
+}
+
+/* 8 sommes 16 bits ajoutees a s[0..7] */
+__attribute__((target("sse2")))
+static inline void verser_sse2(__m128i a, int32_t *s)
+{
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16);
+    _mm_storeu_si128((__m128i *)s, _mm_add_epi32(_mm_loadu_si128((const __m128i *)s), lo));
+    _mm_storeu_si128((__m128i *)(s + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(s + 4)), hi));
+}
+
+/* int8 -> int16 avec le signe : chaque octet double puis decale de 8 */
+#define I8_LO(v) _mm_srai_epi16(_mm_unpacklo_epi8((v), (v)), 8)
+#define I8_HI(v) _mm_srai_epi16(_mm_unpackhi_epi8((v), (v)), 8)
+
+__attribute__((target("sse2")))
+static void sum_rows_i8_sse2(const int8_t *A, size_t lda, const uint16_t *idx, int nidx, int32_t *sum, int n)
+{
+    int j = 0;
+    for (; j + 32 <= n; j += 32) {
+        for (int q = 0; q < 32; ++q) sum[j + q] = 0;
+        for (int k0 = 0; k0 < nidx; k0 += I8_BLOC) {
+            const int k1 = nidx - k0 < I8_BLOC ? nidx : k0 + I8_BLOC;
+            __m128i a0 = _mm_setzero_si128(), a1 = _mm_setzero_si128();
+            __m128i a2 = _mm_setzero_si128(), a3 = _mm_setzero_si128();
+            for (int k = k0; k < k1; ++k) {
+                const int8_t *w = A + (size_t)idx[k] * lda + j;
+                __m128i v0 = _mm_loadu_si128((const __m128i *)w), v1 = _mm_loadu_si128((const __m128i *)(w + 16));
+                a0 = _mm_add_epi16(a0, I8_LO(v0));
+                a1 = _mm_add_epi16(a1, I8_HI(v0));
+                a2 = _mm_add_epi16(a2, I8_LO(v1));
+                a3 = _mm_add_epi16(a3, I8_HI(v1));
+            }
+            verser_sse2(a0, sum + j);
+            verser_sse2(a1, sum + j + 8);
+            verser_sse2(a2, sum + j + 16);
+            verser_sse2(a3, sum + j + 24);
+        }
+    }
+    if (j < n) sum_rows_i8_scalar(A + j, lda, idx, nidx, sum + j, n - j);
+}
+
+__attribute__((target("sse2")))
+static void dot4_u8i8_sse2(const uint8_t *const x[4], const int8_t *w, int k, int32_t *out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a[4] = { zero, zero, zero, zero };
+    int i = 0;
+    for (; i + 16 <= k; i += 16) {
+        __m128i wv = _mm_loadu_si128((const __m128i *)(w + i));
+        __m128i wl = I8_LO(wv), wh = I8_HI(wv);
+        for (int q = 0; q < 4; ++q) {
+            __m128i xv = _mm_loadu_si128((const __m128i *)(x[q] + i));
+            a[q] = _mm_add_epi32(a[q], _mm_madd_epi16(_mm_unpacklo_epi8(xv, zero), wl));
+            a[q] = _mm_add_epi32(a[q], _mm_madd_epi16(_mm_unpackhi_epi8(xv, zero), wh));
+        }
+    }
+    for (int q = 0; q < 4; ++q) {
+        int32_t t[4];
+        _mm_storeu_si128((__m128i *)t, a[q]);
+        int32_t s = (t[0] + t[1]) + (t[2] + t[3]);
+        for (int r = i; r < k; ++r) s += x[q][r] * w[r];
+        out[q] = s;
+    }
+}
+
+static void gemm_u8i8_sse2(const uint8_t *X, size_t ldx, int n, const int8_t *W, size_t ldw, int m, int k,
+                           int32_t *C, size_t ldc)
+{
+    gemm_u8i8_dot4(dot4_u8i8_sse2, X, ldx, n, W, ldw, m, k, C, ldc);
+}
+
+static const DenseOps ops_sse2 = {
+    gemv_sse2, gemm_nt_sse2, bias_sigmoid_sse2, ger_sse2, sub_rows_sse2,
+    sum_rows_i8_sse2, gemm_u8i8_sse2
+};
+
+/* ---------- AVX2 + FMA ---------- */
+
+__attribute__((target("avx2,fma")))
+static __m256 exp_avx2(__m256 x)
+{
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_LO)), _mm256_set1_ps(EXP_HI));
+    __m256 fx = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(EXP_LOG2E), _mm256_set1_ps(0.5f)));
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(EXP_C1), x);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(EXP_C2), x);
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(EXP_P0);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P2));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P3));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P4));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P5));
+    y = _mm256_add_ps(_mm256_fmadd_ps(y, z, x), _mm256_set1_ps(1.0f));
+    __m256i e = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(e));
+}
+
+__attribute__((target("avx2,fma")))
+static void dot4_avx2(const float *const p[4], const float *v, int k, float *out)
+{
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= k; i += 8) {
+        __m256 x = _mm256_loadu_ps(v + i);
+        a0 = _mm256_fmadd_ps(_mm256_loadu_ps(p[0] + i), x, a0);
+        a1 = _mm256_fmadd_ps(_mm256_loadu_ps(p[1] + i), x, a1);
+        a2 = _mm256_fmadd_ps(_mm256_loadu_ps(p[2] + i), x, a2);
+        a3 = _mm256_fmadd_ps(_mm256_loadu_ps(p[3] + i), x, a3);
+    }
+    /* deux hadd : chaque moitie tient les sommes partielles des 4 produits */
+    __m256 h = _mm256_hadd_ps(_mm256_hadd_ps(a0, a1), _mm256_hadd_ps(a2, a3));
+    float s[4];
+    _mm_storeu_ps(s, _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1)));
+    for (; i < k; ++i)
+        for (int q = 0; q < 4; ++q) s[q] += p[q][i] * v[i];
+    for (int q = 0; q < 4; ++q) out[q] = s[q];
+}
+
+static void gemv_avx2(const float *A, size_t lda, int rows, int cols, const float *x, float *y)
+{
+    gemv_dot4(dot4_avx2, A, lda, rows, cols, x, y);
+}
+
+static void gemm_nt_avx2(const float *X, size_t ldx, int n, const float *W, size_t ldw, int m, int k,
+                         float *C, size_t ldc)
+{
+    gemm_nt_dot4(dot4_avx2, X, ldx, n, W, ldw, m, k, C, ldc);
+}
+
+__attribute__((target("avx2,fma")))
+static void bias_sigmoid_avx2(float *y, const float *b, int n)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(y + i);
+        if (b) v = _mm256_add_ps(v, _mm256_loadu_ps(b + i));
+        __m256 e = exp_avx2(_mm256_sub_ps(_mm256_setzero_ps(), v));
+        _mm256_storeu_ps(y + i, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+    }
+    bias_sigmoid_scalar(y + i, b ? b + i : NULL, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void ger_avx2(float *A, size_t lda, int rows, int cols, const float *alpha, const float *x)
+{
+    for (int r = 0; r < rows; ++r) {
+        float *a = A + (size_t)r * lda;
+        const __m256 s = _mm256_set1_ps(alpha[r]);
+        int c = 0;
+        for (; c + 8 <= cols; c += 8)
+            _mm256_storeu_ps(a + c, _mm256_fmadd_ps(s, _mm256_loadu_ps(x + c), _mm256_loadu_ps(a + c)));
+        for (; c < cols; ++c) a[c] += alpha[r] * x[c];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void sub_rows_avx2(const float *A, size_t lda, const uint16_t *idx, int nidx, const float *init,
+                          float *y, int n)
+{
+    int j = 0;
+    for (; j + 32 <= n; j += 32) {
+        __m256 a0 = _mm256_loadu_ps(init + j), a1 = _mm256_loadu_ps(init + j + 8);
+        __m256 a2 = _mm256_loadu_ps(init + j + 16), a3 = _mm256_loadu_ps(init + j + 24);
+        for (int k = 0; k < nidx; ++k) {
+            const float *w = A + (size_t)idx[k] * lda + j;
+            a0 = _mm256_sub_ps(a0, _mm256_loadu_ps(w));
+            a1 = _mm256_sub_ps(a1, _mm256_loadu_ps(w + 8));
+            a2 = _mm256_sub_ps(a2, _mm256_loadu_ps(w + 16));
+            a3 = _mm256_sub_ps(a3, _mm256_loadu_ps(w + 24));
+        }
+        _mm256_storeu_ps(y + j, a0);
+        _mm256_storeu_ps(y + j + 8, a1);
+        _mm256_storeu_ps(y + j + 16, a2);
+        _mm256_storeu_ps(y + j + 24, a3);
+    }
+    for (; j + 8 <= n; j += 8) {
+        __m256 a = _mm256_loadu_ps(init + j);
+        for (int k = 0; k < nidx; ++k) a = _mm256_sub_ps(a, _mm256_loadu_ps(A + (size_t)idx[k] * lda + j));
+        _mm256_storeu_ps(y + j, a);
+    }
+    if (j < n) sub_rows_scalar(A + j, lda, idx, nidx, init + j, y + j, n - j);
+}
+
+__attribute__((target("avx2")))
+static inline void verser_avx2(__m256i a, int32_t *s)
+{
+    __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(a));
+    __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(a, 1));
+    _mm256_storeu_si256((__m256i *)s, _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)s), lo));
+    _mm256_storeu_si256((__m256i *)(s + 8), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(s + 8)), hi));
+}
+
+/* nv tranches de 16 colonnes (nv <= 4) gardees en registres ; nv est une constante
+ * apres inlining. */
+__attribute__((target("avx2"), always_inline))
+static inline void sum_bloc_avx2(const int8_t *A, size_t lda, const uint16_t *idx, int nidx, int32_t *sum,
+                                 const int nv)
+{
+    for (int q = 0; q < 16 * nv; ++q) sum[q] = 0;
+    for (int k0 = 0; k0 < nidx; k0 += I8_BLOC) {
+        const int k1 = nidx - k0 < I8_BLOC ? nidx : k0 + I8_BLOC;
+        __m256i a[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(),
+                         _mm256_setzero_si256() };
+        for (int k = k0; k < k1; ++k) {
+            const int8_t *w = A + (size_t)idx[k] * lda;
+            for (int v = 0; v < nv; ++v)
+                a[v] = _mm256_add_epi16(a[v], _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(w + 16 * v))));
+        }
+        for (int v = 0; v < nv; ++v) verser_avx2(a[v], sum + 16 * v);
+    }
+}
+
+__attribute__((target("avx2")))
+static void sum_rows_i8_avx2(const int8_t *A, size_t lda, const uint16_t *idx, int nidx, int32_t *sum, int n)
+{
+    int j = 0;
+    for (; j + 64 <= n; j += 64) sum_bloc_avx2(A + j, lda, idx, nidx, sum + j, 4);
+    for (; j + 32 <= n; j += 32) sum_bloc_avx2(A + j, lda, idx, nidx, sum + j, 2);
+    for (; j + 16 <= n; j += 16) sum_bloc_avx2(A + j, lda, idx, nidx, sum + j, 1);
+    if (j < n) sum_rows_i8_scalar(A + j, lda, idx, nidx, sum + j, n - j);
+}
+
+/* maddubs : paires u8 x s8 sommees sur 16 bits, puis madd par 1 sur 32 bits */
+__attribute__((target("avx2")))
+static void dot4_u8i8_avx2(const uint8_t *const x[4], const int8_t *w, int k, int32_t *out)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+    __m256i a2 = _mm256_setzero_si256(), a3 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= k; i += 32) {
+        __m256i wv = _mm256_loadu_si256((const __m256i *)(w + i));
+        a0 = _mm256_add_epi32(a0, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x[0] + i)), wv), ones));
+        a1 = _mm256_add_epi32(a1, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x[1] + i)), wv), ones));
+        a2 = _mm256_add_epi32(a2, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x[2] + i)), wv), ones));
+        a3 = _mm256_add_epi32(a3, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(x[3] + i)), wv), ones));
+    }
+    if (k - i >= 4) {
+        /* reste par mots de 4 octets, chargements masques (rien n'est lu apres k) */
+        const int mots = (k - i) / 4;
+        const __m256i mk = _mm256_cmpgt_epi32(_mm256_set1_epi32(mots), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256i wv = _mm256_maskload_epi32((const int *)(w + i), mk);
+        a0 = _mm256_add_epi32(a0, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_maskload_epi32((const int *)(x[0] + i), mk), wv), ones));
+        a1 = _mm256_add_epi32(a1, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_maskload_epi32((const int *)(x[1] + i), mk), wv), ones));
+        a2 = _mm256_add_epi32(a2, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_maskload_epi32((const int *)(x[2] + i), mk), wv), ones));
+        a3 = _mm256_add_epi32(a3, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_maskload_epi32((const int *)(x[3] + i), mk), wv), ones));
+        i += 4 * mots;
+    }
+    __m256i h = _mm256_hadd_epi32(_mm256_hadd_epi32(a0, a1), _mm256_hadd_epi32(a2, a3));
+    int32_t s[4];
+    _mm_storeu_si128((__m128i *)s, _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1)));
+    for (; i < k; ++i)
+        for (int q = 0; q < 4; ++q) s[q] += x[q][i] * w[i];
+    for (int q = 0; q < 4; ++q) out[q] = s[q];
+}
+
+static void gemm_u8i8_avx2(const uint8_t *X, size_t ldx, int n, const int8_t *W, size_t ldw, int m, int k,
+                           int32_t *C, size_t ldc)
+{
+    gemm_u8i8_dot4(dot4_u8i8_avx2, X, ldx, n, W, ldw, m, k, C, ldc);
+}
+
+static const DenseOps ops_avx2 = {
+    gemv_avx2, gemm_nt_avx2, bias_sigmoid_avx2, ger_avx2, sub_rows_avx2,
+    sum_rows_i8_avx2, gemm_u8i8_avx2
+};
+
+/* ---------- AVX-512 : les fins de ligne passent par des chargements masques ---------- */
+
+#define TAIL16(r) ((__mmask16)((1u << (r)) - 1u))
+
+__attribute__((target("avx512f")))
+static __m512 exp_avx512(__m512 x)
+{
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(EXP_LO)), _mm512_set1_ps(EXP_HI));
+    __m512 fx = _mm512_roundscale_ps(_mm512_fmadd_ps(x, _mm512_set1_ps(EXP_LOG2E), _mm512_set1_ps(0.5f)),
+                                     _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(EXP_C1), x);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(EXP_C2), x);
+    __m512 z = _mm512_mul_ps(x, x);
+    __m512 y = _mm512_set1_ps(EXP_P0);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(EXP_P1));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(EXP_P2));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(EXP_P3));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(EXP_P4));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(EXP_P5));
+    y = _mm512_add_ps(_mm512_fmadd_ps(y, z, x), _mm512_set1_ps(1.0f));
+    __m512i e = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvttps_epi32(fx), _mm512_set1_epi32(127)), 23);
+    return _mm512_mul_ps(y, _mm512_castsi512_ps(e));
+}
+
+__attribute__((target("avx512f")))
+static void dot4_avx512(const float *const p[4], const float *v, int k, float *out)
+{
+    __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+    __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= k; i += 16) {
+        __m512 x = _mm512_loadu_ps(v + i);
+        a0 = _mm512_fmadd_ps(_mm512_loadu_ps(p[0] + i), x, a0);
+        a1 = _mm512_fmadd_ps(_mm512_loadu_ps(p[1] + i), x, a1);
+        a2 = _mm512_fmadd_ps(_mm512_loadu_ps(p[2] + i), x, a2);
+        a3 = _mm512_fmadd_ps(_mm512_loadu_ps(p[3] + i), x, a3);
+    }
+    if (i < k) {
+        const __mmask16 mk = TAIL16(k - i);
+        __m512 x = _mm512_maskz_loadu_ps(mk, v + i);
+        a0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, p[0] + i), x, a0);
+        a1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, p[1] + i), x, a1);
+        a2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, p[2] + i), x, a2);
+        a3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mk, p[3] + i), x, a3);
+    }
+    out[0] = _mm512_reduce_add_ps(a0);
+    out[1] = _mm512_reduce_add_ps(a1);
+    out[2] = _mm512_reduce_add_ps(a2);
+    out[3] = _mm512_reduce_add_ps(a3);
+}
+
+static void gemv_avx512(const float *A, size_t lda, int rows, int cols, const float *x, float *y)
+{
+    gemv_dot4(dot4_avx512, A, lda, rows, cols, x, y);
+}
+
+static void gemm_nt_avx512(const float *X, size_t ldx, int n, const float *W, size_t ldw, int m, int k,
+                           float *C, size_t ldc)
+{
+    gemm_nt_dot4(dot4_avx512, X, ldx, n, W, ldw, m, k, C, ldc);
+}
+
+__attribute__((target("avx512f")))
+static void bias_sigmoid_avx512(float *y, const float *b, int n)
+{
+    const __m512 one = _mm512_set1_ps(1.0f);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 mk = n - i >= 16 ? (__mmask16)0xFFFF : TAIL16(n - i);
+        __m512 v = _mm512_maskz_loadu_ps(mk, y + i);
+        if (b) v = _mm512_add_ps(v, _mm512_maskz_loadu_ps(mk, b + i));
+        __m512 e = exp_avx512(_mm512_sub_ps(_mm512_setzero_ps(), v));
+        _mm512_mask_storeu_ps(y + i, mk, _mm512_div_ps(one, _mm512_add_ps(one, e)));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void ger_avx512(float *A, size_t lda, int rows, int cols, const float *alpha, const float *x)
+{
+    for (int r = 0; r < rows; ++r) {
+        float *a = A + (size_t)r * lda;
+        const __m512 s = _mm512_set1_ps(alpha[r]);
+        for (int c = 0; c < cols; c += 16) {
+            const __mmask16 mk = cols - c >= 16 ? (__mmask16)0xFFFF : TAIL16(cols - c);
+            __m512 v = _mm512_fmadd_ps(s, _mm512_maskz_loadu_ps(mk, x + c), _mm512_maskz_loadu_ps(mk, a + c));
+            _mm512_mask_storeu_ps(a + c, mk, v);
+        }
+    }
+}
+
+/* Tranches de 64 sorties, puis 32 : une couche cachee de 96 se fait en deux parcours. */
+__attribute__((target("avx512f")))
+static void sub_rows_avx512(const float *A, size_t lda, const uint16_t *idx, int nidx, const float *init,
+                            float *y, int n)
+{
+    int j = 0;
+    for (; j + 64 <= n; j += 64) {
+        __m512 a0 = _mm512_loadu_ps(init + j), a1 = _mm512_loadu_ps(init + j + 16);
+        __m512 a2 = _mm512_loadu_ps(init + j + 32), a3 = _mm512_loadu_ps(init + j + 48);
+        for (int k = 0; k < nidx; ++k) {
+            const float *w = A + (size_t)idx[k] * lda + j;
+            a0 = _mm512_sub_ps(a0, _mm512_loadu_ps(w));
+            a1 = _mm512_sub_ps(a1, _mm512_loadu_ps(w + 16));
+            a2 = _mm512_sub_ps(a2, _mm512_loadu_ps(w + 32));
+            a3 = _mm512_sub_ps(a3, _mm512_loadu_ps(w + 48));
+        }
+        _mm512_storeu_ps(y + j, a0);
+        _mm512_storeu_ps(y + j + 16, a1);
+        _mm512_storeu_ps(y + j + 32, a2);
+        _mm512_storeu_ps(y + j + 48, a3);
+    }
+    for (; j + 32 <= n; j += 32) {
+        __m512 a0 = _mm512_loadu_ps(init + j), a1 = _mm512_loadu_ps(init + j + 16);
+        for (int k = 0; k < nidx; ++k) {
+            const float *w = A + (size_t)idx[k] * lda + j;
+            a0 = _mm512_sub_ps(a0, _mm512_loadu_ps(w));
+            a1 = _mm512_sub_ps(a1, _mm512_loadu_ps(w + 16));
+        }
+        _mm512_storeu_ps(y + j, a0);
+        _mm512_storeu_ps(y + j + 16, a1);
+    }
+    for (; j < n; j += 16) {
+        const __mmask16 mk = n - j >= 16 ? (__mmask16)0xFFFF : TAIL16(n - j);
+        __m512 a = _mm512_maskz_loadu_ps(mk, init + j);
+        for (int k = 0; k < nidx; ++k)
+            a = _mm512_sub_ps(a, _mm512_maskz_loadu_ps(mk, A + (size_t)idx[k] * lda + j));
+        _mm512_mask_storeu_ps(y + j, mk, a);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline void verser_avx512(__m512i a, int32_t *s)
+{
+    __m512i lo = _mm512_cvtepi16_epi32(_mm512_castsi512_si256(a));
+    __m512i hi = _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(a, 1));
+    _mm512_storeu_si512(s, _mm512_add_epi32(_mm512_loadu_si512(s), lo));
+    _mm512_storeu_si512(s + 16, _mm512_add_epi32(_mm512_loadu_si512(s + 16), hi));
+}
+
+/* nv tranches de 32 colonnes (nv <= 4) */
+__attribute__((target("avx512f,avx512bw"), always_inline))
+static inline void sum_bloc_avx512(const int8_t *A, size_t lda, const uint16_t *idx, int nidx, int32_t *sum,
+                                   const int nv)
+{
+    for (int q = 0; q < 32 * nv; ++q) sum[q] = 0;
+    for (int k0 = 0; k0 < nidx; k0 += I8_BLOC) {
+        const int k1 = nidx - k0 < I8_BLOC ? nidx : k0 + I8_BLOC;
+        __m512i a[4] = { _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(),
+                         _mm512_setzero_si512() };
+        for (int k = k0; k < k1; ++k) {
+            const int8_t *w = A + (size_t)idx[k] * lda;
+            for (int v = 0; v < nv; ++v)
+                a[v] = _mm512_add_epi16(a[v], _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)(w + 32 * v))));
+        }
+        for (int v = 0; v < nv; ++v) verser_avx512(a[v], sum + 32 * v);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void sum_rows_i8_avx512(const int8_t *A, size_t lda, const uint16_t *idx, int nidx, int32_t *sum, int n)
+{
+    int j = 0;
+    for (; j + 128 <= n; j += 128) sum_bloc_avx512(A + j, lda, idx, nidx, sum + j, 4);
+    for (; j + 64 <= n; j += 64) sum_bloc_avx512(A + j, lda, idx, nidx, sum + j, 2);
+    for (; j + 32 <= n; j += 32) sum_bloc_avx512(A + j, lda, idx, nidx, sum + j, 1);
+    if (j == n) return;
+    /* moins de 32 colonnes restantes : chargements masques */
+    const __mmask64 mk = ((__mmask64)1 << (n - j)) - 1;
+    int32_t t[32] = { 0 };
+    for (int k0 = 0; k0 < nidx; k0 += I8_BLOC) {
+        const int k1 = nidx - k0 < I8_BLOC ? nidx : k0 + I8_BLOC;
+        __m512i a = _mm512_setzero_si512();
+        for (int k = k0; k < k1; ++k)
+            a = _mm512_add_epi16(a, _mm512_cvtepi8_epi16(_mm512_castsi512_si256(
+                                        _mm512_maskz_loadu_epi8(mk, A + (size_t)idx[k] * lda + j))));
+        verser_avx512(a, t);
+    }
+    for (int q = 0; q < n - j; ++q) sum[j + q] = t[q];
+}
+
+/* Les 4 lignes d'un groupe de X sont entrelacees une fois par tranches de 16 octets (x0,
+ * x1, x2, x3), completees de zeros : chaque chargement de 64 octets sert a 4 lignes de W,
+ * dont la tranche est diffusee sur les 4 voies. La voie q de l'accumulateur de la ligne j
+ * porte le produit (i + q, j) ; un transpose par unpack donne les 4 x 4 sommes d'un coup.
+ * Au-dela de U8I8_KMAX, dot4 AVX2. */
+#define U8I8_KMAX 512
+
+__attribute__((target("avx512f,avx512bw")))
+static inline void entrelacer_u8_avx512(const uint8_t *X, size_t ldx, int n, int i, int k, uint8_t *xs)
+{
+    const int pleines = k / 16;
+    const __mmask64 reste = ((__mmask64)1 << (k % 16)) - 1;
+    for (int q = 0; q < 4; ++q) {
+        const uint8_t *x = X + (size_t)(i + q < n ? i + q : n - 1) * ldx;
+        int t = 0;
+        for (; t < pleines; ++t)
+            _mm_store_si128((__m128i *)(xs + 64 * t + 16 * q), _mm_loadu_si128((const __m128i *)(x + 16 * t)));
+        if (reste)
+            _mm_store_si128((__m128i *)(xs + 64 * t + 16 * q),
+                            _mm512_castsi512_si128(_mm512_maskz_loadu_epi8(reste, x + 16 * t)));
+    }
+}
+
+/* tranche t de w diffusee sur les 4 voies, masquee pour la derniere */
+__attribute__((target("avx512f,avx512bw")))
+static inline __m512i tranche_i8_avx512(const int8_t *w, int t, __mmask64 mk)
+{
+    return _mm512_broadcast_i32x4(_mm512_castsi512_si128(_mm512_maskz_loadu_epi8(mk, w + 16 * t)));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static inline void ecrire_4x4_avx512(__m512i a0, __m512i a1, __m512i a2, __m512i a3, int32_t *C, size_t ldc,
+                                     int n, int m, int i, int j)
+{
+    _Alignas(64) int32_t r[16];
+    /* voie q : (somme a0, a1, a2, a3) */
+    const __m512i t0 = _mm512_add_epi32(_mm512_unpacklo_epi32(a0, a1), _mm512_unpackhi_epi32(a0, a1));
+    const __m512i t1 = _mm512_add_epi32(_mm512_unpacklo_epi32(a2, a3), _mm512_unpackhi_epi32(a2, a3));
+    _mm512_store_si512(r, _mm512_add_epi32(_mm512_unpacklo_epi64(t0, t1), _mm512_unpackhi_epi64(t0, t1)));
+    const int nc = m - j < 4 ? m - j : 4;
+    for (int q = 0; q < 4 && i + q < n; ++q)
+        memcpy(C + (size_t)(i + q) * ldc + j, r + 4 * q, (size_t)nc * sizeof(int32_t));
+}
+
+/* Les accumulateurs sont nommes pour rester en registres ; les lignes manquantes du
+ * dernier groupe de W repetent la derniere. */
+__attribute__((target("avx512f,avx512bw")))
+static void gemm_u8i8_avx512(const uint8_t *X, size_t ldx, int n, const int8_t *W, size_t ldw, int m, int k,
+                             int32_t *C, size_t ldc)
+{
+    if (k > U8I8_KMAX) {
+        gemm_u8i8_dot4(dot4_u8i8_avx2, X, ldx, n, W, ldw, m, k, C, ldc);
+        return;
+    }
+    _Alignas(64) uint8_t xs[4 * U8I8_KMAX];
+    const int pleines = k / 16, nt = (k + 15) / 16;
+    const __mmask64 reste = ((__mmask64)1 << (k % 16)) - 1;
+    const __m512i ones = _mm512_set1_epi16(1);
+    for (int i = 0; i < n; i += 4) {
+        entrelacer_u8_avx512(X, ldx, n, i, k, xs);
+        for (int j = 0; j < m; j += 4) {
+            const int8_t *w0 = W + (size_t)j * ldw, *w1 = W + (size_t)(j + 1 < m ? j + 1 : m - 1) * ldw,
+                         *w2 = W + (size_t)(j + 2 < m ? j + 2 : m - 1) * ldw,
+                         *w3 = W + (size_t)(j + 3 < m ? j + 3 : m - 1) * ldw;
+            __m512i a0 = _mm512_setzero_si512(), a1 = a0, a2 = a0, a3 = a0;
+            for (int t = 0; t < nt; ++t) {
+                const __mmask64 mk = t < pleines ? ~(__mmask64)0 : reste;
+                const __m512i xv = _mm512_load_si512(xs + 64 * t);
+                a0 = _mm512_add_epi32(a0, _mm512_madd_epi16(_mm512_maddubs_epi16(xv, tranche_i8_avx512(w0, t, mk)), ones));
+                a1 = _mm512_add_epi32(a1, _mm512_madd_epi16(_mm512_maddubs_epi16(xv, tranche_i8_avx512(w1, t, mk)), ones));
+                a2 = _mm512_add_epi32(a2, _mm512_madd_epi16(_mm512_maddubs_epi16(xv, tranche_i8_avx512(w2, t, mk)), ones));
+                a3 = _mm512_add_epi32(a3, _mm512_madd_epi16(_mm512_maddubs_epi16(xv, tranche_i8_avx512(w3, t, mk)), ones));
+            }
+            ecrire_4x4_avx512(a0, a1, a2, a3, C, ldc, n, m, i, j);
+        }
+    }
+}
+
+/* Meme noyau avec vpdpbusd : un seul produit 512 bits par tranche au lieu de deux. Sans
+ * VNNI, maddubs + madd en 512 bits ne vont pas plus vite que deux ports 256 bits. */
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+static void gemm_u8i8_vnni(const uint8_t *X, size_t ldx, int n, const int8_t *W, size_t ldw, int m, int k,
+                           int32_t *C, size_t ldc)
+{
+    if (k > U8I8_KMAX) {
+        gemm_u8i8_dot4(dot4_u8i8_avx2, X, ldx, n, W, ldw, m, k, C, ldc);
+        return;
+    }
+    _Alignas(64) uint8_t xs[4 * U8I8_KMAX];
+    const int pleines = k / 16, nt = (k + 15) / 16;
+    const __mmask64 reste = ((__mmask64)1 << (k % 16)) - 1;
+    for (int i = 0; i < n; i += 4) {
+        entrelacer_u8_avx512(X, ldx, n, i, k, xs);
+        for (int j = 0; j < m; j += 4) {
+            const int8_t *w0 = W + (size_t)j * ldw, *w1 = W + (size_t)(j + 1 < m ? j + 1 : m - 1) * ldw,
+                         *w2 = W + (size_t)(j + 2 < m ? j + 2 : m - 1) * ldw,
+                         *w3 = W + (size_t)(j + 3 < m ? j + 3 : m - 1) * ldw;
+            __m512i a0 = _mm512_setzero_si512(), a1 = a0, a2 = a0, a3 = a0;
+            for (int t = 0; t < nt; ++t) {
+                const __mmask64 mk = t < pleines ? ~(__mmask64)0 : reste;
+                const __m512i xv = _mm512_load_si512(xs + 64 * t);
+                a0 = _mm512_dpbusd_epi32(a0, xv, tranche_i8_avx512(w0, t, mk));
+                a1 = _mm512_dpbusd_epi32(a1, xv, tranche_i8_avx512(w1, t, mk));
+                a2 = _mm512_dpbusd_epi32(a2, xv, tranche_i8_avx512(w2, t, mk));
+                a3 = _mm512_dpbusd_epi32(a3, xv, tranche_i8_avx512(w3, t, mk));
+            }
+            ecrire_4x4_avx512(a0, a1, a2, a3, C, ldc, n, m, i, j);
+        }
+    }
+}
+
+static const DenseOps ops_avx512 = {
+    gemv_avx512, gemm_nt_avx512, bias_sigmoid_avx512, ger_avx512, sub_rows_avx512,
+    sum_rows_i8_avx512, gemm_u8i8_avx512
+};
+
+static const DenseOps ops_avx512_vnni = {
+    gemv_avx512, gemm_nt_avx512, bias_sigmoid_avx512, ger_avx512, sub_rows_avx512,
+    sum_rows_i8_avx512, gemm_u8i8_vnni
+};
+
+#endif
+
+static DenseKernel g_kernel = DENSE_KERNEL_AUTO;
+static const DenseOps *g_ops = NULL;
+static DenseOps g_auto;
+static DenseKernel g_op_kernel[DENSE_OP_COUNT];
+
+/* Ordre de preference de chaque noyau en AUTO, mesure avec bench_dense sur la forme du
+ * reseau (1024 x 96 x 26, lots de 32) ; les jeux absents de la liste ne sont pas pris.
+ * gemm_u8i8 : la version AVX-512 ne passe devant AVX2 qu'avec VNNI (voir op_prise). */
+static const DenseKernel preferes[DENSE_OP_COUNT][4] = {
+    [DENSE_OP_GEMV] = { DENSE_KERNEL_AVX512, DENSE_KERNEL_AVX2, DENSE_KERNEL_SSE2, DENSE_KERNEL_SCALAR },
+    [DENSE_OP_GEMM_NT] = { DENSE_KERNEL_AVX512, DENSE_KERNEL_AVX2, DENSE_KERNEL_SSE2, DENSE_KERNEL_SCALAR },
+    [DENSE_OP_BIAS_SIGMOID] = { DENSE_KERNEL_AVX512, DENSE_KERNEL_AVX2, DENSE_KERNEL_SSE2, DENSE_KERNEL_SCALAR },
+    [DENSE_OP_GER] = { DENSE_KERNEL_AVX512, DENSE_KERNEL_AVX2, DENSE_KERNEL_SSE2, DENSE_KERNEL_SCALAR },
+    [DENSE_OP_SUB_ROWS] = { DENSE_KERNEL_AVX512, DENSE_KERNEL_AVX2, DENSE_KERNEL_SSE2, DENSE_KERNEL_SCALAR },
+    [DENSE_OP_SUM_ROWS_I8] = { DENSE_KERNEL_AVX512, DENSE_KERNEL_AVX2, DENSE_KERNEL_SSE2, DENSE_KERNEL_SCALAR },
+    [DENSE_OP_GEMM_U8I8] = { DENSE_KERNEL_AVX512, DENSE_KERNEL_AVX2, DENSE_KERNEL_SSE2, DENSE_KERNEL_SCALAR },
+};
+
+static int kernel_supported(DenseKernel k)
+{
+    switch (k) {
+    case DENSE_KERNEL_SCALAR:
+        return 1;
+#ifdef DENSE_X86
+    case DENSE_KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case DENSE_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case DENSE_KERNEL_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+    default:
+        return 0;
+    }
+}
+
+static int vnni_supported(void)
+{
+#ifdef DENSE_X86
+    return kernel_supported(DENSE_KERNEL_AVX512) && __builtin_cpu_supports("avx512vnni");
+#else
+    return 0;
+#endif
+}
+
+static const DenseOps *kernel_ops(DenseKernel k)
+{
+    switch (k) {
+#ifdef DENSE_X86
+    case DENSE_KERNEL_SSE2: return &ops_sse2;
+    case DENSE_KERNEL_AVX2: return &ops_avx2;
+    case DENSE_KERNEL_AVX512: return vnni_supported() ? &ops_avx512_vnni : &ops_avx512;
+#endif
+    default: return &ops_scalar;
+    }
+}
+
+/* AUTO : gemm_u8i8 AVX-512 sans VNNI fait jeu egal avec AVX2 (32 x 26 x 96 : 2.5 contre
+ * 2.7 us, 128 lignes : 8.5 contre 8.4 us), on reste alors sur AVX2. */
+static int op_prise(DenseKernel k, DenseOp op)
+{
+    if (op == DENSE_OP_GEMM_U8I8 && k == DENSE_KERNEL_AVX512 && !vnni_supported()) return 0;
+    return kernel_supported(k);
+}
+
+static void copier_op(DenseOps *dst, const DenseOps *src, DenseOp op)
+{
+    switch (op) {
+    case DENSE_OP_GEMV: dst->gemv = src->gemv; break;
+    case DENSE_OP_GEMM_NT: dst->gemm_nt = src->gemm_nt; break;
+    case DENSE_OP_BIAS_SIGMOID: dst->bias_sigmoid = src->bias_sigmoid; break;
+    case DENSE_OP_GER: dst->ger = src->ger; break;
+    case DENSE_OP_SUB_ROWS: dst->sub_rows = src->sub_rows; break;
+    case DENSE_OP_SUM_ROWS_I8: dst->sum_rows_i8 = src->sum_rows_i8; break;
+    case DENSE_OP_GEMM_U8I8: dst->gemm_u8i8 = src->gemm_u8i8; break;
+    default: break;
+    }
+}
+
+int dense_select(DenseKernel kernel)
+{
+    if (kernel != DENSE_KERNEL_AUTO) {
+        if (!kernel_supported(kernel)) return -1;
+        for (int op = 0; op < DENSE_OP_COUNT; ++op) g_op_kernel[op] = kernel;
+        g_ops = kernel_ops(kernel);
+        g_kernel = kernel;
+        return 0;
+    }
+    DenseKernel large = DENSE_KERNEL_SCALAR;
+    for (int op = 0; op < DENSE_OP_COUNT; ++op) {
+        DenseKernel k = DENSE_KERNEL_SCALAR;
+        for (int i = 0; i < 4 && preferes[op][i] != DENSE_KERNEL_AUTO; ++i)
+            if (op_prise(preferes[op][i], (DenseOp)op)) {
+                k = preferes[op][i];
+                break;
+            }
+        copier_op(&g_auto, kernel_ops(k), (DenseOp)op);
+        g_op_kernel[op] = k;
+        if (k > large) large = k;
+    }
+    g_ops = &g_auto;
+    g_kernel = large;
+    return 0;
+}
+
+DenseKernel dense_active_kernel(void)
+{
+    if (!g_ops) dense_select(DENSE_KERNEL_AUTO);
+    return g_kernel;
+}
+
+DenseKernel dense_op_kernel(DenseOp op)
+{
+    if (!g_ops) dense_select(DENSE_KERNEL_AUTO);
+    return op >= 0 && op < DENSE_OP_COUNT ? g_op_kernel[op] : DENSE_KERNEL_AUTO;
+}
+
+const char *dense_kernel_name(DenseKernel kernel)
+{
+    switch (kernel) {
+    case DENSE_KERNEL_SCALAR: return "scalar";
+    case DENSE_KERNEL_SSE2: return "sse2";
+    case DENSE_KERNEL_AVX2: return "avx2";
+    case DENSE_KERNEL_AVX512: return "avx512";
+    default: return "auto";
+    }
+}
+
+const char *dense_op_name(DenseOp op)
+{
+    static const char *const noms[DENSE_OP_COUNT] = { "gemv", "gemm_nt", "sigmoide", "ger", "sub_rows",
+                                                       "sum_i8", "gemm_u8i8" };
+    return op >= 0 && op < DENSE_OP_COUNT ? noms[op] : "?";
+}
+
+const DenseOps *dense_ops(DenseKernel kernel)
+{
+    if (kernel == DENSE_KERNEL_AUTO) {
+        if (!g_ops) dense_select(DENSE_KERNEL_AUTO);
+        return g_ops;
+    }
+    return kernel_supported(kernel) ? kernel_ops(kernel) : NULL;
+}
@@ -0,0 +1,67 @@
+#ifndef DENSE_H
+#define DENSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Noyaux denses du reseau (matrices ligne par ligne, lda = pas entre deux lignes).
+ * Chaque noyau existe en scalaire (la reference), SSE2, AVX2 + FMA et AVX-512 (F et BW) ;
+ * le choix est fait une fois d'apres le CPU, au chargement du modele, noyau par noyau : le
+ * jeu le plus large n'est pas toujours le plus rapide sur les petites tailles. En float,
+ * les versions vectorielles ne changent que l'ordre des sommes (et l'arrondi des FMA) :
+ * ecart relatif de l'ordre de 1e-6 avec le scalaire. */
+
+typedef enum {
+    DENSE_KERNEL_AUTO = 0,
+    DENSE_KERNEL_SCALAR,
+    DENSE_KERNEL_SSE2,
+    DENSE_KERNEL_AVX2,
+    DENSE_KERNEL_AVX512
+} DenseKernel;
+
+typedef struct {
+    /* y[r] = A[r] . x, r < rows */
+    void (*gemv)(const float *A, size_t lda, int rows, int cols, const float *x, float *y);
+    /* C[i][j] = X[i] . W[j], i < n, j < m, produits de longueur k */
+    void (*gemm_nt)(const float *X, size_t ldx, int n, const float *W, size_t ldw, int m, int k,
+                    float *C, size_t ldc);
+    /* y[i] = sigmoid(y[i] + b[i]) ; b peut etre NULL */
+    void (*bias_sigmoid)(float *y, const float *b, int n);
+    /* A[r] += alpha[r] * x : produit exterieur accumule (gradients) */
+    void (*ger)(float *A, size_t lda, int rows, int cols, const float *alpha, const float *x);
+    /* y = init - somme des lignes A[idx[k]] (entree binaire), n colonnes */
+    void (*sub_rows)(const float *A, size_t lda, const uint16_t *idx, int nidx, const float *init,
+                     float *y, int n);
+
+    /* Modele int8 (resultats exacts, identiques dans tous les jeux). */
+    /* sum[j] = somme des lignes A[idx[k]], j < n */
+    void (*sum_rows_i8)(const int8_t *A, size_t lda, const uint16_t *idx, int nidx, int32_t *sum, int n);
+    /* C[i][j] = X[i] . W[j] ; X dans 0..127 (pas de saturation des paires u8 x s8) */
+    void (*gemm_u8i8)(const uint8_t *X, size_t ldx, int n, const int8_t *W, size_t ldw, int m, int k,
+                      int32_t *C, size_t ldc);
+} DenseOps;
+
+typedef enum {
+    DENSE_OP_GEMV = 0,
+    DENSE_OP_GEMM_NT,
+    DENSE_OP_BIAS_SIGMOID,
+    DENSE_OP_GER,
+    DENSE_OP_SUB_ROWS,
+    DENSE_OP_SUM_ROWS_I8,
+    DENSE_OP_GEMM_U8I8,
+    DENSE_OP_COUNT
+} DenseOp;
+
+/* AUTO : pour chaque noyau, le premier jeu supporte de sa liste de preference (dense.c).
+ * Un jeu explicite impose ses noyaux a tous. */
+int dense_select(DenseKernel kernel);
+/* Jeu le plus large en service ; dense_op_kernel donne le jeu de chaque noyau. */
+DenseKernel dense_active_kernel(void);
+DenseKernel dense_op_kernel(DenseOp op);
+const char *dense_kernel_name(DenseKernel kernel);
+const char *dense_op_name(DenseOp op);
+
+/* AUTO : noyaux actifs. NULL si le CPU ne supporte pas ce jeu. */
+const DenseOps *dense_ops(DenseKernel kernel);
+
+#endif
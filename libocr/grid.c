@@ -0,0 +1,435 @@
+#include "ocr.h"
+#include "arena.h"
+#include "ccl.h"
+#include "hough.h"
+#include "pool.h"
+#include "projection.h"
+#include "resample.h"
+#include "rle.h"
+#include "sort.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int x0, y0, x1, y1;
+    double yc;
+} LettreBox;
+
+#define TILE_TARGET OCR_TILE_SIZE
+#define TILE_MARGIN 2
+
+static unsigned char *normalize_letter(const unsigned char *src, int w, int h, Arena *scratch)
+{
+    unsigned char *dst = malloc(TILE_TARGET * TILE_TARGET);
+    if (!dst) return NULL;
+    if (resample_letter(src, w, h, (size_t)w, TILE_TARGET, TILE_TARGET, TILE_MARGIN,
+                        RESAMPLE_TRIM | RESAMPLE_INVERT, dst, scratch) != 0) {
+        free(dst);
+        return NULL;
+    }
+    return dst;
+}
+
+/* Normalise la case en OCR_TILE_SIZE x OCR_TILE_SIZE ; si la normalisation echoue,
+ * la case brute est copiee telle quelle. cell est un tampon de l'arene. Renvoie -1 si
+ * aucune image n'a pu etre allouee. */
+static int poser_image(OcrTile *t,const unsigned char *cell,int w,int h,Arena *scratch){
+    unsigned char *norm = normalize_letter(cell,w,h,scratch);
+    t->img.channels=1;
+    if(norm){
+        t->img.pixels=norm;
+        t->img.width=t->img.height=TILE_TARGET;
+    }else{
+        t->img.pixels=malloc((size_t)w*h);
+        if(!t->img.pixels) return -1;
+        memcpy(t->img.pixels,cell,(size_t)w*h);
+        t->img.width=w;
+        t->img.height=h;
+    }
+    t->img.stride=(size_t)t->img.width;
+    return 0;
+}
+
+static int ajouter_case(OcrTileSet *set,int row,int col,int x0,int y0,const unsigned char *cell,int w,int h,
+                        Arena *scratch){
+    if(set->count==set->cap){
+        size_t cap=set->cap?set->cap*2:64;
+        OcrTile *tmp=realloc(set->tiles,cap*sizeof(OcrTile));
+        if(!tmp) return -1;
+        set->tiles=tmp;
+        set->cap=cap;
+    }
+    OcrTile *t=&set->tiles[set->count];
+    t->row=row;
+    t->col=col;
+    t->x0=x0; t->y0=y0;
+    t->x1=x0+w-1; t->y1=y0+h-1;
+    if(poser_image(t,cell,w,h,scratch)!=0) return -1;
+    set->count++;
+    return 0;
+}
+
+/* cnt : pixels d'encre de chacune des L lignes (ou colonnes) de longueur D. */
+static int collecter_lignes(const int *cnt,int L,int D,int **out,Arena *scratch){
+    int maxv=0;
+    for(int i=0;i<L;i++) if(cnt[i]>maxv) maxv=cnt[i];
+    if(maxv==0) return -1;
+
+    int t=(int)(maxv*0.55);
+    int tmin=(int)(D*0.3);
+    if(t<tmin) t=tmin;
+
+    int *res=arena_alloc(scratch,L*sizeof(int));
+    if(!res) return -1;
+
+    int n=0,st=-1;
+    for(int i=0;i<L;i++){
+        if(cnt[i]>=t){ if(st<0) st=i; }
+        else if(st>=0){
+            res[n++] = (st+i-1)/2;
+            st=-1;
+        }
+    }
+    if(st>=0) res[n++] = (st+L-1)/2;
+
+    if(n<2) return -1;
+    *out=res;
+    return n;
+}
+
+static int cle_yc(const void *a){
+    const LettreBox *l=a;
+    return l->y0+l->y1;
+}
+
+static int cmp_yc(const void *a,const void *b){
+    const LettreBox *la=a,*lb=b;
+    return (la->yc>lb->yc)-(la->yc<lb->yc);
+}
+
+static int cmp_x0(const void *a,const void *b){
+    const LettreBox *la=a,*lb=b;
+    return (la->x0>lb->x0)-(la->x0<lb->x0);
+}
+
+/* runs : segments de l'image s'ils existent deja, sinon codes ici. */
+static int decouper_grille_fallback_lettres(const OcrImage *img,const RleImage *runs,OcrTileSet *out,
+                                            Arena *scratch){
+    int W=img->width, H=img->height;
+    const unsigned char *pix = img->pixels;
+
+    RleImage rle;
+    CclSet cc;
+    int rc;
+    if(runs) rc=ccl_label_runs(runs,8,&cc);
+    else{
+        if(rle_encode(pix,W,H,img->stride,200,&rle)!=0) return -1;
+        rc=ccl_label_runs(&rle,8,&cc);
+        rle_free(&rle);
+    }
+    if(rc!=0) return -1;
+
+    LettreBox *b = arena_alloc(scratch,sizeof(LettreBox)*(cc.count+1));
+    if(!b){ ccl_free(&cc); return -1; }
+    int nb=0;
+
+    for(size_t i=0;i<cc.count;i++){
+        const CclComponent *c=&cc.items[i];
+        int w=c->x1-c->x0+1, h=c->y1-c->y0+1;
+        if(w<3||h<3) continue;
+
+        b[nb].x0=c->x0; b[nb].x1=c->x1;
+        b[nb].y0=c->y0; b[nb].y1=c->y1;
+        b[nb].yc = (double)(c->y0+c->y1)/2.0;
+        nb++;
+    }
+    ccl_free(&cc);
+
+    if(nb<4) return -1;
+
+    double avg=0;
+    for(int i=0;i<nb;i++) avg += (b[i].y1-b[i].y0+1);
+    avg/=nb;
+    double th = avg*0.6;
+
+    /* yc = (y0+y1)/2 : y0+y1 est une cle entiere, tri par denombrement */
+    if(sort_by_key(b,nb,sizeof(LettreBox),cle_yc,2*(H-1))!=0)
+        sort_stable(b,nb,sizeof(LettreBox),cmp_yc);
+
+    int *ld=arena_alloc(scratch,sizeof(int)*nb);
+    int *lnb=arena_alloc(scratch,sizeof(int)*nb);
+    if(!ld||!lnb) return -1;
+    int NL=0;
+
+    int st=0;
+    while(st<nb){
+        double yc=b[st].yc;
+        int ed=st+1;
+        while(ed<nb && fabs(b[ed].yc-yc)<th) ed++;
+        ld[NL]=st; lnb[NL]=ed-st; NL++;
+        st=ed;
+    }
+
+    int best=0,freq=0;
+    for(int i=0;i<NL;i++){
+        int c=lnb[i];
+        if(c<2) continue;
+        int f=0;
+        for(int j=0;j<NL;j++) if(lnb[j]==c) f++;
+        if(f>freq){freq=f; best=c;}
+    }
+
+    if(best<2) return -1;
+
+    out->fallback=1;
+
+    int saved=0;
+
+    for(int i=0;i<NL;i++){
+        if(lnb[i]!=best) continue;
+        int s=ld[i], c=lnb[i];
+
+        sort_stable(b+s,c,sizeof(LettreBox),cmp_x0);
+
+        for(int col=0;col<c;col++){
+            LettreBox *L=&b[s+col];
+            int w=L->x1-L->x0+1, h=L->y1-L->y0+1;
+
+            ArenaMark m=arena_mark(scratch);
+            unsigned char *cell=arena_alloc(scratch,(size_t)w*h);
+            if(!cell) continue;
+            for(int yy=0;yy<h;yy++)
+                memcpy(cell+yy*w, pix+(L->y0+yy)*W+L->x0, w);
+
+            if(ajouter_case(out,i,col,L->x0,L->y0,cell,w,h,scratch)==0) saved++;
+            arena_release(scratch,m);
+        }
+    }
+
+    return saved>0?0:-1;
+}
+
+/* Case (x0,y0)-(x1,y1) du repere redresse ; sans rotation (g NULL), simple copie. */
+static unsigned char *copier_case(const OcrImage *bw,const HoughGrid *g,int x0,int y0,int w,int h,
+                                  Arena *scratch){
+    unsigned char *buf=arena_alloc(scratch,(size_t)w*h);
+    if(!buf) return NULL;
+    if(!g){
+        for(int y=0;y<h;y++)
+            memcpy(buf+y*w, bw->pixels+(y0+y)*bw->width+x0, w);
+        return buf;
+    }
+    /* echantillonnage direct dans l'image non tournee : seuls les pixels de la case */
+    double m[6];
+    hough_affine(g,m);
+    for(int y=0;y<h;y++){
+        double bx=m[0]+m[1]*x0+m[2]*(y0+y), by=m[3]+m[4]*x0+m[5]*(y0+y);
+        unsigned char *dst=buf+y*w;
+        for(int x=0;x<w;x++){
+            int ix=(int)floor(bx+m[1]*x+0.5), iy=(int)floor(by+m[4]*x+0.5);
+            int in=ix>=0&&ix<bw->width&&iy>=0&&iy<bw->height;
+            dst[x]=in?bw->pixels[iy*bw->width+ix]:255;
+        }
+    }
+    return buf;
+}
+
+/* La case t (bornes deja posees, dans le repere redresse si g) : copie, normalisation,
+ * puis boite englobante dans l'image. img.pixels reste NULL si la copie echoue. */
+static void traiter_case(const OcrImage *bw,const HoughGrid *g,OcrTile *t,Arena *scratch){
+    int x0=t->x0, y0=t->y0, w=t->x1-x0+1, h=t->y1-y0+1;
+    ArenaMark m=arena_mark(scratch);
+    unsigned char *buf=copier_case(bw,g,x0,y0,w,h,scratch);
+    int ok=buf&&poser_image(t,buf,w,h,scratch)==0;
+    arena_release(scratch,m);
+    if(!ok){ t->img.pixels=NULL; return; }
+    if(g){
+        /* boite englobante des coins de la case dans l'image */
+        t->x0=t->y0=INT_MAX; t->x1=t->y1=INT_MIN;
+        for(int k=0;k<4;k++){
+            double sx,sy;
+            hough_map(g,x0+(k&1)*(w-1),y0+(k>>1)*(h-1),&sx,&sy);
+            int ix=(int)lround(sx), iy=(int)lround(sy);
+            if(ix<t->x0) t->x0=ix;
+            if(ix>t->x1) t->x1=ix;
+            if(iy<t->y0) t->y0=iy;
+            if(iy>t->y1) t->y1=iy;
+        }
+    }
+}
+
+typedef struct {
+    const OcrImage *bw;
+    const HoughGrid *g;
+    OcrTile *tiles;
+    size_t debut, fin;
+    Arena *scratch;   /* NULL : arene propre au lot */
+    size_t peak;
+} LotCases;
+
+static void traiter_lot(void *arg){
+    LotCases *l=arg;
+    Arena propre, *a=l->scratch;
+    if(!a) arena_init(a=&propre,0);
+    for(size_t i=l->debut;i<l->fin;i++) traiter_case(l->bw,l->g,&l->tiles[i],a);
+    if(a==&propre){
+        l->peak=propre.peak;
+        arena_free(&propre);
+    }
+}
+
+/* en dessous, le cout de creation des threads depasse le gain */
+#define GRILLE_CASES_PAR_THREAD 64
+#define GRILLE_LOTS_PAR_THREAD 4
+
+/* Chaque case a sa place dans out->tiles, dans l'ordre ligne par ligne du parcours
+ * serie : les threads remplissent des lots de places voisines, le resultat ne depend
+ * pas de l'ordonnancement. */
+static void traiter_cases(const OcrImage *bw,const HoughGrid *g,OcrTile *tiles,size_t n,int nthreads,
+                          Arena *scratch,size_t *peak){
+    if(nthreads<=0) nthreads=pool_default_threads();
+    size_t utile=n/GRILLE_CASES_PAR_THREAD;
+    if(utile<1) utile=1;
+    if((size_t)nthreads>utile) nthreads=(int)utile;
+
+    size_t nlots=(size_t)nthreads*GRILLE_LOTS_PAR_THREAD;
+    LotCases *lots=nthreads>1?malloc(nlots*sizeof(LotCases)):NULL;
+    Pool *pool=lots?pool_create(nthreads):NULL;
+    if(!pool){
+        free(lots);
+        LotCases tout={bw,g,tiles,0,n,scratch,0};
+        traiter_lot(&tout);
+        return;
+    }
+    for(size_t i=0;i<nlots;i++){
+        lots[i]=(LotCases){bw,g,tiles,n*i/nlots,n*(i+1)/nlots,NULL,0};
+        if(pool_submit(pool,traiter_lot,&lots[i])!=0) traiter_lot(&lots[i]);
+    }
+    pool_wait(pool);
+    pool_destroy(pool);
+    for(size_t i=0;i<nlots;i++) if(lots[i].peak>*peak) *peak=lots[i].peak;
+    free(lots);
+}
+
+static int decouper_cases(const OcrImage *bw,const int *H,int nH,const int *V,int nV,
+                          const HoughGrid *g,OcrTileSet *out,int nthreads,Arena *scratch,size_t *peak){
+    size_t cap=(size_t)(nH-1)*(size_t)(nV-1);
+    out->tiles=calloc(cap?cap:1,sizeof(OcrTile));
+    if(!out->tiles) return -1;
+    out->cap=cap;
+
+    size_t n=0;
+    for(int r=0;r<nH-1;r++){
+        int y0=H[r], y1=H[r+1];
+        if(y1<=y0) continue;
+        for(int c=0;c<nV-1;c++){
+            int x0=V[c], x1=V[c+1];
+            if(x1<=x0) continue;
+
+            /* traits redresses en escalier : on rentre d'un huitieme de case */
+            int mx=g?(x1-x0)/8:0, my=g?(y1-y0)/8:0;
+            OcrTile *t=&out->tiles[n++];
+            t->row=r;
+            t->col=c;
+            t->x0=x0+mx; t->y0=y0+my;
+            t->x1=x1-mx; t->y1=y1-my;
+        }
+    }
+    traiter_cases(bw,g,out->tiles,n,nthreads,scratch,peak);
+
+    /* cases dont la copie a echoue : retirees, l'ordre est garde */
+    for(size_t i=0;i<n;i++)
+        if(out->tiles[i].img.pixels) out->tiles[out->count++]=out->tiles[i];
+    return out->count>0?0:-1;
+}
+
+/* Grille legerement tournee : les profils ne trouvent pas les traits, la transformee
+ * de Hough donne l'angle de chaque famille et les positions dans le repere redresse. */
+#define GRILLE_ANGLE_MAX 15.0
+
+/* angle connu : seule la passe fine de Hough, a +- GRILLE_ANGLE_TOL */
+#define GRILLE_ANGLE_TOL 0.5
+
+/* Decoupage avec l'arene de l'image : profils, positions des traits, cases brutes.
+ * angle : inclinaison donnee par l'appelant, NULL pour l'estimer. */
+static int decouper(const OcrImage *bw,const RleImage *runs,const double *angle,OcrTileSet *out,
+                    int nthreads,Arena *scratch,size_t *peak){
+    HoughGrid g;
+    if(angle&&*angle!=0.0){
+        /* les angles de Hough sont comptes dans l'autre sens */
+        if(hough_grid_lines_near(bw->pixels,bw->width,bw->height,bw->stride,-*angle,GRILLE_ANGLE_TOL,&g)==0){
+            int rc=decouper_cases(bw,g.rows,g.nrows,g.cols,g.ncols,&g,out,nthreads,scratch,peak);
+            hough_free(&g);
+            if(rc==0) return 0;
+            ocr_tiles_free(out);
+        }
+    }
+    int *rows=arena_alloc(scratch,sizeof(int)*bw->height), *cols=arena_alloc(scratch,sizeof(int)*bw->width);
+    if(!rows||!cols||proj_ink_counts(bw->pixels,bw->width,bw->height,bw->stride,rows,cols,0)!=0)
+        return -1;
+    int *H=NULL,*V=NULL;
+    int nH=collecter_lignes(rows,bw->height,bw->width,&H,scratch);
+    int nV=collecter_lignes(cols,bw->width,bw->height,&V,scratch);
+
+    if(nH>=2&&nV>=2)
+        return decouper_cases(bw,H,nH,V,nV,NULL,out,nthreads,scratch,peak);
+
+    if(hough_grid_lines(bw->pixels,bw->width,bw->height,bw->stride,GRILLE_ANGLE_MAX,&g)==0){
+        int droit=g.angle_v==0.0&&g.angle_h==0.0;
+        int rc=decouper_cases(bw,g.rows,g.nrows,g.cols,g.ncols,droit?NULL:&g,out,nthreads,scratch,peak);
+        hough_free(&g);
+        if(rc==0) return 0;
+        ocr_tiles_free(out);
+    }
+    return decouper_grille_fallback_lettres(bw,runs,out,scratch);
+}
+
+/* Une arene par image : celle de l'appelant, videe au debut, ou une locale liberee a la
+ * fin ; les lots paralleles ont chacun la leur. scratch_peak : pic de l'arene la plus
+ * chargee. */
+static int split_grid(const OcrImage *bw,const RleImage *runs,const double *angle,OcrTileSet *out,
+                      int nthreads,Arena *scratch){
+    memset(out,0,sizeof(*out));
+    if(!bw||!bw->pixels||bw->channels!=1||bw->stride!=(size_t)bw->width) return -1;
+    if(runs&&(runs->width!=bw->width||runs->height!=bw->height)) return -1;
+
+    Arena propre;
+    if(scratch) arena_reset(scratch);
+    else arena_init(scratch=&propre,0);
+    size_t peak=0;
+    int rc=decouper(bw,runs,angle,out,nthreads,scratch,&peak);
+    out->scratch_peak=scratch->peak>peak?scratch->peak:peak;
+    if(scratch==&propre) arena_free(&propre);
+    return rc;
+}
+
+int ocr_split_grid_mt(const OcrImage *bw,OcrTileSet *out,int nthreads){
+    return split_grid(bw,NULL,NULL,out,nthreads,NULL);
+}
+
+int ocr_split_grid_angle(const OcrImage *bw,OcrTileSet *out,int nthreads,double angle_deg){
+    return split_grid(bw,NULL,&angle_deg,out,nthreads,NULL);
+}
+
+int ocr_split_grid_runs(const OcrImage *bw,const RleImage *runs,OcrTileSet *out,int nthreads){
+    return split_grid(bw,runs,NULL,out,nthreads,NULL);
+}
+
+int ocr_split_grid_scratch(const OcrImage *bw,const RleImage *runs,const double *angle_deg,
+                           OcrTileSet *out,int nthreads,Arena *scratch){
+    return split_grid(bw,runs,angle_deg,out,nthreads,scratch);
+}
+
+int ocr_split_grid(const OcrImage *bw,OcrTileSet *out){
+    return ocr_split_grid_mt(bw,out,0);
+}
+
+void ocr_tiles_free(OcrTileSet *set){
+    if(!set) return;
+    for(size_t i=0;i<set->count;i++) ocr_image_free(&set->tiles[i].img);
+    free(set->tiles);
+    memset(set,0,sizeof(*set));
+}
@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+#include "histogram.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "luma.h"
+#include "pool.h"
+
+#define HIST_MAX_THREADS 64
+#define HIST_MIN_PIXELS_PER_THREAD (1u << 18)
+
+void hist_gray(const unsigned char *gray, int w, int h, size_t stride, unsigned int hist[256])
+{
+    unsigned int sub[4][256];
+    memset(sub, 0, sizeof(sub));
+    for (int y = 0; y < h; ++y) {
+        const unsigned char *row = gray + (size_t)y * stride;
+        int x = 0;
+        for (; x + 4 <= w; x += 4) {
+            sub[0][row[x + 0]]++;
+            sub[1][row[x + 1]]++;
+            sub[2][row[x + 2]]++;
+            sub[3][row[x + 3]]++;
+        }
+        for (; x < w; ++x)
+            sub[0][row[x]]++;
+    }
+    for (int t = 0; t < 256; ++t)
+        hist[t] += sub[0][t] + sub[1][t] + sub[2][t] + sub[3][t];
+}
+
+typedef struct {
+    const unsigned char *src;
+    unsigned char *gray;
+    int w;
+    size_t stride;
+    size_t begin;
+    size_t end;
+    unsigned int hist[256];
+} HistBand;
+
+static void *gray_band(void *arg)
+{
+    HistBand *b = (HistBand *)arg;
+    hist_gray(b->src + b->begin * b->stride, b->w, (int)(b->end - b->begin), b->stride, b->hist);
+    return NULL;
+}
+
+static void *luma_band(void *arg)
+{
+    HistBand *b = (HistBand *)arg;
+    luma_rgba_hist(b->src + b->begin * 4, b->end - b->begin, b->gray + b->begin, b->hist);
+    return NULL;
+}
+
+static int band_count(size_t pixels, int nthreads)
+{
+    if (nthreads <= 0) nthreads = pool_default_threads();
+    if (nthreads > HIST_MAX_THREADS) nthreads = HIST_MAX_THREADS;
+    size_t useful = pixels / HIST_MIN_PIXELS_PER_THREAD;
+    if (useful < 1) useful = 1;
+    if ((size_t)nthreads > useful) nthreads = (int)useful;
+    return nthreads;
+}
+
+/* bands[0] tourne dans le thread appelant ; si pthread_create echoue la bande
+ * est simplement traitee sur place. */
+static void run_bands(HistBand *bands, int n, void *(*fn)(void *), unsigned int hist[256])
+{
+    pthread_t tids[HIST_MAX_THREADS];
+    int started[HIST_MAX_THREADS] = {0};
+    for (int i = 1; i < n; ++i)
+        started[i] = pthread_create(&tids[i], NULL, fn, &bands[i]) == 0;
+    fn(&bands[0]);
+    for (int i = 1; i < n; ++i) {
+        if (started[i]) pthread_join(tids[i], NULL);
+        else fn(&bands[i]);
+    }
+    for (int i = 0; i < n; ++i)
+        for (int t = 0; t < 256; ++t)
+            hist[t] += bands[i].hist[t];
+}
+
+int hist_gray_parallel(const unsigned char *gray, int w, int h, size_t stride,
+                       unsigned int hist[256], int nthreads)
+{
+    if (!gray || w <= 0 || h <= 0) return -1;
+    int n = band_count((size_t)w * (size_t)h, nthreads);
+    if (n > h) n = h;
+    if (n <= 1) {
+        hist_gray(gray, w, h, stride, hist);
+        return 0;
+    }
+    HistBand bands[HIST_MAX_THREADS];
+    for (int i = 0; i < n; ++i) {
+        memset(&bands[i], 0, sizeof(bands[i]));
+        bands[i].src = gray;
+        bands[i].w = w;
+        bands[i].stride = stride;
+        bands[i].begin = (size_t)h * (size_t)i / (size_t)n;
+        bands[i].end = (size_t)h * (size_t)(i + 1) / (size_t)n;
+    }
+    run_bands(bands, n, gray_band, hist);
+    return 0;
+}
+
+int hist_luma_parallel(const unsigned char *rgba, size_t n_px, unsigned char *gray,
+                       unsigned int hist[256], int nthreads)
+{
+    if (!rgba || !gray) return -1;
+    int n = band_count(n_px, nthreads);
+    if (n <= 1) {
+        luma_rgba_hist(rgba, n_px, gray, hist);
+        return 0;
+    }
+    luma_active_kernel(); /* choix du noyau avant de lancer les threads */
+    HistBand bands[HIST_MAX_THREADS];
+    for (int i = 0; i < n; ++i) {
+        memset(&bands[i], 0, sizeof(bands[i]));
+        bands[i].src = rgba;
+        bands[i].gray = gray;
+        bands[i].begin = n_px * (size_t)i / (size_t)n;
+        bands[i].end = n_px * (size_t)(i + 1) / (size_t)n;
+    }
+    run_bands(bands, n, luma_band, hist);
+    return 0;
+}
+
+static uint32_t xorshift32(uint32_t s)
+{
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+size_t hist_gray_sampled(const unsigned char *gray, int w, int h, size_t stride, int step,
+                         unsigned int hist[256])
+{
+    if (step <= 1) {
+        hist_gray(gray, w, h, stride, hist);
+        return (size_t)w * (size_t)h;
+    }
+    uint32_t state = 0x9e3779b9u;
+    size_t count = 0;
+    for (int by = 0; by < h; by += step) {
+        int bh = h - by < step ? h - by : step;
+        for (int bx = 0; bx < w; bx += step) {
+            int bw = w - bx < step ? w - bx : step;
+            state = xorshift32(state);
+            int y = by + (int)((state >> 16) % (uint32_t)bh);
+            int x = bx + (int)((state & 0xffffu) % (uint32_t)bw);
+            hist[gray[(size_t)y * stride + (size_t)x]]++;
+            count++;
+        }
+    }
+    return count;
+}
+
+int hist_sample_step(int w, int h, double eps, double delta)
+{
+    if (w <= 0 || h <= 0 || eps <= 0.0 || delta <= 0.0 || delta >= 1.0) return 1;
+    double needed = log(2.0 / delta) / (2.0 * eps * eps);
+    double ratio = (double)w * (double)h / needed;
+    if (ratio < 16.0) return 1; /* en dessous d'un pas de 4 le tirage coute plus que le comptage */
+    int step = (int)sqrt(ratio);
+    if (step > w) step = w;
+    if (step > h) step = h;
+    return step < 1 ? 1 : step;
+}
+
+int hist_otsu(const unsigned int hist[256], unsigned long long total, int fallback)
+{
+    double sum = 0.0;
+    for (int t = 0; t < 256; ++t)
+        sum += t * (double)hist[t];
+
+    double sumB = 0.0;
+    unsigned long long wB = 0;
+    unsigned long long wF = 0;
+    double varMax = -1.0;
+    int threshold = fallback;
+
+    for (int t = 0; t < 256; ++t) {
+        wB += hist[t];
+        if (wB == 0) continue;
+        wF = total - wB;
+        if (wF == 0) break;
+
+        sumB += t * (double)hist[t];
+        double mB = sumB / (double)wB;
+        double mF = (sum - sumB) / (double)wF;
+
+        double varBetween = (double)wB * (double)wF * (mB - mF) * (mB - mF);
+        if (varBetween > varMax) {
+            varMax = varBetween;
+            threshold = t;
+        }
+    }
+    return threshold;
+}
@@ -0,0 +1,35 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stddef.h>
+
+/* Histogramme 8 bits d'un plan gris de w x h pixels, lignes de stride octets.
+ * Les fonctions ajoutent a hist : l'appelant le met a zero. */
+void hist_gray(const unsigned char *gray, int w, int h, size_t stride, unsigned int hist[256]);
+
+/* Bandes de lignes reparties sur nthreads threads (<= 0 : un par coeur), chacun avec
+ * un histogramme prive, fusionnes a la fin. Resultat identique a la version serie. */
+int hist_gray_parallel(const unsigned char *gray, int w, int h, size_t stride,
+                       unsigned int hist[256], int nthreads);
+/* RGBA -> gris + histogramme (luma_rgba_hist) decoupe de la meme facon. */
+int hist_luma_parallel(const unsigned char *rgba, size_t n, unsigned char *gray,
+                       unsigned int hist[256], int nthreads);
+
+/* Histogramme sur un sous-ensemble de pixels : un pixel tire au hasard dans chaque
+ * bloc step x step. Pas de repliement sur les traits reguliers de la grille, et pas de
+ * lignes entieres correlees. Renvoie le nombre de pixels comptes. */
+size_t hist_gray_sampled(const unsigned char *gray, int w, int h, size_t stride, int step,
+                         unsigned int hist[256]);
+
+/* Pas d'echantillonnage pour que la fonction de repartition estimee reste a eps pres
+ * de la vraie avec une probabilite >= 1 - delta (inegalite DKW : n >= ln(2/delta) / 2eps^2).
+ * Seule cette erreur est bornee. Le seuil d'Otsu n'a pas de borne : c'est l'argmax de la
+ * variance inter-classes, qui peut sauter d'un pic a un autre presque aussi haut meme
+ * avec une repartition tres proche. Sa derive est mesuree (bench_hist), pas garantie.
+ * Renvoie 1 (tout compter) si l'image est trop petite pour gagner quelque chose. */
+int hist_sample_step(int w, int h, double eps, double delta);
+
+/* Seuil d'Otsu (maximum de la variance inter-classes) ; fallback si l'image est uniforme. */
+int hist_otsu(const unsigned int hist[256], unsigned long long total, int fallback);
+
+#endif
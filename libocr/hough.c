@@ -0,0 +1,289 @@
+#include "hough.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* cos/sin en virgule fixe : |dx| * 2^14 tient dans un int jusqu'a ~60000 px */
+#define HOUGH_FP 14
+#define HOUGH_COARSE_STEP 0.5
+#define HOUGH_FINE_STEP 0.05
+/* ecart maximal entre les deux bords d'un meme trait */
+#define HOUGH_FUSION 4
+#define HOUGH_FOND_MIN 3
+#define HOUGH_FOND_MAX 6
+
+typedef struct {
+    int *dx, *dy;
+    size_t n;
+    int rmax;     /* |rho| <= rmax */
+    int nrho;
+} HoughEdges;
+
+static int est_bord(const unsigned char *row, int x, int y, int w, int h, size_t stride)
+{
+    return row[x] == 0 && (x == 0 || x == w - 1 || y == 0 || y == h - 1 || row[x - 1] != 0 ||
+                           row[x + 1] != 0 || *(row - stride + x) != 0 || row[stride + x] != 0);
+}
+
+static int collect_edges(const unsigned char *pix, int w, int h, size_t stride, HoughEdges *e)
+{
+    size_t n = 0;
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x) n += est_bord(pix + (size_t)y * stride, x, y, w, h, stride);
+    e->n = 0;
+    e->dx = malloc((n ? n : 1) * sizeof(int));
+    e->dy = malloc((n ? n : 1) * sizeof(int));
+    if (!e->dx || !e->dy) {
+        free(e->dx);
+        free(e->dy);
+        return -1;
+    }
+    const int cx = w / 2, cy = h / 2;
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (est_bord(pix + (size_t)y * stride, x, y, w, h, stride)) {
+                e->dx[e->n] = x - cx;
+                e->dy[e->n] = y - cy;
+                e->n++;
+            }
+    e->rmax = (int)ceil(hypot((double)w, (double)h) / 2.0) + 1;
+    e->nrho = 2 * e->rmax + 1;
+    return 0;
+}
+
+/* Votes pour un angle : rho = dx*c + dy*s. Renvoie la somme des carres des cases,
+ * d'autant plus grande que les votes se concentrent sur quelques traits. */
+static uint64_t vote(const HoughEdges *e, double c, double s, int *acc)
+{
+    const int ci = (int)lround(c * (1 << HOUGH_FP));
+    const int si = (int)lround(s * (1 << HOUGH_FP));
+    const int off = (e->rmax << HOUGH_FP) + (1 << (HOUGH_FP - 1));
+    memset(acc, 0, (size_t)e->nrho * sizeof(int));
+    for (size_t i = 0; i < e->n; ++i) acc[(e->dx[i] * ci + e->dy[i] * si + off) >> HOUGH_FP]++;
+    uint64_t score = 0;
+    for (int r = 0; r < e->nrho; ++r) score += (uint64_t)acc[r] * (uint64_t)acc[r];
+    return score;
+}
+
+/* Normale de la famille a l'angle a (radians) : (cos a, sin a) pour les traits
+ * verticaux, (-sin a, cos a) pour les horizontaux. */
+static void normale(int horizontal, double a, double *c, double *s)
+{
+    if (horizontal) {
+        *c = -sin(a);
+        *s = cos(a);
+    } else {
+        *c = cos(a);
+        *s = sin(a);
+    }
+}
+
+static double best_angle(const HoughEdges *e, int horizontal, double lo, double hi, double step, int *acc)
+{
+    double best = 0.0;
+    uint64_t best_score = 0;
+    int n = (int)floor((hi - lo) / step + 0.5);
+    for (int i = 0; i <= n; ++i) {
+        double deg = lo + i * step;
+        double c, s;
+        normale(horizontal, deg * M_PI / 180.0, &c, &s);
+        uint64_t score = vote(e, c, s, acc);
+        /* a score egal, l'angle le plus proche de l'axe */
+        if (score > best_score || (score == best_score && fabs(deg) < fabs(best))) {
+            best_score = score;
+            best = deg;
+        }
+    }
+    return best;
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int force(const int *acc, int st, int ed)
+{
+    int v = 0;
+    for (int r = st; r <= ed; ++r)
+        if (acc[r] > v) v = acc[r];
+    return v;
+}
+
+/* Chapeau haut-de-forme : chaque case moins le plus haut des deux fonds voisins (cases
+ * a 3..6 de distance). Un trait donne un pic etroit et reste ; les lettres d'une ligne de
+ * la grille et le bruit donnent un plateau large et s'effacent. */
+static void chapeau(const int *acc, int n, int *out)
+{
+    for (int r = 0; r < n; ++r) {
+        int g = 0, d = 0;
+        for (int k = HOUGH_FOND_MIN; k <= HOUGH_FOND_MAX; ++k) {
+            g += r - k >= 0 ? acc[r - k] : 0;
+            d += r + k < n ? acc[r + k] : 0;
+        }
+        int fond = (g > d ? g : d) / (HOUGH_FOND_MAX - HOUGH_FOND_MIN + 1);
+        out[r] = acc[r] > fond ? acc[r] - fond : 0;
+    }
+}
+
+/* Traits = plages de rho au-dessus du seuil : 55% du maximum comme les profils de
+ * projection, mais au moins 15% de la longueur D seulement (30% pour les profils), car un
+ * trait fin tourne puis binarise sort en pointilles. Les deux bords d'un trait epais
+ * donnent deux plages proches : elles sont fusionnees. */
+static int peaks(const int *acc, int nrho, int rmax, int centre, int D, int **out)
+{
+    int maxv = 0;
+    for (int r = 0; r < nrho; ++r)
+        if (acc[r] > maxv) maxv = acc[r];
+    if (maxv == 0) return -1;
+    int t = (int)(maxv * 0.55);
+    if (t < (int)(D * 0.15)) t = (int)(D * 0.15);
+
+    int *st = malloc((size_t)nrho * sizeof(int));
+    int *ed = malloc((size_t)nrho * sizeof(int));
+    if (!st || !ed) {
+        free(st);
+        free(ed);
+        return -1;
+    }
+    int n = 0, s = -1;
+    for (int r = 0; r <= nrho; ++r) {
+        int on = r < nrho && acc[r] >= t;
+        if (on && s < 0) s = r;
+        else if (!on && s >= 0) {
+            st[n] = s;
+            ed[n++] = r - 1;
+            s = -1;
+        }
+    }
+
+    int m = 0;
+    for (int i = 0; i < n; ++i) {
+        if (m > 0 && st[i] - ed[m - 1] <= HOUGH_FUSION) {
+            ed[m - 1] = ed[i];
+        } else {
+            st[m] = st[i];
+            ed[m++] = ed[i];
+        }
+    }
+    /* Les traits d'une grille sont regulierement espaces : une plage plus proche de sa
+     * voisine que 0.6 fois l'ecart median (jambages alignes d'une colonne de I ou de L)
+     * cede la place a la plus forte des deux. */
+    if (m > 2) {
+        int *gaps = malloc((size_t)(m - 1) * sizeof(int));
+        if (gaps) {
+            for (int i = 1; i < m; ++i) gaps[i - 1] = st[i] - st[i - 1];
+            qsort(gaps, (size_t)(m - 1), sizeof(int), cmp_int);
+            int med = gaps[(m - 1) / 2];
+            free(gaps);
+            int k = 0;
+            for (int i = 0; i < m; ++i) {
+                if (k > 0 && (st[i] + ed[i]) - (st[k - 1] + ed[k - 1]) < (int)(1.2 * med)) {
+                    if (force(acc, st[i], ed[i]) > force(acc, st[k - 1], ed[k - 1])) {
+                        st[k - 1] = st[i];
+                        ed[k - 1] = ed[i];
+                    }
+                } else {
+                    st[k] = st[i];
+                    ed[k++] = ed[i];
+                }
+            }
+            m = k;
+        }
+    }
+    if (m < 2) {
+        free(st);
+        free(ed);
+        return -1;
+    }
+    /* st[] recoit les positions : milieu de la plage, rho ramene au repere redresse */
+    for (int i = 0; i < m; ++i) st[i] = centre + (st[i] + ed[i]) / 2 - rmax;
+    free(ed);
+    *out = st;
+    return m;
+}
+
+/* Recherche grossiere sur deg +- tol puis fine autour du meilleur ; avec un angle connu
+ * (tol petit) seule la passe fine reste. */
+static int famille(const HoughEdges *e, int horizontal, double deg, double tol, int centre, int D,
+                   int *acc, int *pics, double *angle, int **pos)
+{
+    double a = deg;
+    if (tol > HOUGH_COARSE_STEP) a = best_angle(e, horizontal, deg - tol, deg + tol, HOUGH_COARSE_STEP, acc);
+    const double f = tol < HOUGH_COARSE_STEP ? tol : HOUGH_COARSE_STEP;
+    a = best_angle(e, horizontal, a - f, a + f, HOUGH_FINE_STEP, acc);
+    double c, s;
+    normale(horizontal, a * M_PI / 180.0, &c, &s);
+    vote(e, c, s, acc);
+    *angle = a;
+    chapeau(acc, e->nrho, pics);
+    return peaks(pics, e->nrho, e->rmax, centre, D, pos);
+}
+
+int hough_grid_lines(const unsigned char *pix, int w, int h, size_t stride, double max_deg,
+                     HoughGrid *out)
+{
+    return hough_grid_lines_near(pix, w, h, stride, 0.0, max_deg, out);
+}
+
+int hough_grid_lines_near(const unsigned char *pix, int w, int h, size_t stride, double deg, double tol,
+                          HoughGrid *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!pix || w < 3 || h < 3 || stride < (size_t)w) return -1;
+    HoughEdges e;
+    if (collect_edges(pix, w, h, stride, &e) != 0) return -1;
+    int *acc = malloc((size_t)e.nrho * sizeof(int));
+    int *pics = malloc((size_t)e.nrho * sizeof(int));
+    int rc = -1;
+    if (acc && pics && e.n > 0) {
+        out->cx = w / 2;
+        out->cy = h / 2;
+        out->ncols = famille(&e, 0, deg, tol, out->cx, h, acc, pics, &out->angle_v, &out->cols);
+        out->nrows = famille(&e, 1, deg, tol, out->cy, w, acc, pics, &out->angle_h, &out->rows);
+        rc = out->ncols >= 2 && out->nrows >= 2 ? 0 : -1;
+    }
+    free(acc);
+    free(pics);
+    free(e.dx);
+    free(e.dy);
+    if (rc != 0) hough_free(out);
+    return rc;
+}
+
+/* u - cx = (x - cx) cos av + (y - cy) sin av
+ * v - cy = -(x - cx) sin ah + (y - cy) cos ah, inverse par Cramer */
+void hough_affine(const HoughGrid *g, double m[6])
+{
+    double av = g->angle_v * M_PI / 180.0, ah = g->angle_h * M_PI / 180.0;
+    double det = cos(av - ah);
+    m[1] = cos(ah) / det;
+    m[2] = -sin(av) / det;
+    m[4] = sin(ah) / det;
+    m[5] = cos(av) / det;
+    m[0] = g->cx - m[1] * g->cx - m[2] * g->cy;
+    m[3] = g->cy - m[4] * g->cx - m[5] * g->cy;
+}
+
+void hough_map(const HoughGrid *g, double u, double v, double *x, double *y)
+{
+    double m[6];
+    hough_affine(g, m);
+    *x = m[0] + m[1] * u + m[2] * v;
+    *y = m[3] + m[4] * u + m[5] * v;
+}
+
+void hough_free(HoughGrid *g)
+{
+    if (!g) return;
+    free(g->cols);
+    free(g->rows);
+    memset(g, 0, sizeof(*g));
+}
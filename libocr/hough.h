@@ -0,0 +1,40 @@
+#ifndef HOUGH_H
+#define HOUGH_H
+
+#include <stddef.h>
+
+/* Lignes de grille par transformee de Hough, pour les grilles tournees ou bruitees.
+ * Seuls les pixels de bord (encre avec un voisin blanc en 4-connexite) votent, dans un
+ * accumulateur entier, et seulement pour deux familles d'angles : traits presque
+ * verticaux et presque horizontaux, chacune a +-max_deg degres de l'axe.
+ *
+ * Les positions sont donnees dans le repere redresse (u, v) centre sur (cx, cy) :
+ * cols[] sont des abscisses u, rows[] des ordonnees v, comme les positions renvoyees
+ * par les profils de projection. Sans rotation, (u, v) = (x, y). */
+
+typedef struct {
+    double angle_v;   /* ecart des traits verticaux a la verticale, degres */
+    double angle_h;   /* ecart des traits horizontaux a l'horizontale, degres */
+    int cx, cy;
+    int *cols;
+    int ncols;
+    int *rows;
+    int nrows;
+} HoughGrid;
+
+/* Pixel d'encre : valeur 0. Renvoie 0 si chaque famille a au moins deux traits. */
+int hough_grid_lines(const unsigned char *pix, int w, int h, size_t stride, double max_deg,
+                     HoughGrid *out);
+
+/* Meme recherche limitee a deg +- tol degres, pour un angle deja connu (0 <= tol). */
+int hough_grid_lines_near(const unsigned char *pix, int w, int h, size_t stride, double deg, double tol,
+                          HoughGrid *out);
+
+/* Point (u, v) du repere redresse -> point (x, y) de l'image. */
+void hough_map(const HoughGrid *g, double u, double v, double *x, double *y);
+/* La meme transformation : x = m[0] + m[1] u + m[2] v, y = m[3] + m[4] u + m[5] v. */
+void hough_affine(const HoughGrid *g, double m[6]);
+
+void hough_free(HoughGrid *g);
+
+#endif
@@ -0,0 +1,92 @@
+#include "ocr.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitimg.h"
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+int ocr_image_init(OcrImage *img, int width, int height, int channels)
+{
+    memset(img, 0, sizeof(*img));
+    if (width <= 0 || height <= 0 || (channels != 1 && channels != 4)) return -1;
+    size_t stride = (size_t)width * (size_t)channels;
+    img->pixels = malloc(stride * (size_t)height);
+    if (!img->pixels) return -1;
+    img->width = width;
+    img->height = height;
+    img->channels = channels;
+    img->stride = stride;
+    return 0;
+}
+
+void ocr_image_free(OcrImage *img)
+{
+    if (!img) return;
+    free(img->pixels);
+    memset(img, 0, sizeof(*img));
+}
+
+static int gray_to_channels(unsigned char *gray, int w, int h, int channels, OcrImage *img)
+{
+    if (channels == 1) {
+        img->width = w;
+        img->height = h;
+        img->channels = 1;
+        img->stride = (size_t)w;
+        img->pixels = gray;
+        return 0;
+    }
+    if (ocr_image_init(img, w, h, 4) != 0) {
+        free(gray);
+        return -1;
+    }
+    size_t n = (size_t)w * (size_t)h;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char *p = img->pixels + i * 4;
+        p[0] = p[1] = p[2] = gray[i];
+        p[3] = 255;
+    }
+    free(gray);
+    return 0;
+}
+
+int ocr_image_load(const char *path, int channels, OcrImage *img)
+{
+    memset(img, 0, sizeof(*img));
+    if (channels != 1 && channels != 4) return -1;
+
+    int w, h, comp;
+    if (bitimg_is_file(path)) {
+        unsigned char *gray = bitimg_load_gray(path, &w, &h);
+        if (!gray) return -1;
+        return gray_to_channels(gray, w, h, channels, img);
+    }
+
+    unsigned char *px = stbi_load(path, &w, &h, &comp, channels);
+    if (!px) return -1;
+    img->width = w;
+    img->height = h;
+    img->channels = channels;
+    img->stride = (size_t)w * (size_t)channels;
+    img->pixels = px;
+    return 0;
+}
+
+int ocr_image_save_png(const char *path, const OcrImage *img)
+{
+    return stbi_write_png(path, img->width, img->height, img->channels, img->pixels,
+                          (int)img->stride) ? 0 : -1;
+}
+
+int ocr_image_crop(const OcrImage *src, int x0, int y0, int width, int height, OcrImage *dst)
+{
+    if (x0 < 0 || y0 < 0 || x0 + width > src->width || y0 + height > src->height) return -1;
+    if (ocr_image_init(dst, width, height, src->channels) != 0) return -1;
+    size_t row = (size_t)width * (size_t)src->channels;
+    for (int y = 0; y < height; ++y)
+        memcpy(dst->pixels + (size_t)y * dst->stride,
+               src->pixels + (size_t)(y0 + y) * src->stride + (size_t)x0 * (size_t)src->channels, row);
+    return 0;
+}
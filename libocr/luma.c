@@ -0,0 +1,263 @@
+#include "luma.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LUMA_X86 1
+#include <immintrin.h>
+#endif
+
+static inline unsigned char luma_px(const unsigned char *px)
+{
+    unsigned int r = px[0], g = px[1], b = px[2], a = px[3];
+
+    r = (r * a + 255u * (255u - a)) / 255u;
+    g = (g * a + 255u * (255u - a)) / 255u;
+    b = (b * a + 255u * (255u - a)) / 255u;
+
+    unsigned int y8 = (unsigned int)(0.299 * r + 0.587 * g + 0.114 * b + 0.5);
+    if (y8 > 255u) y8 = 255u;
+    return (unsigned char)y8;
+}
+
+void luma_rgba_hist_scalar(const unsigned char *rgba, size_t n, unsigned char *gray, unsigned int hist[256])
+{
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char y8 = luma_px(rgba + i * 4);
+        gray[i] = y8;
+        hist[y8]++;
+    }
+}
+
+/* Version entiere : s = 299r + 587g + 114b + 500, y = s / 1000 via
+ * (s * LUMA_MAGIC) >> 32. Quand s est un multiple exact de 1000 la formule
+ * double peut tomber juste en dessous, ces blocs (rares) repassent par le scalaire.
+ * Le reste du produit (32 bits bas) est < 2^21 exactement dans ce cas. */
+#define LUMA_MAGIC 4294968u
+#define LUMA_EXACT_BITS 21
+
+static void hist_block(const unsigned char *gray, size_t n, unsigned int sub[4][256])
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        sub[0][gray[i + 0]]++;
+        sub[1][gray[i + 1]]++;
+        sub[2][gray[i + 2]]++;
+        sub[3][gray[i + 3]]++;
+    }
+    for (; i < n; ++i)
+        sub[0][gray[i]]++;
+}
+
+static void hist_merge(unsigned int sub[4][256], unsigned int hist[256])
+{
+    for (int t = 0; t < 256; ++t)
+        hist[t] += sub[0][t] + sub[1][t] + sub[2][t] + sub[3][t];
+}
+
+#ifdef LUMA_X86
+
+__attribute__((target("sse2")))
+static inline __m128i composite_sse2(__m128i v)
+{
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i rgb_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_one = _mm_set_epi16(1, 0, 0, 0, 1, 0, 0, 0);
+
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(v, a),
+                              _mm_mullo_epi16(c255, _mm_sub_epi16(c255, a)));
+    x = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8);
+    return _mm_or_si128(_mm_and_si128(x, rgb_mask), alpha_one);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i luma2_sse2(__m128i v16, __m128i *miss)
+{
+    const __m128i coef = _mm_set_epi16(500, 114, 587, 299, 500, 114, 587, 299);
+    const __m128i magic = _mm_set1_epi32((int)LUMA_MAGIC);
+    const __m128i odd = _mm_set_epi32(1, 0, 1, 0);
+
+    __m128i s = _mm_madd_epi16(composite_sse2(v16), coef);
+    s = _mm_add_epi32(s, _mm_srli_epi64(s, 32));
+    __m128i p = _mm_mul_epu32(s, magic);
+    __m128i exact = _mm_or_si128(_mm_srli_epi32(p, LUMA_EXACT_BITS), odd);
+    *miss = _mm_or_si128(*miss, _mm_cmpeq_epi32(exact, _mm_setzero_si128()));
+    return _mm_shuffle_epi32(_mm_srli_epi64(p, 32), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i luma4_sse2(const unsigned char *rgba, __m128i *miss)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i px = _mm_loadu_si128((const __m128i *)rgba);
+    __m128i lo = luma2_sse2(_mm_unpacklo_epi8(px, zero), miss);
+    __m128i hi = luma2_sse2(_mm_unpackhi_epi8(px, zero), miss);
+    return _mm_unpacklo_epi64(lo, hi);
+}
+
+__attribute__((target("sse2")))
+static void luma_rgba_hist_sse2(const unsigned char *rgba, size_t n, unsigned char *gray, unsigned int hist[256])
+{
+    unsigned int sub[4][256];
+    memset(sub, 0, sizeof(sub));
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const unsigned char *src = rgba + i * 4;
+        __m128i miss = _mm_setzero_si128();
+        __m128i y0 = luma4_sse2(src, &miss);
+        __m128i y1 = luma4_sse2(src + 16, &miss);
+        __m128i y2 = luma4_sse2(src + 32, &miss);
+        __m128i y3 = luma4_sse2(src + 48, &miss);
+        __m128i y = _mm_packus_epi16(_mm_packs_epi32(y0, y1), _mm_packs_epi32(y2, y3));
+        _mm_storeu_si128((__m128i *)(gray + i), y);
+        if (_mm_movemask_epi8(miss)) {
+            for (size_t k = 0; k < 16; ++k)
+                gray[i + k] = luma_px(src + k * 4);
+        }
+        hist_block(gray + i, 16, sub);
+    }
+    for (; i < n; ++i) {
+        unsigned char y8 = luma_px(rgba + i * 4);
+        gray[i] = y8;
+        sub[0][y8]++;
+    }
+    hist_merge(sub, hist);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i composite_avx2(__m256i v)
+{
+    const __m256i c255 = _mm256_set1_epi16(255);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i rgb_mask = _mm256_set1_epi64x(0x0000FFFFFFFFFFFFLL);
+    const __m256i alpha_one = _mm256_set1_epi64x(0x0001000000000000LL);
+
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0xFF), 0xFF);
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(v, a),
+                                 _mm256_mullo_epi16(c255, _mm256_sub_epi16(c255, a)));
+    x = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, one), _mm256_srli_epi16(x, 8)), 8);
+    return _mm256_or_si256(_mm256_and_si256(x, rgb_mask), alpha_one);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i luma2_avx2(__m256i v16, __m256i *miss)
+{
+    const __m256i coef = _mm256_set1_epi64x(0x01F40072024B012BLL);
+    const __m256i magic = _mm256_set1_epi32((int)LUMA_MAGIC);
+    const __m256i odd = _mm256_set1_epi64x(0x0000000100000000LL);
+
+    __m256i s = _mm256_madd_epi16(composite_avx2(v16), coef);
+    s = _mm256_add_epi32(s, _mm256_srli_epi64(s, 32));
+    __m256i p = _mm256_mul_epu32(s, magic);
+    __m256i exact = _mm256_or_si256(_mm256_srli_epi32(p, LUMA_EXACT_BITS), odd);
+    *miss = _mm256_or_si256(*miss, _mm256_cmpeq_epi32(exact, _mm256_setzero_si256()));
+    return _mm256_shuffle_epi32(_mm256_srli_epi64(p, 32), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i luma8_avx2(const unsigned char *rgba, __m256i *miss)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i px = _mm256_loadu_si256((const __m256i *)rgba);
+    __m256i lo = luma2_avx2(_mm256_unpacklo_epi8(px, zero), miss);
+    __m256i hi = luma2_avx2(_mm256_unpackhi_epi8(px, zero), miss);
+    return _mm256_unpacklo_epi64(lo, hi);
+}
+
+__attribute__((target("avx2")))
+static void luma_rgba_hist_avx2(const unsigned char *rgba, size_t n, unsigned char *gray, unsigned int hist[256])
+{
+    unsigned int sub[4][256];
+    memset(sub, 0, sizeof(sub));
+
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const unsigned char *src = rgba + i * 4;
+        __m256i miss = _mm256_setzero_si256();
+        __m256i y0 = luma8_avx2(src, &miss);
+        __m256i y1 = luma8_avx2(src + 32, &miss);
+        __m256i y2 = luma8_avx2(src + 64, &miss);
+        __m256i y3 = luma8_avx2(src + 96, &miss);
+        __m256i y = _mm256_packus_epi16(_mm256_packs_epi32(y0, y1), _mm256_packs_epi32(y2, y3));
+        y = _mm256_permutevar8x32_epi32(y, order);
+        _mm256_storeu_si256((__m256i *)(gray + i), y);
+        if (_mm256_movemask_epi8(miss)) {
+            for (size_t k = 0; k < 32; ++k)
+                gray[i + k] = luma_px(src + k * 4);
+        }
+        hist_block(gray + i, 32, sub);
+    }
+    if (i < n) {
+        luma_rgba_hist_sse2(rgba + i * 4, n - i, gray + i, hist);
+    }
+    hist_merge(sub, hist);
+}
+
+#endif
+
+typedef void (*LumaFn)(const unsigned char *, size_t, unsigned char *, unsigned int *);
+
+static LumaKernel g_kernel = LUMA_KERNEL_AUTO;
+static LumaFn g_fn = NULL;
+
+static int kernel_supported(LumaKernel k)
+{
+    switch (k) {
+    case LUMA_KERNEL_SCALAR:
+        return 1;
+#ifdef LUMA_X86
+    case LUMA_KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case LUMA_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int luma_select(LumaKernel kernel)
+{
+    if (kernel == LUMA_KERNEL_AUTO) {
+        if (kernel_supported(LUMA_KERNEL_AVX2)) kernel = LUMA_KERNEL_AVX2;
+        else if (kernel_supported(LUMA_KERNEL_SSE2)) kernel = LUMA_KERNEL_SSE2;
+        else kernel = LUMA_KERNEL_SCALAR;
+    }
+    if (!kernel_supported(kernel)) return -1;
+
+    switch (kernel) {
+#ifdef LUMA_X86
+    case LUMA_KERNEL_SSE2: g_fn = luma_rgba_hist_sse2; break;
+    case LUMA_KERNEL_AVX2: g_fn = luma_rgba_hist_avx2; break;
+#endif
+    default: g_fn = luma_rgba_hist_scalar; break;
+    }
+    g_kernel = kernel;
+    return 0;
+}
+
+LumaKernel luma_active_kernel(void)
+{
+    if (!g_fn) luma_select(LUMA_KERNEL_AUTO);
+    return g_kernel;
+}
+
+const char *luma_kernel_name(LumaKernel kernel)
+{
+    switch (kernel) {
+    case LUMA_KERNEL_SCALAR: return "scalar";
+    case LUMA_KERNEL_SSE2: return "sse2";
+    case LUMA_KERNEL_AVX2: return "avx2";
+    default: return "auto";
+    }
+}
+
+void luma_rgba_hist(const unsigned char *rgba, size_t n, unsigned char *gray, unsigned int hist[256])
+{
+    if (!g_fn) luma_select(LUMA_KERNEL_AUTO);
+    g_fn(rgba, n, gray, hist);
+}
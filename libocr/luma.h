@@ -0,0 +1,22 @@
+#ifndef LUMA_H
+#define LUMA_H
+
+#include <stddef.h>
+
+typedef enum {
+    LUMA_KERNEL_AUTO = 0,
+    LUMA_KERNEL_SCALAR,
+    LUMA_KERNEL_SSE2,
+    LUMA_KERNEL_AVX2
+} LumaKernel;
+
+/* RGBA (alpha composite sur blanc) -> luma 8 bits, et ajoute chaque pixel a hist.
+ * Le resultat est identique bit a bit a la formule double 0.299/0.587/0.114. */
+void luma_rgba_hist(const unsigned char *rgba, size_t n, unsigned char *gray, unsigned int hist[256]);
+void luma_rgba_hist_scalar(const unsigned char *rgba, size_t n, unsigned char *gray, unsigned int hist[256]);
+
+int luma_select(LumaKernel kernel);
+LumaKernel luma_active_kernel(void);
+const char *luma_kernel_name(LumaKernel kernel);
+
+#endif
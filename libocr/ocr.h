@@ -0,0 +1,177 @@
+#ifndef OCR_H
+#define OCR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "adaptive.h"
+#include "arena.h"
+#include "rle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Image 8 bits en memoire, channels = 1 (gris) ou 4 (RGBA), lignes de stride octets. */
+typedef struct {
+    int width;
+    int height;
+    int channels;
+    size_t stride;
+    unsigned char *pixels;
+} OcrImage;
+
+int ocr_image_init(OcrImage *img, int width, int height, int channels);
+void ocr_image_free(OcrImage *img);
+/* PNG/JPEG/BMP via stb_image ou format 1 bit (bitimg.h), converti en channels canaux. */
+int ocr_image_load(const char *path, int channels, OcrImage *img);
+int ocr_image_save_png(const char *path, const OcrImage *img);
+int ocr_image_crop(const OcrImage *src, int x0, int y0, int width, int height, OcrImage *dst);
+
+/* ---- Binarisation ---- */
+
+typedef enum {
+    OCR_THRESHOLD_OTSU = 0,
+    OCR_THRESHOLD_FIXED,
+    OCR_THRESHOLD_ADAPTIVE
+} OcrThresholdMode;
+
+typedef struct {
+    OcrThresholdMode mode;
+    int threshold;
+    AdaptiveOptions adaptive;
+    int threads;       /* histogramme sur plusieurs threads (<= 0 : un par coeur) */
+    double sample_eps; /* > 0 : Otsu sur un echantillon, ecart de repartition <= eps (histogram.h) */
+} OcrBinarizeOptions;
+
+void ocr_binarize_default_options(OcrBinarizeOptions *opts);
+int ocr_otsu_threshold(const unsigned int hist[256], unsigned long long total);
+/* src gris ou RGBA -> bw gris 0/255. threshold_out recoit le seuil global utilise (-1 en adaptatif). */
+int ocr_binarize(const OcrImage *src, OcrImage *bw, const OcrBinarizeOptions *opts, int *threshold_out);
+/* Meme binarisation, plus les segments d'encre de bw (rle.h) codes une seule fois, a passer
+ * au decoupage et a l'extraction des mots (ocr_*_runs). runs a liberer avec rle_free. */
+int ocr_binarize_runs(const OcrImage *src, OcrImage *bw, RleImage *runs, const OcrBinarizeOptions *opts,
+                      int *threshold_out);
+
+/* ---- Decoupage de la grille ---- */
+
+#define OCR_TILE_SIZE 32
+
+typedef struct {
+    int row;
+    int col;
+    int x0, y0, x1, y1; /* case dans l'image binarisee, bornes incluses */
+    OcrImage img;
+} OcrTile;
+
+/* fallback = 1 si la grille n'a pas de lignes : les cases viennent des composantes connexes
+ * et row peut sauter des indices (lignes ecartees). */
+typedef struct {
+    OcrTile *tiles;
+    size_t count;
+    size_t cap;
+    int fallback;
+    size_t scratch_peak; /* octets de travail au plus haut (arena.h), pour les rapports */
+} OcrTileSet;
+
+int ocr_split_grid(const OcrImage *bw, OcrTileSet *out);
+/* Cases copiees et normalisees sur nthreads threads (<= 0 : un par coeur), meme resultat. */
+int ocr_split_grid_mt(const OcrImage *bw, OcrTileSet *out, int nthreads);
+/* Grille inclinee de angle_deg degres (sens trigonometrique) : l'image n'est pas tournee,
+ * chaque case est echantillonnee dans la source par une transformation affine. */
+int ocr_split_grid_angle(const OcrImage *bw, OcrTileSet *out, int nthreads, double angle_deg);
+/* runs : segments de bw deja codes (ocr_binarize_runs), reutilises par le repli sur les
+ * composantes connexes ; NULL pour les coder ici si besoin. */
+int ocr_split_grid_runs(const OcrImage *bw, const RleImage *runs, OcrTileSet *out, int nthreads);
+/* Meme chose avec l'arene de l'appelant (angle_deg NULL : detecte), videe par arena_reset
+ * au debut : les boucles sur plusieurs images la gardent d'une image a l'autre (NULL :
+ * arene locale). Les lots de cases paralleles (nthreads > 1) ont toujours chacun la leur. */
+int ocr_split_grid_scratch(const OcrImage *bw, const RleImage *runs, const double *angle_deg,
+                           OcrTileSet *out, int nthreads, Arena *scratch);
+void ocr_tiles_free(OcrTileSet *set);
+
+/* ---- Extraction de la liste de mots ---- */
+
+typedef struct {
+    OcrImage *letters;
+    int count;
+} OcrWord;
+
+typedef struct {
+    OcrWord *words;
+    size_t count;
+    size_t cap;
+    size_t scratch_peak; /* octets de travail au plus haut (arena.h) */
+} OcrWordSet;
+
+int ocr_extract_words(const OcrImage *bw, OcrWordSet *out);
+/* Composantes des mots etiquetees sur runs (segments de bw) sans relire les pixels. */
+int ocr_extract_words_runs(const OcrImage *bw, const RleImage *runs, OcrWordSet *out);
+/* Avec l'arene de l'appelant, videe par arena_reset au debut (cf. ocr_split_grid_scratch). */
+int ocr_extract_words_scratch(const OcrImage *bw, const RleImage *runs, OcrWordSet *out, Arena *scratch);
+void ocr_words_free(OcrWordSet *set);
+
+/* ---- Reconnaissance ---- */
+
+typedef struct {
+    int input_dim;
+    int hidden_dim;
+    int output_dim;
+    float *W1;
+    float *b1;
+    float *W2;
+    float *b2;
+    int tile_w;
+    int tile_h;
+    void *map;      /* poids binaires projetes en memoire (weights.h), sinon NULL */
+    size_t map_len;
+    float *W1t;     /* W1 transposee : input_dim lignes de hidden_dim (entree binaire) ; lue dans
+                     * le fichier binaire, calculee au chargement du texte */
+    float *W1sum;   /* b1 + somme de chaque ligne de W1 : reponse a une tuile toute blanche */
+    int8_t *Q1t;    /* modele int8 (weights.h) : W1t quantifiee, colonne j a l'echelle s1[j] */
+    float *s1;
+    int8_t *Q2;     /* W2 quantifiee, ligne k a l'echelle s2[k] ; W1, b1, W2 et W1t sont NULL */
+    float *s2;
+} OcrModel;
+
+/* Texte (weights.txt) ou binaire (weights.h), reconnu a l'en-tete. */
+int ocr_model_load(const char *weights_path, OcrModel *model);
+void ocr_model_free(OcrModel *model);
+/* Recadre la lettre et la remet a l'echelle tile_w x tile_h (1.0 = fond, 0.0 = encre). */
+int ocr_tile_vector(const OcrModel *model, const OcrImage *tile, float *vec);
+char ocr_predict(const OcrModel *model, const float *vec);
+/* Reference en float ; scores[output_dim] recoit les sorties du reseau si non NULL. */
+char ocr_predict_scores(const OcrModel *model, const float *vec, float *scores);
+
+/* Meme tuile sur 1 bit par pixel : bit i de bits[i / 64] = encre (entree 0.0). */
+#define OCR_BITS_WORDS(n) (((size_t)(n) + 63) / 64)
+int ocr_tile_bits(const OcrModel *model, const OcrImage *tile, uint64_t *bits);
+/* Premiere couche en retirant de W1sum les seules lignes de W1t des pixels d'encre. */
+char ocr_predict_bits(const OcrModel *model, const uint64_t *bits, float *scores);
+/* n tuiles a la suite (OCR_BITS_WORDS(input_dim) mots chacune) par lots : chaque bloc de W1t
+ * sert a tout un lot. letters[n] ; scores[n x output_dim] si non NULL. Modele int8 : meme
+ * chemin en arithmetique entiere. */
+int ocr_predict_bits_batch(const OcrModel *model, const uint64_t *bits, size_t n, char *letters,
+                           float *scores);
+/* Toutes les cases d'un coup : letters[count], conf[count] (meilleur score) si non NULL. */
+int ocr_recognize_tiles(const OcrModel *model, const OcrTileSet *tiles, char *letters, float *conf);
+char ocr_recognize_tile(const OcrModel *model, const OcrImage *tile);
+/* Grille rows x cols (ligne par ligne, '?' pour les cases manquantes), a liberer avec free. */
+char *ocr_recognize_grid(const OcrModel *model, const OcrTileSet *tiles, int *rows, int *cols);
+char *ocr_recognize_word(const OcrModel *model, const OcrWord *word);
+
+/* ---- Resolution ---- */
+
+typedef struct {
+    unsigned int x;
+    unsigned int y;
+} OcrCoord;
+
+int ocr_search_word(const char *grid, unsigned int rows, unsigned int cols,
+                    const char *word, OcrCoord *start, OcrCoord *end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
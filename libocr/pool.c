@@ -0,0 +1,138 @@
+#define _POSIX_C_SOURCE 200809L
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct PoolItem {
+    PoolTask fn;
+    void *arg;
+    struct PoolItem *next;
+} PoolItem;
+
+struct Pool {
+    pthread_mutex_t lock;
+    pthread_cond_t has_work;
+    pthread_cond_t idle;
+    PoolItem *head;
+    PoolItem *tail;
+    int pending;
+    int stopping;
+    int nthreads;
+    pthread_t *threads;
+};
+
+static void *pool_worker(void *arg)
+{
+    Pool *pool = (Pool *)arg;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->head && !pool->stopping)
+            pthread_cond_wait(&pool->has_work, &pool->lock);
+        if (!pool->head && pool->stopping)
+            break;
+
+        PoolItem *it = pool->head;
+        pool->head = it->next;
+        if (!pool->head) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        it->fn(it->arg);
+        free(it);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0)
+            pthread_cond_broadcast(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int pool_default_threads(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > 64) n = 64;
+    return (int)n;
+}
+
+Pool *pool_create(int nthreads)
+{
+    if (nthreads <= 0) nthreads = pool_default_threads();
+    Pool *pool = calloc(1, sizeof(Pool));
+    if (!pool) return NULL;
+    pool->threads = calloc((size_t)nthreads, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_work, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < nthreads; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool) != 0)
+            break;
+        pool->nthreads++;
+    }
+    if (pool->nthreads == 0) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int pool_submit(Pool *pool, PoolTask fn, void *arg)
+{
+    PoolItem *it = malloc(sizeof(PoolItem));
+    if (!it) return -1;
+    it->fn = fn;
+    it->arg = arg;
+    it->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail) pool->tail->next = it;
+    else pool->head = it;
+    pool->tail = it;
+    pool->pending++;
+    pthread_cond_signal(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void pool_wait(Pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int pool_size(const Pool *pool)
+{
+    return pool ? pool->nthreads : 0;
+}
+
+void pool_destroy(Pool *pool)
+{
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->has_work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->nthreads; ++i)
+        pthread_join(pool->threads[i], NULL);
+
+    PoolItem *it = pool->head;
+    while (it) {
+        PoolItem *next = it->next;
+        free(it);
+        it = next;
+    }
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->has_work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,16 @@
+#ifndef POOL_H
+#define POOL_H
+
+typedef struct Pool Pool;
+typedef void (*PoolTask)(void *arg);
+
+/* Pool de threads a taille fixe ; les taches sont executees dans l'ordre de soumission. */
+Pool *pool_create(int nthreads);
+int pool_submit(Pool *pool, PoolTask fn, void *arg);
+void pool_wait(Pool *pool);
+void pool_destroy(Pool *pool);
+int pool_size(const Pool *pool);
+
+int pool_default_threads(void);
+
+#endif
@@ -0,0 +1,119 @@
+#include "projection.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define PROJ_MAX_THREADS 64
+#define PROJ_MIN_PIXELS_PER_THREAD (1u << 20)
+/* un compteur 8 bits par colonne deborderait apres 255 lignes */
+#define PROJ_BLOCK_ROWS 255
+
+typedef struct {
+    const unsigned char *pix;
+    int w;
+    size_t stride;
+    int y0, y1;
+    int *rows;
+    int *cols;
+    uint8_t *acc;
+} ProjBand;
+
+static void flush_cols(int *cols, uint8_t *acc, int w)
+{
+    for (int x = 0; x < w; ++x) cols[x] += acc[x];
+    memset(acc, 0, (size_t)w);
+}
+
+static int count_row(const unsigned char *row, int w, uint8_t *acc)
+{
+    int x = 0, n = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = _mm_setzero_si128();
+    for (; x + 16 <= w; x += 16) {
+        __m128i ink = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(row + x)), zero);
+        __m128i a = _mm_loadu_si128((const __m128i *)(acc + x));
+        /* ink vaut 0xFF = -1 : a - ink = a + 1 */
+        _mm_storeu_si128((__m128i *)(acc + x), _mm_sub_epi8(a, ink));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_and_si128(ink, _mm_set1_epi8(1)), zero));
+    }
+    n = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+#endif
+    for (; x < w; ++x) {
+        int ink = row[x] == 0;
+        acc[x] += (uint8_t)ink;
+        n += ink;
+    }
+    return n;
+}
+
+static void *proj_band(void *arg)
+{
+    ProjBand *b = (ProjBand *)arg;
+    int block = 0;
+    for (int y = b->y0; y < b->y1; ++y) {
+        b->rows[y] = count_row(b->pix + (size_t)y * b->stride, b->w, b->acc);
+        if (++block == PROJ_BLOCK_ROWS) {
+            flush_cols(b->cols, b->acc, b->w);
+            block = 0;
+        }
+    }
+    if (block) flush_cols(b->cols, b->acc, b->w);
+    return NULL;
+}
+
+int proj_ink_counts(const unsigned char *pix, int w, int h, size_t stride, int *rows, int *cols,
+                    int nthreads)
+{
+    if (!pix || !rows || !cols || w <= 0 || h <= 0) return -1;
+    if (nthreads <= 0) nthreads = pool_default_threads();
+    if (nthreads > PROJ_MAX_THREADS) nthreads = PROJ_MAX_THREADS;
+    size_t useful = (size_t)w * (size_t)h / PROJ_MIN_PIXELS_PER_THREAD;
+    if (useful < 1) useful = 1;
+    if ((size_t)nthreads > useful) nthreads = (int)useful;
+    if (nthreads > h) nthreads = h;
+
+    /* bande 0 : colonnes directement dans cols ; les autres dans leur propre tableau */
+    int *scratch = nthreads > 1 ? calloc((size_t)(nthreads - 1) * (size_t)w, sizeof(int)) : NULL;
+    uint8_t *acc = calloc((size_t)nthreads * (size_t)w, 1);
+    if (!acc || (nthreads > 1 && !scratch)) {
+        free(scratch);
+        free(acc);
+        return -1;
+    }
+    memset(cols, 0, (size_t)w * sizeof(int));
+
+    ProjBand bands[PROJ_MAX_THREADS];
+    for (int i = 0; i < nthreads; ++i) {
+        bands[i] = (ProjBand){
+            .pix = pix, .w = w, .stride = stride,
+            .y0 = (int)((long long)h * i / nthreads),
+            .y1 = (int)((long long)h * (i + 1) / nthreads),
+            .rows = rows,
+            .cols = i == 0 ? cols : scratch + (size_t)(i - 1) * (size_t)w,
+            .acc = acc + (size_t)i * (size_t)w,
+        };
+    }
+
+    pthread_t tids[PROJ_MAX_THREADS];
+    int started[PROJ_MAX_THREADS] = {0};
+    for (int i = 1; i < nthreads; ++i)
+        started[i] = pthread_create(&tids[i], NULL, proj_band, &bands[i]) == 0;
+    proj_band(&bands[0]);
+    for (int i = 1; i < nthreads; ++i) {
+        if (started[i]) pthread_join(tids[i], NULL);
+        else proj_band(&bands[i]);
+        for (int x = 0; x < w; ++x) cols[x] += bands[i].cols[x];
+    }
+    free(scratch);
+    free(acc);
+    return 0;
+}
@@ -0,0 +1,13 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <stddef.h>
+
+/* Profils de projection d'une image noir/blanc : rows[y] et cols[x] recoivent le nombre
+ * de pixels a 0 (encre) de la ligne y et de la colonne x. Un seul passage ligne par ligne
+ * remplit les deux ; les bandes de lignes sont reparties sur nthreads threads (<= 0 : un
+ * par coeur), chacun avec ses propres compteurs de colonnes additionnes a la fin. */
+int proj_ink_counts(const unsigned char *pix, int w, int h, size_t stride, int *rows, int *cols,
+                    int nthreads);
+
+#endif
@@ -0,0 +1,453 @@
+#include "ocr.h"
+#include "dense.h"
+#include "resample.h"
+#include "weights.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int infer_tile_dims(int input_dim, int *out_w, int *out_h)
+{
+    if (input_dim <= 0) return 0;
+    int root = (int)(sqrt((double)input_dim) + 0.5);
+    if (root * root == input_dim) {
+        *out_w = root;
+        *out_h = root;
+        return 1;
+    }
+    for (int h = 1; h <= root + 1; ++h) {
+        if (input_dim % h == 0) {
+            *out_h = h;
+            *out_w = input_dim / h;
+            return 1;
+        }
+    }
+    *out_w = input_dim;
+    *out_h = 1;
+    return 1;
+}
+
+static float sigmoid(float x) {
+    return 1.0f / (1.0f + expf(-x));
+}
+
+/* Entree binaire : x_i = 1 (fond) sauf aux pixels d'encre, donc
+ * b1 + W1 x = W1sum - somme des colonnes de W1 aux pixels d'encre. */
+static int prepare_model(OcrModel *m) {
+    dense_active_kernel(); /* choix des noyaux d'apres le CPU, une fois pour toutes */
+    if (m->map) return 0;  /* fichier binaire : W1t et W1sum y sont deja */
+    const size_t idim = (size_t)m->input_dim, hdim = (size_t)m->hidden_dim;
+    m->W1t = (float *)malloc(sizeof(float) * idim * hdim);
+    m->W1sum = (float *)malloc(sizeof(float) * hdim);
+    if (!m->W1t || !m->W1sum) return -1;
+    weights_transpose(m, m->W1t, m->W1sum);
+    return 0;
+}
+
+void ocr_model_free(OcrModel *m) {
+    if (!m) return;
+    if (!m->map) {
+        free(m->W1t);
+        free(m->W1sum);
+    }
+    m->W1t = m->W1sum = NULL;
+    if (m->map) {
+        weights_unmap(m);
+        return;
+    }
+    free(m->W1);
+    free(m->b1);
+    free(m->W2);
+    free(m->b2);
+    memset(m, 0, sizeof(*m));
+}
+
+int ocr_model_load(const char *weights_path, OcrModel *m) {
+    memset(m, 0, sizeof(*m));
+    if (weights_is_binary(weights_path)) {
+        if (weights_map(weights_path, m) != 0) {
+            fprintf(stderr, "Invalid binary weights: %s\n", weights_path);
+            return -1;
+        }
+        infer_tile_dims(m->input_dim, &m->tile_w, &m->tile_h);
+        if (prepare_model(m) != 0) {
+            fprintf(stderr, "Memory allocation failed for weights\n");
+            ocr_model_free(m);
+            return -1;
+        }
+        return 0;
+    }
+    FILE *f = fopen(weights_path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open weights: %s\n", weights_path);
+        return -1;
+    }
+
+    if (fscanf(f, "%d %d %d", &m->input_dim, &m->hidden_dim, &m->output_dim) != 3) {
+        fprintf(stderr, "Invalid weights header\n");
+        fclose(f);
+        return -1;
+    }
+
+    size_t w1_sz = (size_t)m->input_dim * (size_t)m->hidden_dim;
+    size_t w2_sz = (size_t)m->hidden_dim * (size_t)m->output_dim;
+    m->W1 = (float *)malloc(sizeof(float) * w1_sz);
+    m->b1 = (float *)malloc(sizeof(float) * (size_t)m->hidden_dim);
+    m->W2 = (float *)malloc(sizeof(float) * w2_sz);
+    m->b2 = (float *)malloc(sizeof(float) * (size_t)m->output_dim);
+    if (!m->W1 || !m->b1 || !m->W2 || !m->b2) {
+        fprintf(stderr, "Memory allocation failed for weights\n");
+        fclose(f);
+        ocr_model_free(m);
+        return -1;
+    }
+
+    for (size_t i = 0; i < w1_sz; ++i) {
+        if (fscanf(f, "%f", &m->W1[i]) != 1) {
+            fprintf(stderr, "Invalid W1 entry\n");
+            goto fail;
+        }
+    }
+    for (int i = 0; i < m->hidden_dim; ++i) {
+        if (fscanf(f, "%f", &m->b1[i]) != 1) {
+            fprintf(stderr, "Invalid b1 entry\n");
+            goto fail;
+        }
+    }
+    for (size_t i = 0; i < w2_sz; ++i) {
+        if (fscanf(f, "%f", &m->W2[i]) != 1) {
+            fprintf(stderr, "Invalid W2 entry\n");
+            goto fail;
+        }
+    }
+    for (int i = 0; i < m->output_dim; ++i) {
+        if (fscanf(f, "%f", &m->b2[i]) != 1) {
+            fprintf(stderr, "Invalid b2 entry\n");
+            goto fail;
+        }
+    }
+
+    fclose(f);
+    if (!infer_tile_dims(m->input_dim, &m->tile_w, &m->tile_h)) {
+        fprintf(stderr, "Cannot infer tile dimensions from weights\n");
+        ocr_model_free(m);
+        return -1;
+    }
+    if (prepare_model(m) != 0) {
+        fprintf(stderr, "Memory allocation failed for weights\n");
+        ocr_model_free(m);
+        return -1;
+    }
+    return 0;
+
+fail:
+    fclose(f);
+    ocr_model_free(m);
+    return -1;
+}
+
+int ocr_tile_vector(const OcrModel *m, const OcrImage *tile, float *vec) {
+    if (!tile || !tile->pixels || tile->channels != 1) return -1;
+    const size_t len = (size_t)m->tile_w * (size_t)m->tile_h;
+    unsigned char local[OCR_TILE_SIZE * OCR_TILE_SIZE];
+    unsigned char *norm = len <= sizeof(local) ? local : malloc(len);
+    if (!norm) return -1;
+    int rc = resample_letter(tile->pixels, tile->width, tile->height, tile->stride, m->tile_w,
+                             m->tile_h, 1, RESAMPLE_INVERT, norm, NULL);
+    if (rc == 0)
+        for (size_t i = 0; i < len; ++i) vec[i] = norm[i] ? 1.0f : 0.0f;
+    if (norm != local) free(norm);
+    return rc;
+}
+
+int ocr_tile_bits(const OcrModel *m, const OcrImage *tile, uint64_t *bits) {
+    if (!tile || !tile->pixels || tile->channels != 1) return -1;
+    const size_t len = (size_t)m->tile_w * (size_t)m->tile_h;
+    unsigned char local[OCR_TILE_SIZE * OCR_TILE_SIZE];
+    unsigned char *norm = len <= sizeof(local) ? local : malloc(len);
+    if (!norm) return -1;
+    int rc = resample_letter(tile->pixels, tile->width, tile->height, tile->stride, m->tile_w,
+                             m->tile_h, 1, RESAMPLE_INVERT, norm, NULL);
+    if (rc == 0) {
+        memset(bits, 0, OCR_BITS_WORDS(len) * sizeof(uint64_t));
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(norm + i));
+            uint64_t ink = (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+            bits[i >> 6] |= ink << (i & 63);
+        }
+#endif
+        for (; i < len; ++i)
+            if (!norm[i]) bits[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+    if (norm != local) free(norm);
+    return rc;
+}
+
+static char meilleure_lettre(const float *scores, int odim) {
+    int best = 0;
+    float best_val = -1.0e9f;
+    for (int k = 0; k < odim; ++k) {
+        if (scores[k] > best_val) {
+            best_val = scores[k];
+            best = k;
+        }
+    }
+    if (best >= 0 && best < 26) {
+        return (char)('A' + best);
+    }
+    return '?';
+}
+
+char ocr_predict_scores(const OcrModel *m, const float *input, float *scores) {
+    if (!m->W1 || !m->W2) {
+        return '?';
+    }
+
+    int hdim = m->hidden_dim;
+    int odim = m->output_dim;
+    int idim = m->input_dim;
+
+    float *hidden = (float *)malloc(sizeof(float) * (size_t)hdim);
+    float *output = (float *)malloc(sizeof(float) * (size_t)odim);
+    if (!hidden || !output) {
+        free(hidden);
+        free(output);
+        return '?';
+    }
+
+    for (int j = 0; j < hdim; ++j) {
+        float s = m->b1[j];
+        const float *wrow = &m->W1[(size_t)j * (size_t)idim];
+        for (int i = 0; i < idim; ++i) {
+            s += wrow[i] * input[i];
+        }
+        hidden[j] = sigmoid(s);
+    }
+
+    for (int k = 0; k < odim; ++k) {
+        float s = m->b2[k];
+        const float *wrow = &m->W2[(size_t)k * (size_t)hdim];
+        for (int j = 0; j < hdim; ++j) {
+            s += wrow[j] * hidden[j];
+        }
+        output[k] = sigmoid(s);
+    }
+
+    char c = meilleure_lettre(output, odim);
+    if (scores) memcpy(scores, output, sizeof(float) * (size_t)odim);
+    free(hidden);
+    free(output);
+    return c;
+}
+
+char ocr_predict(const OcrModel *m, const float *input) {
+    return ocr_predict_scores(m, input, NULL);
+}
+
+/* Lot de cases traitees ensemble. Premiere couche : h = W1sum - somme des lignes de W1t
+ * aux pixels d'encre, par tranches gardees en registres ; deuxieme couche : un produit
+ * H W2^T ou chaque morceau de ligne de W2 sert a 4 cases. 32 x 96 floats de couche
+ * cachee = 12 Ko. */
+#define LOT_CASES 32
+
+/* Indices des pixels d'encre d'une tuile, dans l'ordre. */
+static int pixels_encre(const uint64_t *x, size_t words, uint16_t *idx) {
+    int nidx = 0;
+    for (size_t w = 0; w < words; ++w)
+        for (uint64_t v = x[w]; v; v &= v - 1) idx[nidx++] = (uint16_t)(w * 64 + (size_t)__builtin_ctzll(v));
+    return nidx;
+}
+
+/* Modele int8 : memes lots. Premiere couche en sommes entieres des lignes de Q1t aux pixels
+ * d'encre (W1t tient en 96 Ko au lieu de 384), deuxieme couche en produits u8 x s8 sur la
+ * couche cachee ramenee a 0..WEIGHTS_Q8_HIDDEN. */
+static int predict_bits_batch_q8(const OcrModel *m, const uint64_t *bits, size_t n, char *letters,
+                                 float *scores) {
+    const size_t hdim = (size_t)m->hidden_dim, odim = (size_t)m->output_dim;
+    const size_t idim = (size_t)m->input_dim, words = OCR_BITS_WORDS(idim);
+    if (idim > 65536) return -1;
+    float *hidden = (float *)malloc(sizeof(float) * LOT_CASES * (hdim + odim));
+    int32_t *acc = (int32_t *)malloc(sizeof(int32_t) * LOT_CASES * (hdim > odim ? hdim : odim));
+    uint8_t *hq = (uint8_t *)malloc(LOT_CASES * hdim);
+    uint16_t *idx = (uint16_t *)malloc(sizeof(uint16_t) * idim);
+    if (!hidden || !acc || !hq || !idx) {
+        free(hidden);
+        free(acc);
+        free(hq);
+        free(idx);
+        return -1;
+    }
+    float *out = hidden + LOT_CASES * hdim;
+    const DenseOps *k = dense_ops(DENSE_KERNEL_AUTO);
+
+    for (size_t t0 = 0; t0 < n; t0 += LOT_CASES) {
+        const size_t nb = n - t0 < LOT_CASES ? n - t0 : LOT_CASES;
+        for (size_t b = 0; b < nb; ++b) {
+            int nidx = pixels_encre(bits + (t0 + b) * words, words, idx);
+            k->sum_rows_i8(m->Q1t, hdim, idx, nidx, acc, (int)hdim);
+            float *h = hidden + b * hdim;
+            for (size_t j = 0; j < hdim; ++j) h[j] = m->W1sum[j] - m->s1[j] * (float)acc[j];
+        }
+        k->bias_sigmoid(hidden, NULL, (int)(nb * hdim));
+        for (size_t i = 0; i < nb * hdim; ++i) hq[i] = (uint8_t)(hidden[i] * WEIGHTS_Q8_HIDDEN + 0.5f);
+        k->gemm_u8i8(hq, hdim, (int)nb, m->Q2, hdim, (int)odim, (int)hdim, acc, odim);
+        for (size_t b = 0; b < nb; ++b) {
+            float *o = out + b * odim;
+            for (size_t j = 0; j < odim; ++j)
+                o[j] = m->s2[j] * (1.0f / WEIGHTS_Q8_HIDDEN) * (float)acc[b * odim + j];
+            k->bias_sigmoid(o, m->b2, (int)odim);
+            letters[t0 + b] = meilleure_lettre(o, (int)odim);
+            if (scores) memcpy(scores + (t0 + b) * odim, o, sizeof(float) * odim);
+        }
+    }
+    free(hidden);
+    free(acc);
+    free(hq);
+    free(idx);
+    return 0;
+}
+
+int ocr_predict_bits_batch(const OcrModel *m, const uint64_t *bits, size_t n, char *letters,
+                           float *scores) {
+    if (m->Q1t) return predict_bits_batch_q8(m, bits, n, letters, scores);
+    if (!m->W1t || !m->W2) return -1;
+    const size_t hdim = (size_t)m->hidden_dim, odim = (size_t)m->output_dim;
+    const size_t idim = (size_t)m->input_dim, words = OCR_BITS_WORDS(idim);
+    if (idim > 65536) return -1;
+    float *hidden = (float *)malloc(sizeof(float) * LOT_CASES * (hdim + odim));
+    uint16_t *idx = (uint16_t *)malloc(sizeof(uint16_t) * idim);
+    if (!hidden || !idx) {
+        free(hidden);
+        free(idx);
+        return -1;
+    }
+    float *out = hidden + LOT_CASES * hdim;
+    const DenseOps *k = dense_ops(DENSE_KERNEL_AUTO);
+
+    for (size_t t0 = 0; t0 < n; t0 += LOT_CASES) {
+        const size_t nb = n - t0 < LOT_CASES ? n - t0 : LOT_CASES;
+        for (size_t b = 0; b < nb; ++b) {
+            int nidx = pixels_encre(bits + (t0 + b) * words, words, idx);
+            k->sub_rows(m->W1t, hdim, idx, nidx, m->W1sum, hidden + b * hdim, (int)hdim);
+        }
+        k->bias_sigmoid(hidden, NULL, (int)(nb * hdim));
+        k->gemm_nt(hidden, hdim, (int)nb, m->W2, hdim, (int)odim, (int)hdim, out, odim);
+        for (size_t b = 0; b < nb; ++b) {
+            k->bias_sigmoid(out + b * odim, m->b2, (int)odim);
+            letters[t0 + b] = meilleure_lettre(out + b * odim, (int)odim);
+            if (scores) memcpy(scores + (t0 + b) * odim, out + b * odim, sizeof(float) * odim);
+        }
+    }
+    free(hidden);
+    free(idx);
+    return 0;
+}
+
+char ocr_predict_bits(const OcrModel *m, const uint64_t *bits, float *scores) {
+    char c;
+    return ocr_predict_bits_batch(m, bits, 1, &c, scores) == 0 ? c : '?';
+}
+
+/* Meilleur score de chaque case si conf n'est pas NULL. */
+static int recognize_images(const OcrModel *m, const OcrImage *const *imgs, size_t n, char *letters,
+                            float *conf) {
+    if (n == 0) return 0;
+    const size_t words = OCR_BITS_WORDS(m->input_dim), odim = (size_t)m->output_dim;
+    uint64_t *bits = (uint64_t *)calloc(words * n, sizeof(uint64_t));
+    unsigned char *ok = (unsigned char *)malloc(n);
+    float *scores = conf ? (float *)malloc(sizeof(float) * odim * n) : NULL;
+    if (!bits || !ok || (conf && !scores)) {
+        free(bits);
+        free(ok);
+        free(scores);
+        return -1;
+    }
+    /* une case illisible reste toute blanche et ressort en '?' */
+    for (size_t i = 0; i < n; ++i) ok[i] = ocr_tile_bits(m, imgs[i], bits + i * words) == 0;
+    int rc = ocr_predict_bits_batch(m, bits, n, letters, scores);
+    for (size_t i = 0; rc == 0 && i < n; ++i) {
+        float best = 0.0f;
+        for (size_t k = 0; conf && k < odim; ++k)
+            if (scores[i * odim + k] > best) best = scores[i * odim + k];
+        if (!ok[i]) {
+            letters[i] = '?';
+            best = 0.0f;
+        }
+        if (conf) conf[i] = best;
+    }
+    free(bits);
+    free(ok);
+    free(scores);
+    return rc;
+}
+
+int ocr_recognize_tiles(const OcrModel *m, const OcrTileSet *tiles, char *letters, float *conf) {
+    const OcrImage **imgs = (const OcrImage **)malloc(sizeof(OcrImage *) * (tiles->count ? tiles->count : 1));
+    if (!imgs) return -1;
+    for (size_t i = 0; i < tiles->count; ++i) imgs[i] = &tiles->tiles[i].img;
+    int rc = recognize_images(m, imgs, tiles->count, letters, conf);
+    free(imgs);
+    return rc;
+}
+
+char ocr_recognize_tile(const OcrModel *m, const OcrImage *tile) {
+    char c;
+    return recognize_images(m, &tile, 1, &c, NULL) == 0 ? c : '?';
+}
+
+char *ocr_recognize_grid(const OcrModel *m, const OcrTileSet *tiles, int *rows, int *cols) {
+    if (!tiles || tiles->count == 0) return NULL;
+    int max_row = -1, max_col = -1;
+    for (size_t i = 0; i < tiles->count; ++i) {
+        if (tiles->tiles[i].row > max_row) max_row = tiles->tiles[i].row;
+        if (tiles->tiles[i].col > max_col) max_col = tiles->tiles[i].col;
+    }
+    int r = max_row + 1, c = max_col + 1;
+    char *grid = (char *)malloc((size_t)r * (size_t)c);
+    if (!grid) return NULL;
+    memset(grid, '?', (size_t)r * (size_t)c);
+    char *letters = (char *)malloc(tiles->count);
+    if (!letters || ocr_recognize_tiles(m, tiles, letters, NULL) != 0) {
+        free(letters);
+        free(grid);
+        return NULL;
+    }
+    for (size_t i = 0; i < tiles->count; ++i) {
+        const OcrTile *t = &tiles->tiles[i];
+        grid[(size_t)t->row * (size_t)c + (size_t)t->col] = letters[i];
+    }
+    free(letters);
+    *rows = r;
+    *cols = c;
+    return grid;
+}
+
+char *ocr_recognize_word(const OcrModel *m, const OcrWord *word) {
+    if (!word || word->count <= 0) return NULL;
+    char *buffer = (char *)malloc((size_t)word->count + 1);
+    const OcrImage **imgs = (const OcrImage **)malloc(sizeof(OcrImage *) * (size_t)word->count);
+    if (!buffer || !imgs) {
+        free(buffer);
+        free(imgs);
+        return NULL;
+    }
+    for (int i = 0; i < word->count; ++i) imgs[i] = &word->letters[i];
+    if (recognize_images(m, imgs, (size_t)word->count, buffer, NULL) != 0) {
+        free(buffer);
+        buffer = NULL;
+    } else {
+        buffer[word->count] = '\0';
+    }
+    free(imgs);
+    return buffer;
+}
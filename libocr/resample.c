@@ -0,0 +1,191 @@
+#include "resample.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* compteurs de colonnes 8 bits, vides toutes les 255 lignes */
+#define RESAMPLE_BLOCK_ROWS 255
+
+static int count_dark(const unsigned char *row, int n, uint8_t *acc)
+{
+    int x = 0, dark = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lim = _mm_set1_epi8((char)(RESAMPLE_SOMBRE - 1));
+    __m128i sum = _mm_setzero_si128();
+    for (; x + 16 <= n; x += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(row + x));
+        /* v < 200 <=> min(v, 199) == v */
+        __m128i d = _mm_cmpeq_epi8(_mm_min_epu8(v, lim), v);
+        __m128i a = _mm_loadu_si128((const __m128i *)(acc + x));
+        _mm_storeu_si128((__m128i *)(acc + x), _mm_sub_epi8(a, d));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_and_si128(d, _mm_set1_epi8(1)), zero));
+    }
+    dark = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+#endif
+    for (; x < n; ++x) {
+        int d = row[x] < RESAMPLE_SOMBRE;
+        acc[x] += (uint8_t)d;
+        dark += d;
+    }
+    return dark;
+}
+
+/* Profils des pixels sombres du rectangle [x0, x1] x [y0, y1] : rows[y], cols[x]. */
+static void profils(const unsigned char *src, size_t stride, int x0, int y0, int x1, int y1,
+                    int *rows, int *cols, uint8_t *acc)
+{
+    const int n = x1 - x0 + 1;
+    if (n <= 0) {
+        for (int y = y0; y <= y1; ++y) rows[y] = 0;
+        return;
+    }
+    memset(cols + x0, 0, (size_t)n * sizeof(int));
+    memset(acc, 0, (size_t)n);
+    int block = 0;
+    for (int y = y0; y <= y1; ++y) {
+        rows[y] = count_dark(src + (size_t)y * stride + x0, n, acc);
+        if (++block == RESAMPLE_BLOCK_ROWS || y == y1) {
+            for (int x = 0; x < n; ++x) cols[x0 + x] += acc[x];
+            memset(acc, 0, (size_t)n);
+            block = 0;
+        }
+    }
+}
+
+/* Indices source de l'axe : lo + round(t / (d - 1) * (b - 1)), calcule exactement comme
+ * l'ancien code pixel par pixel (meme arrondi en double). */
+static void table_indices(int *idx, int d, int lo, int hi, int b)
+{
+    for (int t = 0; t < d; ++t) {
+        double r = (d <= 1) ? 0.0 : (double)t / (double)(d - 1);
+        int s = lo + (int)round(r * (double)(b - 1));
+        if (s < lo) s = lo;
+        if (s > hi) s = hi;
+        idx[t] = s;
+    }
+}
+
+/* Seuil d'une ligne deja echantillonnee : 0 pour la lettre, 255 pour le fond. */
+static void seuil(const unsigned char *in, unsigned char *out, int n, int invert)
+{
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i ones = _mm_set1_epi8((char)0xFF);
+    if (invert) {
+        /* lettre : v > 200 <=> max(v, 201) == v */
+        const __m128i lim = _mm_set1_epi8((char)(RESAMPLE_SOMBRE + 1));
+        for (; x + 16 <= n; x += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(in + x));
+            __m128i l = _mm_cmpeq_epi8(_mm_max_epu8(v, lim), v);
+            _mm_storeu_si128((__m128i *)(out + x), _mm_xor_si128(l, ones));
+        }
+    } else {
+        const __m128i lim = _mm_set1_epi8((char)(RESAMPLE_SOMBRE - 1));
+        for (; x + 16 <= n; x += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(in + x));
+            __m128i l = _mm_cmpeq_epi8(_mm_min_epu8(v, lim), v);
+            _mm_storeu_si128((__m128i *)(out + x), _mm_xor_si128(l, ones));
+        }
+    }
+#endif
+    for (; x < n; ++x) {
+        int letter = invert ? (in[x] > RESAMPLE_SOMBRE) : (in[x] < RESAMPLE_SOMBRE);
+        out[x] = letter ? 0 : 255;
+    }
+}
+
+int resample_letter(const unsigned char *src, int w, int h, size_t stride, int tw, int th,
+                    int margin, int flags, unsigned char *dst, Arena *scratch)
+{
+    if (!src || !dst || w <= 0 || h <= 0 || tw <= 0 || th <= 0 || stride < (size_t)w) return -1;
+    const size_t n_int = ((size_t)h + (size_t)w + (size_t)tw + (size_t)th) * sizeof(int);
+    const size_t n_acc = (size_t)w + (size_t)tw;
+    Arena local;
+    if (!scratch) arena_init(scratch = &local, n_int + n_acc + 32);
+    ArenaMark mark = arena_mark(scratch);
+    int *rows = arena_alloc(scratch, n_int);
+    uint8_t *acc = arena_alloc(scratch, n_acc);
+    if (!rows || !acc) {
+        arena_release(scratch, mark);
+        if (scratch == &local) arena_free(&local);
+        return -1;
+    }
+    int *cols = rows + h;
+    int *sx = cols + w;
+    int *sy = sx + tw;
+    unsigned char *line = acc + w;
+
+    profils(src, stride, 0, 0, w - 1, h - 1, rows, cols, acc);
+
+    int top = 0, bottom = h - 1, left = 0, right = w - 1;
+    if (flags & RESAMPLE_TRIM) {
+        const double border_ratio = 0.98;
+        const int lim_row = (int)(border_ratio * w), lim_col = (int)(border_ratio * h);
+        while (top < h && rows[top] > lim_row) top++;
+        while (bottom >= top && rows[bottom] > lim_row) bottom--;
+        while (left < w && cols[left] > lim_col) left++;
+        while (right >= left && cols[right] > lim_col) right--;
+        /* les profils des bords retires comptaient aussi les pixels du cadre */
+        if (top > 0 || bottom < h - 1 || left > 0 || right < w - 1)
+            profils(src, stride, left, top, right, bottom, rows, cols, acc);
+    }
+
+    int x0 = w, y0 = h, x1 = -1, y1 = -1, dark = 0;
+    for (int y = top; y <= bottom; ++y) {
+        if (!rows[y]) continue;
+        if (y0 == h) y0 = y;
+        y1 = y;
+        dark += rows[y];
+    }
+    for (int x = left; x <= right && y1 >= 0; ++x) {
+        if (!cols[x]) continue;
+        if (x0 == w) x0 = x;
+        x1 = x;
+    }
+    if (x1 < x0 || y1 < y0) {
+        x0 = 0; y0 = 0; x1 = w - 1; y1 = h - 1;
+    }
+    int bw = x1 - x0 + 1;
+    int bh = y1 - y0 + 1;
+
+    double avail_w = (double)(tw - margin * 2);
+    double avail_h = (double)(th - margin * 2);
+    if (avail_w < 1.0) avail_w = (double)tw;
+    if (avail_h < 1.0) avail_h = (double)th;
+    double scale = fmin(avail_w / (double)bw, avail_h / (double)bh);
+    if (scale <= 0.0) scale = 1.0;
+    int dw = (int)(bw * scale + 0.5);
+    int dh = (int)(bh * scale + 0.5);
+    if (dw < 1) dw = 1;
+    if (dh < 1) dh = 1;
+    if (dw > tw) dw = tw;
+    if (dh > th) dh = th;
+    const int offx = (tw - dw) / 2;
+    const int offy = (th - dh) / 2;
+    const int invert = (flags & RESAMPLE_INVERT) && dark > (w * h) / 2;
+
+    table_indices(sx, dw, x0, x1, bw);
+    table_indices(sy, dh, y0, y1, bh);
+
+    memset(dst, 255, (size_t)tw * (size_t)th);
+    for (int ty = 0; ty < dh; ++ty) {
+        unsigned char *out = dst + (size_t)(offy + ty) * tw + offx;
+        /* agrandissement : meme ligne source que la precedente */
+        if (ty > 0 && sy[ty] == sy[ty - 1]) {
+            memcpy(out, out - tw, (size_t)dw);
+            continue;
+        }
+        const unsigned char *row = src + (size_t)sy[ty] * stride;
+        for (int tx = 0; tx < dw; ++tx) line[tx] = row[sx[tx]];
+        seuil(line, out, dw, invert);
+    }
+    arena_release(scratch, mark);
+    if (scratch == &local) arena_free(&local);
+    return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <stddef.h>
+
+#include "arena.h"
+
+/* Normalisation d'une lettre en tuile tw x th, commune au decoupage de la grille, a la
+ * liste de mots et au reseau. Pixel sombre : v < 200. La boite englobante des pixels
+ * sombres est ramenee a l'echelle (plus proche voisin) dans la tuile moins margin pixels
+ * de chaque cote, centree ; le reste de la tuile est blanc. Sortie 0 (lettre) / 255.
+ *
+ * Les bornes viennent des profils de projection, et les indices source de chaque axe sont
+ * calcules une fois par tuile dans une table au lieu d'un round() par pixel. */
+
+#define RESAMPLE_TRIM 1   /* retire les lignes/colonnes de bord sombres a plus de 98% (cadre) */
+#define RESAMPLE_INVERT 2 /* plus de la moitie des pixels sombres : lettre claire sur fond sombre */
+
+#define RESAMPLE_SOMBRE 200
+
+/* Tampons de travail pris dans scratch puis rendus ; NULL : arene temporaire. */
+int resample_letter(const unsigned char *src, int w, int h, size_t stride, int tw, int th,
+                    int margin, int flags, unsigned char *dst, Arena *scratch);
+
+#endif
@@ -0,0 +1,107 @@
+#include "rle.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Une ligne a au plus w / 2 + 1 segments : la place est reservee avant la ligne, les
+ * ecritures ne testent plus la capacite. */
+static int reserve(RleImage *img, size_t n)
+{
+    if (img->count + n <= img->cap) return 0;
+    size_t cap = img->cap ? img->cap * 2 : 1024;
+    while (cap < img->count + n) cap *= 2;
+    RleRun *tmp = realloc(img->runs, cap * sizeof(RleRun));
+    if (!tmp) return -1;
+    img->runs = tmp;
+    img->cap = cap;
+    return 0;
+}
+
+static void encode_row(const unsigned char *row, int w, unsigned char ink_max, RleImage *img)
+{
+    RleRun *out = img->runs + img->count;
+    int x = 0, start = -1;
+#if defined(__SSE2__)
+    const __m128i lim = _mm_set1_epi8((char)ink_max);
+    unsigned prev = 0; /* encre sur le dernier pixel du bloc precedent */
+    for (; x + 16 <= w; x += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(row + x));
+        /* bit i : row[x + i] <= ink_max <=> min(v, ink_max) == v */
+        unsigned m = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, lim), v));
+        /* bit i : le pixel i differe de son voisin de gauche */
+        unsigned edges = (m ^ ((m << 1) | prev)) & 0xFFFFu;
+        prev = m >> 15;
+        while (edges) {
+            int pos = x + __builtin_ctz(edges);
+            edges &= edges - 1;
+            if (start < 0) {
+                start = pos;
+            } else {
+                *out++ = (RleRun){ start, pos - 1 };
+                start = -1;
+            }
+        }
+    }
+#endif
+    for (; x < w; ++x) {
+        int ink = row[x] <= ink_max;
+        if (ink && start < 0) {
+            start = x;
+        } else if (!ink && start >= 0) {
+            *out++ = (RleRun){ start, x - 1 };
+            start = -1;
+        }
+    }
+    if (start >= 0) *out++ = (RleRun){ start, w - 1 };
+    img->count = (size_t)(out - img->runs);
+}
+
+int rle_encode(const unsigned char *pix, int w, int h, size_t stride, int ink_max, RleImage *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!pix || w <= 0 || h <= 0 || stride < (size_t)w) return -1;
+    out->width = w;
+    out->height = h;
+    out->row = malloc(((size_t)h + 1) * sizeof(size_t));
+    if (!out->row) return -1;
+    for (int y = 0; y < h; ++y) {
+        out->row[y] = out->count;
+        if (ink_max < 0) continue;
+        if (reserve(out, (size_t)w / 2 + 1) != 0) {
+            rle_free(out);
+            return -1;
+        }
+        encode_row(pix + (size_t)y * stride, w, (unsigned char)(ink_max > 255 ? 255 : ink_max), out);
+    }
+    out->row[h] = out->count;
+    return 0;
+}
+
+void rle_free(RleImage *img)
+{
+    if (!img) return;
+    free(img->runs);
+    free(img->row);
+    memset(img, 0, sizeof(*img));
+}
+
+/* Colonnes : +1 au debut de chaque segment, -1 apres sa fin, puis somme prefixe. */
+void rle_profiles(const RleImage *img, int *rows, int *cols)
+{
+    memset(cols, 0, (size_t)img->width * sizeof(int));
+    for (int y = 0; y < img->height; ++y) {
+        int n = 0;
+        for (size_t k = img->row[y]; k < img->row[y + 1]; ++k) {
+            const RleRun *r = &img->runs[k];
+            n += r->xe - r->xs + 1;
+            cols[r->xs]++;
+            if (r->xe + 1 < img->width) cols[r->xe + 1]--;
+        }
+        rows[y] = n;
+    }
+    for (int x = 1; x < img->width; ++x) cols[x] += cols[x - 1];
+}
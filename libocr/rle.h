@@ -0,0 +1,32 @@
+#ifndef RLE_H
+#define RLE_H
+
+#include <stddef.h>
+
+/* Image noir/blanc en segments d'encre par ligne, construite une fois apres la
+ * binarisation. Une page de mots meles est surtout blanche : les profils et les
+ * composantes connexes calcules sur les segments coutent en nombre de segments, plus
+ * en nombre de pixels. Le codage lit chaque ligne par blocs de 16 octets : un bloc
+ * sans changement ne coute qu'une comparaison. */
+
+typedef struct {
+    int xs, xe; /* bornes incluses */
+} RleRun;
+
+typedef struct {
+    int width;
+    int height;
+    RleRun *runs;
+    size_t *row; /* segments de la ligne y : runs[row[y]] .. runs[row[y + 1] - 1] */
+    size_t count;
+    size_t cap;
+} RleImage;
+
+/* Pixel d'encre : valeur <= ink_max. */
+int rle_encode(const unsigned char *pix, int w, int h, size_t stride, int ink_max, RleImage *out);
+void rle_free(RleImage *img);
+
+/* rows[y], cols[x] : nombre de pixels d'encre, comme proj_ink_counts. */
+void rle_profiles(const RleImage *img, int *rows, int *cols);
+
+#endif
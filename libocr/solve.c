@@ -1,4 +1,4 @@
-#include "solver.h"
+#include "ocr.h"
 
 #include <ctype.h>
 #include <stddef.h>
@@ -12,8 +12,8 @@ static int match_at(const char *grid,
                     unsigned int y,
                     int dx,
                     int dy,
-                    Coord *start,
-                    Coord *end) {
+                    OcrCoord *start,
+                    OcrCoord *end) {
     unsigned int len = (unsigned int)strlen(word);
     unsigned int cx = x;
     unsigned int cy = y;
@@ -47,12 +47,12 @@ static int match_at(const char *grid,
     return 0;
 }
 
-int search_word(const char *grid,
-                unsigned int rows,
-                unsigned int cols,
-                const char *word,
-                Coord *start,
-                Coord *end) {
+int ocr_search_word(const char *grid,
+                    unsigned int rows,
+                    unsigned int cols,
+                    const char *word,
+                    OcrCoord *start,
+                    OcrCoord *end) {
     if (grid == NULL || word == NULL) {
         return -1;
     }
@@ -100,4 +100,4 @@ int search_word(const char *grid,
     }
 
     return -1;
-}
\ No newline at end of file
+}
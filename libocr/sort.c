@@ -0,0 +1,92 @@
+#include "sort.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void insertion(unsigned char *a, size_t n, size_t size, int (*cmp)(const void *, const void *),
+                      unsigned char *tmp)
+{
+    for (size_t i = 1; i < n; ++i) {
+        size_t j = i;
+        if (cmp(a + (j - 1) * size, a + j * size) <= 0) continue;
+        memcpy(tmp, a + i * size, size);
+        while (j > 0 && cmp(a + (j - 1) * size, tmp) > 0) {
+            memcpy(a + j * size, a + (j - 1) * size, size);
+            --j;
+        }
+        memcpy(a + j * size, tmp, size);
+    }
+}
+
+#define SORT_RUN 16
+
+void sort_stable(void *base, size_t n, size_t size, int (*cmp)(const void *, const void *))
+{
+    if (n < 2 || size == 0) return;
+    unsigned char *a = base;
+    unsigned char one[256];
+    unsigned char *tmp = size <= sizeof(one) ? one : malloc(size);
+    if (!tmp) return;
+
+    /* petits paquets tries par insertion, puis fusions de largeur doublee */
+    for (size_t i = 0; i < n; i += SORT_RUN)
+        insertion(a + i * size, n - i < SORT_RUN ? n - i : SORT_RUN, size, cmp, tmp);
+    unsigned char *buf = n > SORT_RUN ? malloc(n * size) : NULL;
+    if (n > SORT_RUN && !buf) {
+        insertion(a, n, size, cmp, tmp);
+        if (tmp != one) free(tmp);
+        return;
+    }
+    unsigned char *src = a, *dst = buf;
+    for (size_t width = SORT_RUN; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                /* <= : a egalite l'element de gauche passe en premier */
+                if (cmp(src + i * size, src + j * size) <= 0) memcpy(dst + k++ * size, src + i++ * size, size);
+                else memcpy(dst + k++ * size, src + j++ * size, size);
+            }
+            memcpy(dst + k * size, src + i * size, (mid - i) * size);
+            k += mid - i;
+            memcpy(dst + k * size, src + j * size, (hi - j) * size);
+        }
+        unsigned char *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != a) memcpy(a, src, n * size);
+    free(buf);
+    if (tmp != one) free(tmp);
+}
+
+int sort_by_key(void *base, size_t n, size_t size, int (*key)(const void *), int max_key)
+{
+    if (n < 2) return 0;
+    if (max_key < 0) return -1;
+    unsigned char *a = base;
+    size_t *start = calloc((size_t)max_key + 2, sizeof(size_t));
+    unsigned char *out = malloc(n * size);
+    if (!start || !out) {
+        free(start);
+        free(out);
+        return -1;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        int k = key(a + i * size);
+        if (k < 0 || k > max_key) {
+            free(start);
+            free(out);
+            return -1;
+        }
+        start[k + 1]++;
+    }
+    for (int k = 0; k <= max_key; ++k) start[k + 1] += start[k];
+    for (size_t i = 0; i < n; ++i)
+        memcpy(out + start[key(a + i * size)]++ * size, a + i * size, size);
+    memcpy(a, out, n * size);
+    free(start);
+    free(out);
+    return 0;
+}
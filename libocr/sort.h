@@ -0,0 +1,16 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <stddef.h>
+
+/* Tris stables pour les boites de segmentation : deux elements egaux gardent leur
+ * ordre d'origine (l'ordre de balayage des composantes). */
+
+/* Tri fusion, O(n log n). Sans memoire disponible, retombe sur un tri par insertion. */
+void sort_stable(void *base, size_t n, size_t size, int (*cmp)(const void *, const void *));
+
+/* Tri par denombrement sur une cle entiere dans [0, max_key], O(n + max_key).
+ * Renvoie -1 (tableau inchange) si une cle sort de l'intervalle ou si la memoire manque. */
+int sort_by_key(void *base, size_t n, size_t size, int (*key)(const void *), int max_key);
+
+#endif
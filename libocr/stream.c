@@ -0,0 +1,236 @@
+#include "stream.h"
+
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitimg.h"
+#include "luma.h"
+
+typedef int (*StripFn)(const unsigned char *rgba, int rows, int w, void *ctx);
+
+static void set_rgba8(png_structp png, png_infop info)
+{
+    png_byte ct = png_get_color_type(png, info);
+    png_byte bd = png_get_bit_depth(png, info);
+    int trns = png_get_valid(png, info, PNG_INFO_tRNS) != 0;
+
+    if (bd == 16) png_set_strip_16(png);
+    if (ct == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
+    if (ct == PNG_COLOR_TYPE_GRAY && bd < 8) png_set_expand_gray_1_2_4_to_8(png);
+    if (trns) png_set_tRNS_to_alpha(png);
+    if (ct == PNG_COLOR_TYPE_GRAY || ct == PNG_COLOR_TYPE_GRAY_ALPHA) png_set_gray_to_rgb(png);
+    if (!(ct & PNG_COLOR_MASK_ALPHA) && !trns) png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+    png_read_update_info(png, info);
+}
+
+static int strip_pass(const char *in_path, int strip_rows, StripFn fn, void *ctx, StreamStats *stats)
+{
+    FILE *f = fopen(in_path, "rb");
+    if (!f) return STREAM_ERROR;
+
+    unsigned char sig[8];
+    if (fread(sig, 1, sizeof(sig), f) != sizeof(sig) || png_sig_cmp(sig, 0, sizeof(sig)) != 0) {
+        fclose(f);
+        return STREAM_UNSUPPORTED;
+    }
+
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info = png ? png_create_info_struct(png) : NULL;
+    if (!info) {
+        png_destroy_read_struct(&png, NULL, NULL);
+        fclose(f);
+        return STREAM_ERROR;
+    }
+
+    unsigned char *volatile strip = NULL;
+    png_bytep *volatile rows = NULL;
+    volatile int rc = STREAM_ERROR;
+
+    if (setjmp(png_jmpbuf(png)))
+        goto done;
+
+    png_init_io(png, f);
+    png_set_sig_bytes(png, sizeof(sig));
+    png_read_info(png, info);
+    if (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE) {
+        rc = STREAM_UNSUPPORTED;
+        goto done;
+    }
+    set_rgba8(png, info);
+
+    int w = (int)png_get_image_width(png, info);
+    int h = (int)png_get_image_height(png, info);
+    int sr = strip_rows > h ? h : strip_rows;
+    if (sr < 1) sr = 1;
+
+    size_t strip_bytes = (size_t)sr * (size_t)w * 4;
+    strip = malloc(strip_bytes);
+    rows = malloc(sizeof(png_bytep) * (size_t)sr);
+    if (!strip || !rows)
+        goto done;
+    for (int i = 0; i < sr; ++i)
+        rows[i] = strip + (size_t)i * (size_t)w * 4;
+
+    if (stats) {
+        stats->width = w;
+        stats->height = h;
+        stats->peak_bytes = strip_bytes + sizeof(png_bytep) * (size_t)sr;
+    }
+
+    for (int y = 0; y < h; y += sr) {
+        int n = (h - y < sr) ? h - y : sr;
+        png_read_rows(png, rows, NULL, (png_uint_32)n);
+        if (fn(strip, n, w, ctx) != 0)
+            goto done;
+    }
+    png_read_end(png, NULL);
+    rc = STREAM_OK;
+
+done:
+    png_destroy_read_struct(&png, &info, NULL);
+    free((void *)rows);
+    free((void *)strip);
+    fclose(f);
+    return rc;
+}
+
+typedef struct {
+    unsigned char *gray;
+    size_t cap;
+    unsigned int *hist;
+    int threshold;
+    png_structp out;
+    BitWriter *raw;
+} StripCtx;
+
+static int ensure_gray(StripCtx *c, size_t n)
+{
+    if (c->cap >= n) return 0;
+    unsigned char *tmp = realloc(c->gray, n);
+    if (!tmp) return -1;
+    c->gray = tmp;
+    c->cap = n;
+    return 0;
+}
+
+static int hist_strip(const unsigned char *rgba, int rows, int w, void *ctx)
+{
+    StripCtx *c = (StripCtx *)ctx;
+    size_t n = (size_t)rows * (size_t)w;
+    if (ensure_gray(c, n) != 0) return -1;
+    luma_rgba_hist(rgba, n, c->gray, c->hist);
+    return 0;
+}
+
+static int threshold_strip(const unsigned char *rgba, int rows, int w, void *ctx)
+{
+    StripCtx *c = (StripCtx *)ctx;
+    size_t n = (size_t)rows * (size_t)w;
+    if (ensure_gray(c, n) != 0) return -1;
+
+    unsigned int unused[256] = {0};
+    luma_rgba_hist(rgba, n, c->gray, unused);
+    for (size_t i = 0; i < n; ++i)
+        c->gray[i] = (c->gray[i] >= c->threshold) ? 255 : 0;
+
+    if (c->raw)
+        return bitimg_writer_rows(c->raw, c->gray, rows);
+    if (setjmp(png_jmpbuf(c->out)))
+        return -1;
+    for (int y = 0; y < rows; ++y)
+        png_write_row(c->out, c->gray + (size_t)y * (size_t)w);
+    return 0;
+}
+
+int stream_png_histogram(const char *in_path, int strip_rows, unsigned int hist[256],
+                         StreamStats *stats)
+{
+    StripCtx c = {0};
+    c.hist = hist;
+    int rc = strip_pass(in_path, strip_rows, hist_strip, &c, stats);
+    if (stats) stats->peak_bytes += c.cap;
+    free(c.gray);
+    return rc;
+}
+
+static int write_pass(const char *in_path, const char *out_path, int strip_rows,
+                      int threshold, StreamStats *volatile st)
+{
+    FILE *f = fopen(out_path, "wb");
+    if (!f) return STREAM_ERROR;
+
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info = png ? png_create_info_struct(png) : NULL;
+    if (!info) {
+        png_destroy_write_struct(&png, NULL);
+        fclose(f);
+        return STREAM_ERROR;
+    }
+
+    StripCtx c = {0};
+    c.threshold = threshold;
+    c.out = png;
+    volatile int rc = STREAM_ERROR;
+
+    if (setjmp(png_jmpbuf(png)))
+        goto done;
+
+    png_init_io(png, f);
+    png_set_IHDR(png, info, (png_uint_32)st->width, (png_uint_32)st->height, 8,
+                 PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
+
+    rc = strip_pass(in_path, strip_rows, threshold_strip, &c, st);
+    if (rc != STREAM_OK)
+        goto done;
+    if (setjmp(png_jmpbuf(png))) {
+        rc = STREAM_ERROR;
+        goto done;
+    }
+    png_write_end(png, NULL);
+    st->peak_bytes += c.cap;
+
+done:
+    png_destroy_write_struct(&png, &info);
+    free(c.gray);
+    fclose(f);
+    return rc;
+}
+
+int stream_png_threshold(const char *in_path, const char *out_path, int strip_rows,
+                         int threshold, StreamStats *stats)
+{
+    StreamStats in = {0};
+    if (!stats) stats = &in;
+    if (stats->width <= 0 || stats->height <= 0) {
+        unsigned int hist[256] = {0};
+        int rc = stream_png_histogram(in_path, 1, hist, stats);
+        if (rc != STREAM_OK) return rc;
+    }
+    return write_pass(in_path, out_path, strip_rows, threshold, stats);
+}
+
+int stream_png_threshold_bits(const char *in_path, const char *out_path, int strip_rows,
+                              int threshold, StreamStats *stats)
+{
+    StreamStats in = {0};
+    if (!stats) stats = &in;
+    if (stats->width <= 0 || stats->height <= 0) {
+        unsigned int hist[256] = {0};
+        int rc = stream_png_histogram(in_path, 1, hist, stats);
+        if (rc != STREAM_OK) return rc;
+    }
+
+    StripCtx c = {0};
+    c.threshold = threshold;
+    c.raw = bitimg_writer_open(out_path, stats->width, stats->height);
+    if (!c.raw) return STREAM_ERROR;
+    int rc = strip_pass(in_path, strip_rows, threshold_strip, &c, stats);
+    if (bitimg_writer_close(c.raw) != 0 && rc == STREAM_OK) rc = STREAM_ERROR;
+    stats->peak_bytes += c.cap + bitimg_stride(stats->width);
+    free(c.gray);
+    return rc;
+}
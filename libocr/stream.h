@@ -0,0 +1,32 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+
+#define STREAM_DEFAULT_STRIP 64
+
+enum {
+    STREAM_OK = 0,
+    STREAM_UNSUPPORTED = 1,
+    STREAM_ERROR = -1
+};
+
+typedef struct {
+    int width;
+    int height;
+    size_t peak_bytes;
+} StreamStats;
+
+/* Binarisation PNG par bandes de strip_rows lignes, en deux lectures du fichier :
+ * d'abord l'histogramme, puis le seuillage avec ecriture ligne a ligne du PNG de sortie.
+ * La memoire ne depend que de la largeur et de strip_rows, pas de la hauteur.
+ * STREAM_UNSUPPORTED : l'entree n'est pas un PNG non entrelace. */
+int stream_png_histogram(const char *in_path, int strip_rows, unsigned int hist[256],
+                         StreamStats *stats);
+int stream_png_threshold(const char *in_path, const char *out_path, int strip_rows,
+                         int threshold, StreamStats *stats);
+/* Meme seuillage, mais sortie au format 1 bit (bitimg.h) au lieu d'un PNG. */
+int stream_png_threshold_bits(const char *in_path, const char *out_path, int strip_rows,
+                              int threshold, StreamStats *stats);
+
+#endif
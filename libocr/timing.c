@@ -0,0 +1,17 @@
+#define _POSIX_C_SOURCE 199309L
+#include "timing.h"
+
+#include <time.h>
+
+double timing_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec * 1e-6;
+}
+
+double timing_keep_best(double best, double t0)
+{
+    double dt = timing_now_ms() - t0;
+    return dt < best ? dt : best;
+}
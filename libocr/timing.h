@@ -0,0 +1,12 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+/* Horloge monotone en millisecondes, pour les benchs et les temps affiches par les outils. */
+double timing_now_ms(void);
+
+/* Boucle du meilleur de N passes : best = timing_keep_best(best, t0) apres chaque passe
+ * demarree a t0 (best part de TIMING_NONE). Renvoie min(best, duree de la passe). */
+#define TIMING_NONE 1e30
+double timing_keep_best(double best, double t0);
+
+#endif
@@ -0,0 +1,218 @@
+#define _POSIX_C_SOURCE 200809L
+#include "weights.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "weights.c lit les float32 petit boutiste sur place"
+#endif
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static size_t align64(size_t n)
+{
+    return (n + 63) / 64 * 64;
+}
+
+static uint32_t checksum(const unsigned char *p, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i + 4 <= len; i += 4) {
+        h ^= get_u32(p + i);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#define MAX_TABLEAUX 6
+
+/* Taille en octets de chaque tableau du type dtype ; renvoie leur nombre (0 : type inconnu). */
+static int tableaux(uint32_t dtype, size_t idim, size_t hdim, size_t odim, size_t sz[MAX_TABLEAUX])
+{
+    if (dtype == WEIGHTS_F32) {
+        const size_t n[6] = { hdim * idim, hdim, odim * hdim, odim, idim * hdim, hdim };
+        for (int k = 0; k < 6; ++k) sz[k] = n[k] * sizeof(float);
+        return 6;
+    }
+    if (dtype == WEIGHTS_I8) {
+        const size_t n[6] = { idim * hdim, hdim * sizeof(float), hdim * sizeof(float), odim * hdim,
+                              odim * sizeof(float), odim * sizeof(float) };
+        memcpy(sz, n, sizeof(n));
+        return 6;
+    }
+    return 0;
+}
+
+/* offsets des tableaux et taille totale du fichier */
+static size_t layout(int count, const size_t sz[], size_t off[])
+{
+    size_t pos = WEIGHTS_HEADER;
+    for (int k = 0; k < count; ++k) {
+        off[k] = pos;
+        pos = align64(pos + sz[k]);
+    }
+    return pos;
+}
+
+static int ecrire(const char *path, uint32_t dtype, const OcrModel *m, const void *const src[])
+{
+    if (m->input_dim <= 0 || m->hidden_dim <= 0 || m->output_dim <= 0) return -1;
+    size_t sz[MAX_TABLEAUX], off[MAX_TABLEAUX];
+    const int count = tableaux(dtype, (size_t)m->input_dim, (size_t)m->hidden_dim, (size_t)m->output_dim, sz);
+    for (int k = 0; k < count; ++k)
+        if (!src[k]) return -1;
+    const size_t len = layout(count, sz, off);
+    unsigned char *buf = calloc(1, len);
+    if (!buf) return -1;
+    for (int k = 0; k < count; ++k) memcpy(buf + off[k], src[k], sz[k]);
+
+    memcpy(buf, WEIGHTS_MAGIC, 4);
+    put_u32(buf + 4, WEIGHTS_VERSION);
+    put_u32(buf + 8, dtype);
+    put_u32(buf + 12, (uint32_t)m->input_dim);
+    put_u32(buf + 16, (uint32_t)m->hidden_dim);
+    put_u32(buf + 20, (uint32_t)m->output_dim);
+    put_u32(buf + 24, checksum(buf + WEIGHTS_HEADER, len - WEIGHTS_HEADER));
+    for (int k = 0; k < count; ++k) put_u32(buf + 28 + 4 * k, (uint32_t)off[k]);
+
+    FILE *f = fopen(path, "wb");
+    int rc = f && fwrite(buf, 1, len, f) == len ? 0 : -1;
+    if (f && fclose(f) != 0) rc = -1;
+    free(buf);
+    return rc;
+}
+
+void weights_transpose(const OcrModel *m, float *W1t, float *W1sum)
+{
+    const size_t idim = (size_t)m->input_dim, hdim = (size_t)m->hidden_dim;
+    for (size_t j = 0; j < hdim; ++j) {
+        const float *wrow = &m->W1[j * idim];
+        double s = m->b1[j];
+        for (size_t i = 0; i < idim; ++i) {
+            W1t[i * hdim + j] = wrow[i];
+            s += wrow[i];
+        }
+        W1sum[j] = (float)s;
+    }
+}
+
+int weights_write(const char *path, const OcrModel *m)
+{
+    if (!m || !m->W1 || !m->b1 || m->input_dim <= 0 || m->hidden_dim <= 0) return -1;
+    float *W1t = m->W1t, *W1sum = m->W1sum;
+    if (!W1t || !W1sum) {
+        W1t = malloc(sizeof(float) * (size_t)m->input_dim * (size_t)m->hidden_dim);
+        W1sum = malloc(sizeof(float) * (size_t)m->hidden_dim);
+        if (W1t && W1sum) weights_transpose(m, W1t, W1sum);
+    }
+    const void *const src[6] = { m->W1, m->b1, m->W2, m->b2, W1t, W1sum };
+    int rc = ecrire(path, WEIGHTS_F32, m, src);
+    if (W1t != m->W1t) free(W1t);
+    if (W1sum != m->W1sum) free(W1sum);
+    return rc;
+}
+
+int weights_write_q8(const char *path, const OcrModel *m)
+{
+    if (!m) return -1;
+    const void *const src[6] = { m->Q1t, m->s1, m->W1sum, m->Q2, m->s2, m->b2 };
+    return ecrire(path, WEIGHTS_I8, m, src);
+}
+
+static int parse_header(const unsigned char *h, size_t len, OcrModel *m)
+{
+    if (len < WEIGHTS_HEADER || memcmp(h, WEIGHTS_MAGIC, 4) != 0) return -1;
+    const uint32_t dtype = get_u32(h + 8);
+    if (get_u32(h + 4) != WEIGHTS_VERSION) return -1;
+    uint32_t idim = get_u32(h + 12), hdim = get_u32(h + 16), odim = get_u32(h + 20);
+    if (idim == 0 || hdim == 0 || odim == 0 || idim > 1u << 20 || hdim > 1u << 16 || odim > 1u << 16)
+        return -1;
+    size_t sz[MAX_TABLEAUX], off[MAX_TABLEAUX];
+    const int count = tableaux(dtype, idim, hdim, odim, sz);
+    if (count == 0 || layout(count, sz, off) != len) return -1;
+    for (int k = 0; k < count; ++k)
+        if (get_u32(h + 28 + 4 * k) != off[k]) return -1;
+    m->input_dim = (int)idim;
+    m->hidden_dim = (int)hdim;
+    m->output_dim = (int)odim;
+    if (dtype == WEIGHTS_I8) {
+        m->Q1t = (int8_t *)(h + off[0]);
+        m->s1 = (float *)(h + off[1]);
+        m->W1sum = (float *)(h + off[2]);
+        m->Q2 = (int8_t *)(h + off[3]);
+        m->s2 = (float *)(h + off[4]);
+        m->b2 = (float *)(h + off[5]);
+        return 0;
+    }
+    m->W1 = (float *)(h + off[0]);
+    m->b1 = (float *)(h + off[1]);
+    m->W2 = (float *)(h + off[2]);
+    m->b2 = (float *)(h + off[3]);
+    m->W1t = (float *)(h + off[4]);
+    m->W1sum = (float *)(h + off[5]);
+    return 0;
+}
+
+int weights_map(const char *path, OcrModel *m)
+{
+    memset(m, 0, sizeof(*m));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < WEIGHTS_HEADER) {
+        close(fd);
+        return -1;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    if (parse_header((const unsigned char *)map, len, m) != 0) {
+        munmap(map, len);
+        memset(m, 0, sizeof(*m));
+        return -1;
+    }
+    m->map = map;
+    m->map_len = len;
+    return 0;
+}
+
+int weights_verify(const OcrModel *m)
+{
+    if (!m || !m->map || m->map_len < WEIGHTS_HEADER) return -1;
+    const unsigned char *h = m->map;
+    return checksum(h + WEIGHTS_HEADER, m->map_len - WEIGHTS_HEADER) == get_u32(h + 24) ? 0 : -1;
+}
+
+void weights_unmap(OcrModel *m)
+{
+    if (m && m->map) munmap(m->map, m->map_len);
+    if (m) memset(m, 0, sizeof(*m));
+}
+
+int weights_is_binary(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    char magic[4];
+    int ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, WEIGHTS_MAGIC, 4) == 0;
+    fclose(f);
+    return ok;
+}
@@ -0,0 +1,60 @@
+#ifndef WEIGHTS_H
+#define WEIGHTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ocr.h"
+
+/* Poids du reseau en binaire, lus par mmap sans aucune conversion (weights.txt : ~100K
+ * nombres en texte a relire a chaque demarrage). En-tete de 64 octets (petit boutiste) :
+ *   0  "OCW1"    magic
+ *   4  u32       version (2)
+ *   8  u32       type des valeurs (1 : float32)
+ *   12 u32       input_dim
+ *   16 u32       hidden_dim
+ *   20 u32       output_dim
+ *   24 u32       somme de controle (FNV-1a sur les mots de 32 bits qui suivent l'en-tete),
+ *                verifiee par weights_verify seulement : la projection ne lit pas tout le fichier
+ *   28 u32       offset de W1 (hidden_dim x input_dim, ligne par ligne)
+ *   32 u32       offset de b1
+ *   36 u32       offset de W2 (output_dim x hidden_dim)
+ *   40 u32       offset de b2
+ *   44 u32       offset de W1t (input_dim x hidden_dim : W1 transposee, pour l'entree binaire)
+ *   48 u32       offset de W1sum (hidden_dim : b1 + somme de la ligne j de W1)
+ * Chaque tableau commence a un multiple de 64 octets, le bourrage est nul.
+ *
+ * Type 2 (int8, ecrit par nn/quantize_weights) : six tableaux, offsets en 28 .. 48.
+ *   Q1t    input_dim x hidden_dim int8 : W1 transposee, colonne j a l'echelle s1[j]
+ *   s1     hidden_dim float
+ *   W1sum  hidden_dim float : b1 + somme de la ligne j de W1, en float
+ *   Q2     output_dim x hidden_dim int8, ligne k a l'echelle s2[k]
+ *   s2, b2 output_dim float
+ * La couche cachee (sigmoide, 0..1) est ramenee a 0..WEIGHTS_Q8_HIDDEN avant Q2. */
+#define WEIGHTS_MAGIC "OCW1"
+#define WEIGHTS_EXT "bin"
+#define WEIGHTS_VERSION 2
+#define WEIGHTS_F32 1
+#define WEIGHTS_I8 2
+#define WEIGHTS_HEADER 64
+#define WEIGHTS_Q8_HIDDEN 127
+
+/* W1t et W1sum sont recalcules depuis W1 et b1 s'ils manquent. */
+int weights_write(const char *path, const OcrModel *model);
+/* Modele quantifie : Q1t, s1, W1sum, Q2, s2 et b2. */
+int weights_write_q8(const char *path, const OcrModel *model);
+
+/* W1t[i][j] = W1[j][i], W1sum[j] = b1[j] + somme de W1[j] (en double). */
+void weights_transpose(const OcrModel *model, float *W1t, float *W1sum);
+
+/* Tous les tableaux pointent dans la projection du fichier, rien n'est copie ;
+ * ocr_model_free la libere. */
+int weights_map(const char *path, OcrModel *model);
+void weights_unmap(OcrModel *model);
+/* Somme de controle du fichier projete : 0 si elle correspond a l'en-tete. */
+int weights_verify(const OcrModel *model);
+
+/* 1 si le fichier commence par WEIGHTS_MAGIC. */
+int weights_is_binary(const char *path);
+
+#endif
@@ -0,0 +1,511 @@
+#include "ocr.h"
+#include "arena.h"
+#include "ccl.h"
+#include "resample.h"
+#include "rle.h"
+#include "sort.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int x0, y0, x1, y1;
+    double yc;
+} Box;
+
+typedef struct {
+    int x0, y0, x1, y1;
+} Rect;
+
+static int rect_cmp(const void *a, const void *b)
+{
+    const Rect *ra = (const Rect *)a;
+    const Rect *rb = (const Rect *)b;
+    if (ra->x0 != rb->x0) return (ra->x0 > rb->x0) - (ra->x0 < rb->x0);
+    return (ra->y0 > rb->y0) - (ra->y0 < rb->y0);
+}
+
+/* yc = (y0 + y1) / 2, donc y0 + y1 trie les boites comme yc avec une cle entiere */
+static int box_key_yc(const void *a)
+{
+    const Box *b = (const Box *)a;
+    return b->y0 + b->y1;
+}
+
+static int box_cmp_yc(const void *a, const void *b)
+{
+    const Box *ba = (const Box *)a;
+    const Box *bb = (const Box *)b;
+    return (ba->yc > bb->yc) - (ba->yc < bb->yc);
+}
+
+static int box_cmp_x0(const void *a, const void *b)
+{
+    const Box *ba = (const Box *)a;
+    const Box *bb = (const Box *)b;
+    return (ba->x0 > bb->x0) - (ba->x0 < bb->x0);
+}
+
+static int cmp_int(const void *a, const void *b) {
+    int aa = *(const int *)a;
+    int bb = *(const int *)b;
+    return (aa > bb) - (aa < bb);
+}
+
+static double median_int(const int *v, int n, Arena *scratch) {
+    if (n <= 0) return 0.0;
+    ArenaMark mark = arena_mark(scratch);
+    int *tmp = arena_alloc(scratch, sizeof(int) * n);
+    if (!tmp) return 0.0;
+    memcpy(tmp, v, sizeof(int) * n);
+    qsort(tmp, n, sizeof(int), cmp_int);
+    double m = (n % 2) ? tmp[n/2] : 0.5 * (tmp[n/2 - 1] + tmp[n/2]);
+    arena_release(scratch, mark);
+    return m;
+}
+
+/* pixel noir : v < 150 */
+#define NOIR_MAX 149
+
+#define WORD_TILE_SIZE 32
+#define WORD_TILE_MARGIN 2
+
+static unsigned char *normalize_letter_bitmap(const unsigned char *src, int w, int h, Arena *scratch)
+{
+    unsigned char *dst = malloc(WORD_TILE_SIZE * WORD_TILE_SIZE);
+    if (!dst) return NULL;
+    if (resample_letter(src, w, h, (size_t)w, WORD_TILE_SIZE, WORD_TILE_SIZE, WORD_TILE_MARGIN, 0,
+                        dst, scratch) != 0) {
+        free(dst);
+        return NULL;
+    }
+    return dst;
+}
+
+/* letters_out est pris dans scratch, comme les tableaux de travail. */
+static int detect_letter_rects(const unsigned char *word, int w, int h, Rect **letters_out,
+                               Arena *scratch)
+{
+    *letters_out = NULL;
+    if (!word || w <= 0 || h <= 0) return 0;
+
+    CclSet cc;
+    if (ccl_label(word, w, h, (size_t)w, NOIR_MAX, 8, &cc) != 0) return 0;
+
+    typedef struct {
+        Rect box;
+        int pixels;
+        double xc, yc;
+        int is_letter;
+    } Component;
+
+    Component *comp = arena_alloc(scratch, sizeof(Component) * (cc.count + 1));
+    if (!comp) {
+        ccl_free(&cc);
+        return 0;
+    }
+
+    int comp_count = 0;
+    for (size_t i = 0; i < cc.count; i++) {
+        const CclComponent *c = &cc.items[i];
+        if (c->pixels < 2) continue;
+
+        comp[comp_count].box.x0 = c->x0;
+        comp[comp_count].box.y0 = c->y0;
+        comp[comp_count].box.x1 = c->x1;
+        comp[comp_count].box.y1 = c->y1;
+        comp[comp_count].pixels = (int)c->pixels;
+        comp[comp_count].xc = (c->x0 + c->x1) / 2.0;
+        comp[comp_count].yc = (c->y0 + c->y1) / 2.0;
+        comp[comp_count].is_letter = 0;
+        comp_count++;
+    }
+    ccl_free(&cc);
+
+    if (comp_count == 0) {
+        Rect *fallback = arena_alloc(scratch, sizeof(Rect));
+        if (!fallback) return 0;
+        fallback[0] = (Rect){0, 0, w > 0 ? w - 1 : 0, h > 0 ? h - 1 : 0};
+        *letters_out = fallback;
+        return 1;
+    }
+
+    int *heights = arena_alloc(scratch, sizeof(int) * comp_count);
+    int *areas = arena_alloc(scratch, sizeof(int) * comp_count);
+    if (!heights || !areas) return 0;
+
+    for (int i = 0; i < comp_count; i++) {
+        heights[i] = comp[i].box.y1 - comp[i].box.y0 + 1;
+        areas[i] = comp[i].pixels;
+    }
+
+    double med_h = median_int(heights, comp_count, scratch);
+    double med_area = median_int(areas, comp_count, scratch);
+    if (med_h < 1.0) med_h = h;
+    if (med_area < 1.0) med_area = w * h;
+
+    double min_letter_h = med_h * 0.45;
+    if (min_letter_h < 3.0) min_letter_h = 3.0;
+    double min_letter_area = med_area * 0.25;
+    if (min_letter_area < 10.0) min_letter_area = 10.0;
+    double keep_area = med_area * 0.08;
+    if (keep_area < 5.0) keep_area = 5.0;
+
+    int letter_count = 0;
+    for (int i = 0; i < comp_count; i++) {
+        if (heights[i] >= (int)min_letter_h || areas[i] >= (int)min_letter_area) {
+            comp[i].is_letter = 1;
+            letter_count++;
+        }
+    }
+
+    if (letter_count == 0) {
+        int max_idx = 0;
+        for (int i = 1; i < comp_count; i++) {
+            if (areas[i] > areas[max_idx]) max_idx = i;
+        }
+        comp[max_idx].is_letter = 1;
+        letter_count = 1;
+    }
+
+    for (int i = 0; i < comp_count; i++) {
+        if (comp[i].is_letter) continue;
+        if (comp[i].pixels < (int)keep_area) continue;
+
+        int best = -1;
+        double best_score = 1e9;
+
+        for (int j = 0; j < comp_count; j++) {
+            if (!comp[j].is_letter) continue;
+
+            double dx = fabs(comp[i].xc - comp[j].xc);
+            double dy = 0.0;
+            if (comp[i].yc < comp[j].yc)
+                dy = comp[j].box.y0 - comp[i].box.y1;
+            else
+                dy = comp[i].box.y0 - comp[j].box.y1;
+            if (dy < 0) dy = 0;
+
+            double score = dx + dy * 1.5;
+            if (score < best_score) {
+                best_score = score;
+                best = j;
+            }
+        }
+
+        if (best >= 0 && best_score < (double)w * 0.8) {
+            Rect *dst = &comp[best].box;
+            Rect *src = &comp[i].box;
+            if (src->x0 < dst->x0) dst->x0 = src->x0;
+            if (src->x1 > dst->x1) dst->x1 = src->x1;
+            if (src->y0 < dst->y0) dst->y0 = src->y0;
+            if (src->y1 > dst->y1) dst->y1 = src->y1;
+            continue;
+        }
+
+        if (comp[i].pixels >= (int)(min_letter_area * 0.4)) {
+            comp[i].is_letter = 1;
+            letter_count++;
+        }
+    }
+
+    if (letter_count == 0) return 0;
+
+    Rect *letters = arena_alloc(scratch, sizeof(Rect) * letter_count);
+    if (!letters) return 0;
+
+    int idx_out = 0;
+    for (int i = 0; i < comp_count; i++) {
+        if (!comp[i].is_letter) continue;
+        letters[idx_out++] = comp[i].box;
+    }
+
+    qsort(letters, letter_count, sizeof(Rect), rect_cmp);
+
+    *letters_out = letters;
+    return letter_count;
+}
+
+static int ajouter_mot(OcrWordSet *set, const unsigned char *word, int w, int h, Arena *scratch)
+{
+    if (!word || w <= 0 || h <= 0) return -1;
+
+    Rect *letters = NULL;
+    int letter_count = detect_letter_rects(word, w, h, &letters, scratch);
+    if (letter_count <= 0) {
+        letters = arena_alloc(scratch, sizeof(Rect));
+        if (!letters) return -1;
+        letters[0].x0 = 0;
+        letters[0].y0 = 0;
+        letters[0].x1 = w - 1;
+        letters[0].y1 = h - 1;
+        letter_count = 1;
+    }
+
+    if (set->count == set->cap) {
+        size_t cap = set->cap ? set->cap * 2 : 16;
+        OcrWord *tmp = realloc(set->words, cap * sizeof(OcrWord));
+        if (!tmp) return -1;
+        set->words = tmp;
+        set->cap = cap;
+    }
+    OcrWord *mot = &set->words[set->count];
+    mot->count = 0;
+    mot->letters = calloc((size_t)letter_count, sizeof(OcrImage));
+    if (!mot->letters) return -1;
+    set->count++;
+
+    for (int i = 0; i < letter_count; i++) {
+        int lx0 = letters[i].x0;
+        int ly0 = letters[i].y0;
+        int lx1 = letters[i].x1;
+        int ly1 = letters[i].y1;
+
+        if (lx0 < 0) lx0 = 0;
+        if (ly0 < 0) ly0 = 0;
+        if (lx1 >= w) lx1 = w - 1;
+        if (ly1 >= h) ly1 = h - 1;
+
+        int lw = lx1 - lx0 + 1;
+        int lh = ly1 - ly0 + 1;
+        if (lw <= 0 || lh <= 0) continue;
+
+        ArenaMark mark = arena_mark(scratch);
+        unsigned char *glyph = arena_alloc(scratch, (size_t)lw * lh);
+        if (!glyph) continue;
+
+        for (int yy = 0; yy < lh; yy++) {
+            memcpy(glyph + yy * lw, word + (ly0 + yy) * w + lx0, lw);
+        }
+
+        unsigned char *norm = normalize_letter_bitmap(glyph, lw, lh, scratch);
+        int nw = WORD_TILE_SIZE, nh = WORD_TILE_SIZE;
+        if (!norm) {
+            /* lettre gardee brute */
+            norm = malloc((size_t)lw * lh);
+            if (norm) memcpy(norm, glyph, (size_t)lw * lh);
+            nw = lw;
+            nh = lh;
+        }
+        arena_release(scratch, mark);
+        if (!norm) continue;
+        OcrImage *img = &mot->letters[mot->count++];
+        img->channels = 1;
+        img->pixels = norm;
+        img->width = nw;
+        img->height = nh;
+        img->stride = (size_t)img->width;
+    }
+
+    return 0;
+}
+
+/* runs : segments de bw deja codes, ou NULL pour les coder ici. */
+static int extraire_mots(const OcrImage *bw, const RleImage *runs, OcrWordSet *out, Arena *scratch) {
+    const unsigned char *pix = bw->pixels;
+    int W = bw->width, H = bw->height;
+
+    RleImage rle;
+    CclSet cc;
+    int rc;
+    if (runs) {
+        rc = ccl_label_runs(runs, 8, &cc);
+    } else {
+        if (rle_encode(pix, W, H, bw->stride, NOIR_MAX, &rle) != 0) return -1;
+        rc = ccl_label_runs(&rle, 8, &cc);
+        rle_free(&rle);
+    }
+    if (rc != 0) return -1;
+    Box *boxes = arena_alloc(scratch, sizeof(Box) * (cc.count + 1));
+    if (!boxes) {
+        ccl_free(&cc);
+        return -1;
+    }
+
+    int nb = 0;
+    for (size_t i = 0; i < cc.count; i++) {
+        const CclComponent *c = &cc.items[i];
+        int w = c->x1 - c->x0 + 1;
+        int h = c->y1 - c->y0 + 1;
+
+        if (w < 3 || h < 3) continue;
+
+        boxes[nb++] = (Box){c->x0,c->y0,c->x1,c->y1,(c->y0+c->y1)/2.0};
+    }
+    ccl_free(&cc);
+
+    if (nb == 0) return 0;
+
+    ArenaMark mark = arena_mark(scratch);
+    int *heights = arena_alloc(scratch, nb * sizeof(int));
+    int *widths  = arena_alloc(scratch, nb * sizeof(int));
+    int *areas   = arena_alloc(scratch, nb * sizeof(int));
+    if (!heights || !widths || !areas) return -1;
+
+    int max_area = 0;
+    int max_idx = 0;
+    for (int i=0;i<nb;i++){
+        int w = boxes[i].x1 - boxes[i].x0 + 1;
+        int h = boxes[i].y1 - boxes[i].y0 + 1;
+        int a = w * h;
+        widths[i] = w;
+        heights[i] = h;
+        areas[i] = a;
+        if (a > max_area) { max_area = a; max_idx = i; }
+    }
+
+    double med_h = median_int(heights, nb, scratch);
+    double med_w = median_int(widths, nb, scratch);
+    double med_area = median_int(areas, nb, scratch);
+
+    Box grid_box = boxes[max_idx];
+    double grid_area = (grid_box.x1 - grid_box.x0 + 1) * (grid_box.y1 - grid_box.y0 + 1);
+
+    int keep = 0;
+    for (int i=0;i<nb;i++){
+        int w = widths[i];
+        int h = heights[i];
+        int a = areas[i];
+
+        if (h < med_h * 0.5 || h > med_h * 2.2) continue;
+        if (w < med_w * 0.35 || w > med_w * 3.5) continue;
+        if (a > med_area * 8.0) continue;
+
+        if (grid_area > med_area * 8.0) {
+            int ix0 = boxes[i].x0 > grid_box.x0 ? boxes[i].x0 : grid_box.x0;
+            int iy0 = boxes[i].y0 > grid_box.y0 ? boxes[i].y0 : grid_box.y0;
+            int ix1 = boxes[i].x1 < grid_box.x1 ? boxes[i].x1 : grid_box.x1;
+            int iy1 = boxes[i].y1 < grid_box.y1 ? boxes[i].y1 : grid_box.y1;
+            int iw = ix1 - ix0 + 1;
+            int ih = iy1 - iy0 + 1;
+            if (iw > 0 && ih > 0) {
+                int inter = iw * ih;
+                if (inter > a * 0.25) continue;
+            }
+        }
+
+        boxes[keep++] = boxes[i];
+    }
+
+    arena_release(scratch, mark);
+
+    nb = keep;
+    if (nb == 0) return 0;
+
+    /* heights/widths refaits sur les boites gardees, dans la place liberee */
+    heights = arena_alloc(scratch, nb * sizeof(int));
+    widths = arena_alloc(scratch, nb * sizeof(int));
+    if (!heights || !widths) return -1;
+    for (int i=0;i<nb;i++){
+        heights[i] = boxes[i].y1 - boxes[i].y0 + 1;
+        widths[i] = boxes[i].x1 - boxes[i].x0 + 1;
+    }
+    med_h = median_int(heights, nb, scratch);
+    med_w = median_int(widths, nb, scratch);
+    arena_release(scratch, mark);
+
+    if (sort_by_key(boxes, nb, sizeof(Box), box_key_yc, 2 * (H - 1)) != 0)
+        sort_stable(boxes, nb, sizeof(Box), box_cmp_yc);
+
+    double line_th = med_h * 0.65;
+    if (line_th < 8.0) line_th = 8.0;
+
+    for (int a = 0; a < nb; ) {
+
+        int b = a + 1;
+
+        while (b < nb && fabs(boxes[b].yc - boxes[a].yc) < line_th)
+            b++;
+
+        sort_stable(boxes + a, b - a, sizeof(Box), box_cmp_x0);
+
+        int gap_count = (b-a>1)? (b-a-1) : 0;
+        int *gaps = gap_count? arena_alloc(scratch, sizeof(int)*gap_count) : NULL;
+        if (gaps){
+            for (int i=a+1;i<b;i++){
+                gaps[i-a-1] = boxes[i].x0 - boxes[i-1].x1;
+            }
+        }
+        double gap_med = gaps? median_int(gaps,gap_count,scratch) : med_w * 0.8;
+        arena_release(scratch, mark);
+        double split_gap = gap_med * 1.8;
+        double min_split = med_w * 1.2;
+        if (split_gap < min_split) split_gap = min_split;
+
+        for (int i = a; i < b; ) {
+
+            int j = i + 1;
+            while (j < b && (boxes[j].x0 - boxes[j-1].x1) < split_gap)
+                j++;
+
+            int x0 = boxes[i].x0;
+            int x1 = boxes[j-1].x1;
+            int y0 = boxes[i].y0;
+            int y1 = boxes[i].y1;
+
+            for (int k=i; k<j; k++) {
+                if (boxes[k].y0 < y0) y0 = boxes[k].y0;
+                if (boxes[k].y1 > y1) y1 = boxes[k].y1;
+            }
+
+            int w = x1 - x0 + 1;
+            int h = y1 - y0 + 1;
+
+            unsigned char *cut = arena_alloc(scratch, (size_t)w*h);
+            for (int yy = 0; cut && yy < h; yy++)
+                memcpy(cut + yy*w, pix + (y0+yy)*W + x0, w);
+
+            if (cut)
+                ajouter_mot(out, cut, w, h, scratch);
+
+            arena_release(scratch, mark);
+
+            i = j;
+        }
+
+        a = b;
+    }
+
+    return 0;
+}
+
+/* Une arene par image pour tous les tampons de travail : celle de l'appelant, videe au
+ * debut, ou une locale liberee en une fois. */
+static int extract_words(const OcrImage *bw, const RleImage *runs, OcrWordSet *out, Arena *scratch) {
+    memset(out, 0, sizeof(*out));
+    if (!bw || !bw->pixels || bw->channels != 1 || bw->stride != (size_t)bw->width) return -1;
+    if (runs && (runs->width != bw->width || runs->height != bw->height)) return -1;
+
+    Arena propre;
+    if (scratch) arena_reset(scratch);
+    else arena_init(scratch = &propre, 0);
+    int rc = extraire_mots(bw, runs, out, scratch);
+    out->scratch_peak = scratch->peak;
+    if (scratch == &propre) arena_free(&propre);
+    return rc;
+}
+
+int ocr_extract_words_runs(const OcrImage *bw, const RleImage *runs, OcrWordSet *out) {
+    return extract_words(bw, runs, out, NULL);
+}
+
+int ocr_extract_words_scratch(const OcrImage *bw, const RleImage *runs, OcrWordSet *out, Arena *scratch) {
+    return extract_words(bw, runs, out, scratch);
+}
+
+int ocr_extract_words(const OcrImage *bw, OcrWordSet *out) {
+    return ocr_extract_words_runs(bw, NULL, out);
+}
+
+void ocr_words_free(OcrWordSet *set)
+{
+    if (!set) return;
+    for (size_t i = 0; i < set->count; i++) {
+        for (int k = 0; k < set->words[i].count; k++)
+            ocr_image_free(&set->words[i].letters[k]);
+        free(set->words[i].letters);
+    }
+    free(set->words);
+    memset(set, 0, sizeof(*set));
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "ocr.h"
+#include "timing.h"
+#include "weights.h"
+
+static int same_array(const float *a, const float *b, size_t n) {
+    return memcmp(a, b, n * sizeof(float)) == 0;
+}
+
+/* Conversion unique de l'ancien format texte vers le format binaire, puis relecture. */
+int main(int argc, char **argv) {
+    const char *in = argc > 1 ? argv[1] : "weights.txt";
+    const char *out = argc > 2 ? argv[2] : "weights." WEIGHTS_EXT;
+    if (argc > 3 || (argc > 1 && strcmp(argv[1], "--help") == 0)) {
+        printf("Usage: %s [weights.txt] [weights.%s]\n", argv[0], WEIGHTS_EXT);
+        return argc > 3;
+    }
+
+    OcrModel txt, bin;
+    double t0 = timing_now_ms();
+    if (ocr_model_load(in, &txt) != 0) return 1;
+    double t1 = timing_now_ms();
+    if (weights_write(out, &txt) != 0) {
+        fprintf(stderr, "Impossible d'écrire %s\n", out);
+        ocr_model_free(&txt);
+        return 1;
+    }
+    double t2 = timing_now_ms();
+    if (ocr_model_load(out, &bin) != 0) {
+        ocr_model_free(&txt);
+        return 1;
+    }
+    double t3 = timing_now_ms();
+
+    /* la projection ne verifie pas la somme de controle : c'est fait ici, une fois */
+    int same = weights_verify(&bin) == 0 && bin.input_dim == txt.input_dim &&
+               bin.hidden_dim == txt.hidden_dim && bin.output_dim == txt.output_dim &&
+               same_array(bin.W1, txt.W1, (size_t)txt.hidden_dim * txt.input_dim) &&
+               same_array(bin.b1, txt.b1, (size_t)txt.hidden_dim) &&
+               same_array(bin.W2, txt.W2, (size_t)txt.output_dim * txt.hidden_dim) &&
+               same_array(bin.b2, txt.b2, (size_t)txt.output_dim) &&
+               same_array(bin.W1t, txt.W1t, (size_t)txt.input_dim * txt.hidden_dim) &&
+               same_array(bin.W1sum, txt.W1sum, (size_t)txt.hidden_dim);
+    printf("Écrit %s (input_dim=%d, hidden_dim=%d, output_dim=%d, %zu octets)\n", out, txt.input_dim,
+           txt.hidden_dim, txt.output_dim, bin.map_len);
+    printf("Chargement : texte %.2f ms, binaire %.2f ms (écriture %.2f ms) : %s\n", t1 - t0, t3 - t2,
+           t2 - t1, same ? "identique" : "DIFFERENT");
+    ocr_model_free(&txt);
+    ocr_model_free(&bin);
+    return same ? 0 : 1;
+}
@@ -1,10 +1,6 @@
-#define STB_IMAGE_IMPLEMENTATION
-#include "../binary/stb_image.h"
-
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,17 +11,9 @@
 #include <sys/types.h>
 #endif
 
+#include "atlas.h"
 #include "nn_ocr.h"
-
-typedef struct {
-    int input_dim;
-    int hidden_dim;
-    int output_dim;
-    float *W1; 
-    float *b1; 
-    float *W2; 
-    float *b2; 
-} NNOCRModel;
+#include "ocr.h"
 
 typedef struct {
     int row;
@@ -43,30 +31,7 @@ typedef struct {
     char path[512];
 } WordLetterFile;
 
-static NNOCRModel g_model = {0};
-static int g_tile_w = 0;
-static int g_tile_h = 0;
-
-static int infer_tile_dims(int input_dim, int *out_w, int *out_h)
-{
-    if (input_dim <= 0) return 0;
-    int root = (int)(sqrt((double)input_dim) + 0.5);
-    if (root * root == input_dim) {
-        *out_w = root;
-        *out_h = root;
-        return 1;
-    }
-    for (int h = 1; h <= root + 1; ++h) {
-        if (input_dim % h == 0) {
-            *out_h = h;
-            *out_w = input_dim / h;
-            return 1;
-        }
-    }
-    *out_w = input_dim;
-    *out_h = 1;
-    return 1;
-}
+static OcrModel g_model = {0};
 
 static int cmp_word_dir(const void *a, const void *b) {
     const WordDir *da = (const WordDir *)a;
@@ -84,213 +49,16 @@ static int cmp_word_letter(const void *a, const void *b) {
     return strcmp(la->path, lb->path);
 }
 
-static float sigmoid(float x) {
-    return 1.0f / (1.0f + expf(-x));
-}
-
-static void free_model(NNOCRModel *m) {
-    free(m->W1);
-    free(m->b1);
-    free(m->W2);
-    free(m->b2);
-    memset(m, 0, sizeof(*m));
-}
-
-static int load_weights(const char *weights_path) {
-    FILE *f = fopen(weights_path, "r");
-    if (!f) {
-        fprintf(stderr, "Cannot open weights: %s\n", weights_path);
-        return 0;
-    }
-
-    if (fscanf(f, "%d %d %d", &g_model.input_dim, &g_model.hidden_dim, &g_model.output_dim) != 3) {
-        fprintf(stderr, "Invalid weights header\n");
-        fclose(f);
-        return 0;
-    }
-
-    size_t w1_sz = (size_t)g_model.input_dim * (size_t)g_model.hidden_dim;
-    size_t w2_sz = (size_t)g_model.hidden_dim * (size_t)g_model.output_dim;
-    g_model.W1 = (float *)malloc(sizeof(float) * w1_sz);
-    g_model.b1 = (float *)malloc(sizeof(float) * (size_t)g_model.hidden_dim);
-    g_model.W2 = (float *)malloc(sizeof(float) * w2_sz);
-    g_model.b2 = (float *)malloc(sizeof(float) * (size_t)g_model.output_dim);
-    if (!g_model.W1 || !g_model.b1 || !g_model.W2 || !g_model.b2) {
-        fprintf(stderr, "Memory allocation failed for weights\n");
-        fclose(f);
-        free_model(&g_model);
-        return 0;
-    }
-
-    for (size_t i = 0; i < w1_sz; ++i) {
-        if (fscanf(f, "%f", &g_model.W1[i]) != 1) {
-            fprintf(stderr, "Invalid W1 entry\n");
-            goto fail;
-        }
-    }
-    for (int i = 0; i < g_model.hidden_dim; ++i) {
-        if (fscanf(f, "%f", &g_model.b1[i]) != 1) {
-            fprintf(stderr, "Invalid b1 entry\n");
-            goto fail;
-        }
-    }
-    for (size_t i = 0; i < w2_sz; ++i) {
-        if (fscanf(f, "%f", &g_model.W2[i]) != 1) {
-            fprintf(stderr, "Invalid W2 entry\n");
-            goto fail;
-        }
-    }
-    for (int i = 0; i < g_model.output_dim; ++i) {
-        if (fscanf(f, "%f", &g_model.b2[i]) != 1) {
-            fprintf(stderr, "Invalid b2 entry\n");
-            goto fail;
-        }
-    }
-
-    fclose(f);
-    if (!infer_tile_dims(g_model.input_dim, &g_tile_w, &g_tile_h)) {
-        fprintf(stderr, "Cannot infer tile dimensions from weights\n");
-        free_model(&g_model);
-        return 0;
-    }
-    return 1;
-
-fail:
-    fclose(f);
-    free_model(&g_model);
-    return 0;
-}
-
-static float *load_image_vector(const char *path, int expected_len, int *out_len) {
-    (void)expected_len;
-    int w = 0, h = 0, ch = 0;
-    unsigned char *img = stbi_load(path, &w, &h, &ch, 1);
-    if (!img) {
+/* Lettre d'un PNG de case : meme chemin que l'atlas (entree sur 1 bit par pixel). */
+static int predict_image_file(const char *path, char *letter) {
+    OcrImage img;
+    if (ocr_image_load(path, 1, &img) != 0) {
         fprintf(stderr, "Failed to load %s\n", path);
-        return NULL;
-    }
-    size_t len = (size_t)g_tile_w * (size_t)g_tile_h;
-    float *vec = (float *)malloc(sizeof(float) * len);
-    if (!vec) {
-        stbi_image_free(img);
-        return NULL;
-    }
-    for (size_t i = 0; i < len; ++i) vec[i] = 1.0f;
-
-    int x0 = w, y0 = h, x1 = -1, y1 = -1;
-    int dark = 0;
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            unsigned char v = img[y * w + x];
-            if (v < 200) {
-                if (x < x0) x0 = x;
-                if (x > x1) x1 = x;
-                if (y < y0) y0 = y;
-                if (y > y1) y1 = y;
-                dark++;
-            }
-        }
-    }
-    if (x1 < x0 || y1 < y0) {
-        x0 = 0; y0 = 0; x1 = w - 1; y1 = h - 1;
-    }
-    int bw = x1 - x0 + 1;
-    int bh = y1 - y0 + 1;
-    if (bw < 1) bw = 1;
-    if (bh < 1) bh = 1;
-
-    double avail_w = (double)(g_tile_w - 2);
-    double avail_h = (double)(g_tile_h - 2);
-    if (avail_w < 1.0) avail_w = (double)g_tile_w;
-    if (avail_h < 1.0) avail_h = (double)g_tile_h;
-    double scale = fmin(avail_w / (double)bw, avail_h / (double)bh);
-    if (scale <= 0.0) scale = 1.0;
-    int dw = (int)(bw * scale + 0.5);
-    int dh = (int)(bh * scale + 0.5);
-    if (dw < 1) dw = 1;
-    if (dh < 1) dh = 1;
-    if (dw > g_tile_w) dw = g_tile_w;
-    if (dh > g_tile_h) dh = g_tile_h;
-
-    int offx = (g_tile_w - dw) / 2;
-    int offy = (g_tile_h - dh) / 2;
-    int invert = (dark > (w * h) / 2);
-
-    for (int ty = 0; ty < dh; ++ty) {
-        double ry = (dh <= 1) ? 0.0 : (double)ty / (double)(dh - 1);
-        int sy = y0 + (int)round(ry * (double)(bh - 1));
-        if (sy < y0) sy = y0;
-        if (sy > y1) sy = y1;
-        for (int tx = 0; tx < dw; ++tx) {
-            double rx = (dw <= 1) ? 0.0 : (double)tx / (double)(dw - 1);
-            int sx = x0 + (int)round(rx * (double)(bw - 1));
-            if (sx < x0) sx = x0;
-            if (sx > x1) sx = x1;
-            unsigned char v = img[sy * w + sx];
-            int is_letter = invert ? (v > 200) : (v < 200);
-            float out = is_letter ? 0.0f : 1.0f;
-            int dx = offx + tx;
-            int dy = offy + ty;
-            if (dx >= 0 && dx < g_tile_w && dy >= 0 && dy < g_tile_h) {
-                vec[dy * g_tile_w + dx] = out;
-            }
-        }
-    }
-
-    stbi_image_free(img);
-    if (out_len) *out_len = (int)len;
-    return vec;
-}
-
-static char predict_letter_from_vec(const float *input) {
-    if (!g_model.W1 || !g_model.W2) {
-        return '?';
-    }
-
-    int hdim = g_model.hidden_dim;
-    int odim = g_model.output_dim;
-    int idim = g_model.input_dim;
-
-    float *hidden = (float *)malloc(sizeof(float) * (size_t)hdim);
-    float *output = (float *)malloc(sizeof(float) * (size_t)odim);
-    if (!hidden || !output) {
-        free(hidden);
-        free(output);
-        return '?';
-    }
-
-    for (int j = 0; j < hdim; ++j) {
-        float s = g_model.b1[j];
-        const float *wrow = &g_model.W1[(size_t)j * (size_t)idim];
-        for (int i = 0; i < idim; ++i) {
-            s += wrow[i] * input[i];
-        }
-        hidden[j] = sigmoid(s);
-    }
-
-    int best = 0;
-    float best_val = -1.0e9f;
-    for (int k = 0; k < odim; ++k) {
-        float s = g_model.b2[k];
-        const float *wrow = &g_model.W2[(size_t)k * (size_t)hdim];
-        for (int j = 0; j < hdim; ++j) {
-            s += wrow[j] * hidden[j];
-        }
-        float y = sigmoid(s);
-        output[k] = y;
-        if (y > best_val) {
-            best_val = y;
-            best = k;
-        }
-    }
-
-    free(hidden);
-    free(output);
-
-    if (best >= 0 && best < 26) {
-        return (char)('A' + best);
+        return -1;
     }
-    return '?';
+    *letter = ocr_recognize_tile(&g_model, &img);
+    ocr_image_free(&img);
+    return 0;
 }
 
 static int parse_letter_indices(const char *name, int *row, int *col) {
@@ -308,7 +76,20 @@ static int parse_letter_indices(const char *name, int *row, int *col) {
     return 0;
 }
 
+static int atlas_path(const char *dir_path, char *out, size_t out_sz) {
+    int n = snprintf(out, out_sz, "%s/%s", dir_path, ATLAS_FILE);
+    if (n < 0 || (size_t)n >= out_sz) {
+        return 0;
+    }
+    struct stat st;
+    return stat(out, &st) == 0 && S_ISREG(st.st_mode);
+}
+
 static int directory_contains_grid_letters(const char *path) {
+    char atlas[512];
+    if (atlas_path(path, atlas, sizeof(atlas))) {
+        return 1;
+    }
     DIR *dir = opendir(path);
     if (!dir) {
         return 0;
@@ -540,10 +321,6 @@ static WordLetterFile *collect_word_letters(const char *dir_path, size_t *out_co
     return list;
 }
 
-static float *load_word_letter_vector(const char *path) {
-    return load_image_vector(path, g_model.input_dim, NULL);
-}
-
 static char *recognize_word_from_dir(const char *dir_path) {
     size_t letter_count = 0;
     WordLetterFile *letters = collect_word_letters(dir_path, &letter_count);
@@ -557,12 +334,10 @@ static char *recognize_word_from_dir(const char *dir_path) {
     }
     size_t pos = 0;
     for (size_t i = 0; i < letter_count; ++i) {
-        float *vec = load_word_letter_vector(letters[i].path);
-        if (!vec) {
+        char letter;
+        if (predict_image_file(letters[i].path, &letter) != 0) {
             continue;
         }
-        char letter = predict_letter_from_vec(vec);
-        free(vec);
         buffer[pos++] = letter;
     }
     free(letters);
@@ -583,7 +358,7 @@ static void free_words(char **words, size_t n) {
 }
 
 static int write_words_from_directories(const char *root, const char *mots_path) {
-    if (g_tile_w <= 0 || g_tile_h <= 0) {
+    if (g_model.tile_w <= 0 || g_model.tile_h <= 0) {
         return 0;
     }
     size_t dir_count = 0;
@@ -624,65 +399,93 @@ static int write_words_from_directories(const char *root, const char *mots_path)
 }
 
 int nn_init(const char *weights_path) {
-    free_model(&g_model);
-    g_tile_w = 0;
-    g_tile_h = 0;
-    return load_weights(weights_path);
+    ocr_model_free(&g_model);
+    return ocr_model_load(weights_path, &g_model) == 0;
 }
 
 char nn_predict_letter_from_file(const char *png_path) {
-    int vec_len = 0;
-    float *vec = load_image_vector(png_path, g_model.input_dim, &vec_len);
-    if (!vec) {
-        return '?';
-    }
-    char c = predict_letter_from_vec(vec);
-    free(vec);
-    return c;
+    char c;
+    return predict_image_file(png_path, &c) == 0 ? c : '?';
 }
 
-int nn_process_grid(const char *letters_dir, const char *grille_path, const char *mots_path) {
-    size_t count = 0;
-    int rows = 0, cols = 0;
-    char grid_dir[512];
-    if (!find_grid_directory(letters_dir, grid_dir, sizeof(grid_dir))) {
-        fprintf(stderr, "No grid directory found in %s\n", letters_dir);
-        return 0;
+/* Atlas ecrit par grid_splitter : un seul fichier projete en memoire, les cases sont
+ * lues sur place, sans decodage PNG ni parcours du repertoire, et reconnues d'un coup. */
+static char *grid_from_atlas(const char *path, size_t *count, int *rows, int *cols) {
+    TileAtlas atlas;
+    if (atlas_map(path, &atlas) != 0) {
+        fprintf(stderr, "Invalid tile atlas: %s\n", path);
+        return NULL;
     }
-    LetterImage *imgs = scan_letter_images(grid_dir, &count, &rows, &cols);
-    if (!imgs) {
-        return 0;
+    char *grid = NULL;
+    char *letters = (char *)malloc(atlas.count > 0 ? (size_t)atlas.count : 1);
+    if (letters && atlas.count > 0 && atlas_recognize(&atlas, &g_model, letters, NULL) == 0) {
+        int r = 0, c = 0;
+        for (int i = 0; i < atlas.count; ++i) {
+            AtlasEntry e;
+            atlas_entry(&atlas, i, &e);
+            if (e.row + 1 > r) r = e.row + 1;
+            if (e.col + 1 > c) c = e.col + 1;
+        }
+        grid = (char *)malloc((size_t)r * (size_t)c);
+        if (grid) {
+            memset(grid, '?', (size_t)r * (size_t)c);
+            for (int i = 0; i < atlas.count; ++i) {
+                AtlasEntry e;
+                atlas_entry(&atlas, i, &e);
+                grid[(size_t)e.row * (size_t)c + (size_t)e.col] = letters[i];
+            }
+            *count = (size_t)atlas.count;
+            *rows = r;
+            *cols = c;
+        }
+    }
+    free(letters);
+    atlas_unmap(&atlas);
+    if (!grid) {
+        fprintf(stderr, "No letter images found in %s\n", path);
     }
+    return grid;
+}
 
-    char **grid = (char **)malloc(sizeof(char *) * (size_t)rows);
+static char *grid_from_images(const char *dir_path, size_t *count, int *rows, int *cols) {
+    LetterImage *imgs = scan_letter_images(dir_path, count, rows, cols);
+    if (!imgs) {
+        return NULL;
+    }
+    char *grid = (char *)malloc((size_t)*rows * (size_t)*cols);
     if (!grid) {
         fprintf(stderr, "Memory allocation failed for grid rows\n");
         free(imgs);
-        return 0;
-    }
-    for (int r = 0; r < rows; ++r) {
-        grid[r] = (char *)malloc(sizeof(char) * (size_t)cols);
-        if (!grid[r]) {
-            fprintf(stderr, "Memory allocation failed for grid row\n");
-            for (int i = 0; i < r; ++i) {
-                free(grid[i]);
-            }
-            free(grid);
-            free(imgs);
-            return 0;
-        }
-        memset(grid[r], '?', (size_t)cols);
+        return NULL;
     }
+    memset(grid, '?', (size_t)*rows * (size_t)*cols);
 
-    for (size_t i = 0; i < count; ++i) {
-        float *vec = load_image_vector(imgs[i].path, g_model.input_dim, NULL);
-        if (!vec) {
+    for (size_t i = 0; i < *count; ++i) {
+        char letter;
+        if (predict_image_file(imgs[i].path, &letter) != 0) {
             fprintf(stderr, "Skipping %s\n", imgs[i].path);
             continue;
         }
-        char letter = predict_letter_from_vec(vec);
-        grid[imgs[i].row][imgs[i].col] = letter;
-        free(vec);
+        grid[(size_t)imgs[i].row * (size_t)*cols + (size_t)imgs[i].col] = letter;
+    }
+    free(imgs);
+    return grid;
+}
+
+int nn_process_grid(const char *letters_dir, const char *grille_path, const char *mots_path) {
+    size_t count = 0;
+    int rows = 0, cols = 0;
+    char grid_dir[512];
+    if (!find_grid_directory(letters_dir, grid_dir, sizeof(grid_dir))) {
+        fprintf(stderr, "No grid directory found in %s\n", letters_dir);
+        return 0;
+    }
+    char atlas[512];
+    char *grid = atlas_path(grid_dir, atlas, sizeof(atlas))
+                     ? grid_from_atlas(atlas, &count, &rows, &cols)
+                     : grid_from_images(grid_dir, &count, &rows, &cols);
+    if (!grid) {
+        return 0;
     }
 
     FILE *fg = fopen(grille_path, "w");
@@ -692,7 +495,7 @@ int nn_process_grid(const char *letters_dir, const char *grille_path, const char
     }
     for (int r = 0; r < rows; ++r) {
         for (int c = 0; c < cols; ++c) {
-            fputc(grid[r][c], fg);
+            fputc(grid[(size_t)r * (size_t)cols + (size_t)c], fg);
             if (c + 1 < cols) {
                 fputc(' ', fg);
             }
@@ -708,9 +511,7 @@ int nn_process_grid(const char *letters_dir, const char *grille_path, const char
             goto cleanup;
         }
         for (int r = 0; r < rows; ++r) {
-            for (int c = 0; c < cols; ++c) {
-                fputc(grid[r][c], fm);
-            }
+            fwrite(grid + (size_t)r * (size_t)cols, 1, (size_t)cols, fm);
             fputc('\n', fm);
         }
         fclose(fm);
@@ -721,23 +522,29 @@ int nn_process_grid(const char *letters_dir, const char *grille_path, const char
            img_count, rows, cols, grille_path, mots_path);
 
 cleanup:
-    for (int r = 0; r < rows; ++r) {
-        free(grid[r]);
-    }
     free(grid);
-    free(imgs);
     return 1;
 }
 
 void nn_shutdown(void) {
-    free_model(&g_model);
-    g_tile_w = 0;
-    g_tile_h = 0;
+    ocr_model_free(&g_model);
 }
 
 #ifndef NN_OCR_NO_MAIN
-int main(void) {
-    if (!nn_init("weights.txt")) {
+int main(int argc, char **argv) {
+    /* weights.bin (make) est projete tel quel, s'il n'est pas plus ancien que weights.txt ;
+     * --int8 : modele quantifie weights_q8.bin (make, nn/quantize_weights) */
+    struct stat st_txt, st_bin;
+    const char *weights = "weights.txt";
+    if (argc > 1 && strcmp(argv[1], "--int8") == 0)
+        weights = "weights_q8.bin";
+    else if (argc > 1) {
+        fprintf(stderr, "Usage: %s [--int8]\n", argv[0]);
+        return 1;
+    } else if (stat("weights.bin", &st_bin) == 0 &&
+               (stat(weights, &st_txt) != 0 || st_bin.st_mtime >= st_txt.st_mtime))
+        weights = "weights.bin";
+    if (!nn_init(weights)) {
         return 1;
     }
     if (!nn_process_grid("grid_letters", "grille.txt", "mots.txt")) {
@@ -0,0 +1,342 @@
+#include <ctype.h>
+#include <dirent.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ocr.h"
+#include "timing.h"
+#include "weights.h"
+
+#define MAX_PATH_LEN 512
+#define LETTERS "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+
+/* Echelle de chaque ligne : max|w| / 127 multiplie par 1, 0.975, ... 0.5 ; on garde celle
+ * qui deforme le moins les sorties sur les tuiles de calibration. */
+#define CLIP_PAS 0.025
+#define CLIP_MIN 0.5
+
+typedef struct {
+    size_t n, cap;
+    size_t words;
+    uint64_t *bits;
+    char *truth;
+    uint16_t *ink;  /* pixels d'encre de la tuile t : ink[off[t]] .. ink[off[t + 1] - 1] */
+    size_t *off;
+} Tuiles;
+
+static int has_png_extension(const char *name) {
+    const char *dot = strrchr(name, '.');
+    if (!dot) return 0;
+    ++dot;
+    char buf[8] = {0};
+    size_t len = strlen(dot);
+    if (len >= sizeof(buf)) return 0;
+    for (size_t i = 0; i < len; ++i)
+        buf[i] = (char)tolower((unsigned char)dot[i]);
+    return strcmp(buf, "png") == 0;
+}
+
+static void tuiles_free(Tuiles *t) {
+    free(t->bits);
+    free(t->truth);
+    free(t->ink);
+    free(t->off);
+    memset(t, 0, sizeof(*t));
+}
+
+static int ajouter(Tuiles *t, const OcrModel *m, const char *path, char letter) {
+    if (t->n == t->cap) {
+        size_t cap = t->cap ? t->cap * 2 : 256;
+        uint64_t *bits = (uint64_t *)realloc(t->bits, cap * t->words * sizeof(uint64_t));
+        if (bits) t->bits = bits;
+        char *truth = (char *)realloc(t->truth, cap);
+        if (truth) t->truth = truth;
+        if (!bits || !truth) return -1;
+        t->cap = cap;
+    }
+    OcrImage img;
+    if (ocr_image_load(path, 1, &img) != 0) {
+        fprintf(stderr, "Impossible de charger %s\n", path);
+        return 0;
+    }
+    int rc = ocr_tile_bits(m, &img, t->bits + t->n * t->words);
+    ocr_image_free(&img);
+    if (rc != 0) return 0;
+    t->truth[t->n++] = letter;
+    return 0;
+}
+
+/* Tuiles <root>/<lettre>/<nom>.png, mises au format du reseau comme a la reconnaissance. */
+static int charger_tuiles(const char *root, const OcrModel *m, Tuiles *t) {
+    memset(t, 0, sizeof(*t));
+    t->words = OCR_BITS_WORDS(m->input_dim);
+    for (const char *l = LETTERS; *l; ++l) {
+        char dir_path[MAX_PATH_LEN];
+        snprintf(dir_path, sizeof(dir_path), "%s/%c", root, *l);
+        DIR *dir = opendir(dir_path);
+        if (!dir) continue;
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.' || !has_png_extension(entry->d_name)) continue;
+            char file_path[MAX_PATH_LEN];
+            if (snprintf(file_path, sizeof(file_path), "%s/%s", dir_path, entry->d_name) >= (int)sizeof(file_path))
+                continue;
+            if (ajouter(t, m, file_path, *l) != 0) {
+                closedir(dir);
+                tuiles_free(t);
+                return -1;
+            }
+        }
+        closedir(dir);
+    }
+    if (t->n == 0) {
+        fprintf(stderr, "Aucune image trouvée dans %s\n", root);
+        return -1;
+    }
+    size_t total = 0;
+    for (size_t i = 0; i < t->n * t->words; ++i) total += (size_t)__builtin_popcountll(t->bits[i]);
+    t->ink = (uint16_t *)malloc((total ? total : 1) * sizeof(uint16_t));
+    t->off = (size_t *)malloc((t->n + 1) * sizeof(size_t));
+    if (!t->ink || !t->off) {
+        tuiles_free(t);
+        return -1;
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < t->n; ++i) {
+        t->off[i] = k;
+        const uint64_t *x = t->bits + i * t->words;
+        for (size_t w = 0; w < t->words; ++w)
+            for (uint64_t v = x[w]; v; v &= v - 1) t->ink[k++] = (uint16_t)(w * 64 + (size_t)__builtin_ctzll(v));
+    }
+    t->off[t->n] = k;
+    return 0;
+}
+
+static float sigmoid(float x) {
+    return 1.0f / (1.0f + expf(-x));
+}
+
+static int8_t quant(float w, float s) {
+    long q = lrintf(w / s);
+    if (q > 127) q = 127;
+    if (q < -127) q = -127;
+    return (int8_t)q;
+}
+
+static float ligne_max(const float *w, size_t n) {
+    float wmax = 0.0f;
+    for (size_t i = 0; i < n; ++i) wmax = fmaxf(wmax, fabsf(w[i]));
+    return wmax;
+}
+
+static float echelle(float wmax, double clip) {
+    return wmax > 0.0f ? (float)(clip * wmax / 127.0) : 1.0f;
+}
+
+/* Premiere couche, ligne j de W1 : erreur de h_j sur chaque tuile, au premier ordre
+ * (derivee de la sigmoide fois l'erreur sur les pixels d'encre, W1sum restant exact). */
+static void calibrer_couche1(const OcrModel *f, const Tuiles *t, const float *hf, OcrModel *q) {
+    const size_t idim = (size_t)f->input_dim, hdim = (size_t)f->hidden_dim;
+    float *r = (float *)malloc(idim * sizeof(float));
+    if (!r) return;
+    for (size_t j = 0; j < hdim; ++j) {
+        const float *w = f->W1 + j * idim;
+        const float wmax = ligne_max(w, idim);
+        double best_e = HUGE_VAL;
+        float best_s = 1.0f;
+        for (double clip = 1.0; clip >= CLIP_MIN - 1e-9; clip -= CLIP_PAS) {
+            const float s = echelle(wmax, clip);
+            for (size_t i = 0; i < idim; ++i) r[i] = w[i] - s * quant(w[i], s);
+            double e = 0.0;
+            for (size_t n = 0; n < t->n; ++n) {
+                double d = 0.0;
+                for (size_t k = t->off[n]; k < t->off[n + 1]; ++k) d += r[t->ink[k]];
+                const double h = hf[n * hdim + j], g = h * (1.0 - h);
+                e += g * g * d * d;
+            }
+            if (e < best_e) {
+                best_e = e;
+                best_s = s;
+            }
+        }
+        q->s1[j] = best_s;
+        for (size_t i = 0; i < idim; ++i) q->Q1t[i * hdim + j] = quant(w[i], best_s);
+    }
+    free(r);
+}
+
+/* Deuxieme couche, ligne k de W2 : sortie du modele int8 (couche cachee deja quantifiee,
+ * hq) face a celle du modele float (hf), toujours ponderee par la derivee. */
+static void calibrer_couche2(const OcrModel *f, const Tuiles *t, const float *hf, const uint8_t *hq,
+                             OcrModel *q) {
+    const size_t hdim = (size_t)f->hidden_dim, odim = (size_t)f->output_dim;
+    int8_t *qr = (int8_t *)malloc(hdim);
+    if (!qr) return;
+    for (size_t k = 0; k < odim; ++k) {
+        const float *w = f->W2 + k * hdim;
+        const float wmax = ligne_max(w, hdim);
+        double best_e = HUGE_VAL;
+        float best_s = 1.0f;
+        for (double clip = 1.0; clip >= CLIP_MIN - 1e-9; clip -= CLIP_PAS) {
+            const float s = echelle(wmax, clip);
+            for (size_t j = 0; j < hdim; ++j) qr[j] = quant(w[j], s);
+            double e = 0.0;
+            for (size_t n = 0; n < t->n; ++n) {
+                double y = 0.0;
+                long a = 0;
+                for (size_t j = 0; j < hdim; ++j) {
+                    y += (double)w[j] * hf[n * hdim + j];
+                    a += (long)qr[j] * hq[n * hdim + j];
+                }
+                const double o = sigmoid((float)(y + f->b2[k])), g = o * (1.0 - o);
+                const double d = y - (double)s * (double)a / WEIGHTS_Q8_HIDDEN;
+                e += g * g * d * d;
+            }
+            if (e < best_e) {
+                best_e = e;
+                best_s = s;
+            }
+        }
+        q->s2[k] = best_s;
+        for (size_t j = 0; j < hdim; ++j) q->Q2[k * hdim + j] = quant(w[j], best_s);
+    }
+    free(qr);
+}
+
+/* Couches cachees des tuiles : hf (modele float), puis hq (modele int8, 0..127). */
+static void couches_cachees(const OcrModel *f, const Tuiles *t, float *hf) {
+    const size_t hdim = (size_t)f->hidden_dim;
+    for (size_t n = 0; n < t->n; ++n)
+        for (size_t j = 0; j < hdim; ++j) {
+            float z = f->W1sum[j];
+            for (size_t k = t->off[n]; k < t->off[n + 1]; ++k) z -= f->W1t[(size_t)t->ink[k] * hdim + j];
+            hf[n * hdim + j] = sigmoid(z);
+        }
+}
+
+static void couches_cachees_q8(const OcrModel *q, const Tuiles *t, uint8_t *hq) {
+    const size_t hdim = (size_t)q->hidden_dim;
+    for (size_t n = 0; n < t->n; ++n)
+        for (size_t j = 0; j < hdim; ++j) {
+            long a = 0;
+            for (size_t k = t->off[n]; k < t->off[n + 1]; ++k) a += q->Q1t[(size_t)t->ink[k] * hdim + j];
+            float h = sigmoid(q->W1sum[j] - q->s1[j] * (float)a);
+            hq[n * hdim + j] = (uint8_t)(h * WEIGHTS_Q8_HIDDEN + 0.5f);
+        }
+}
+
+/* Meilleur de 5, en ms ; letters[n] et scores[n x output_dim]. */
+static double mesurer(const OcrModel *m, const Tuiles *t, char *letters, float *scores) {
+    double best = TIMING_NONE;
+    for (int r = 0; r < 5; ++r) {
+        double t0 = timing_now_ms();
+        if (ocr_predict_bits_batch(m, t->bits, t->n, letters, scores) != 0) return -1.0;
+        best = timing_keep_best(best, t0);
+    }
+    return best;
+}
+
+static int rapport(const OcrModel *f, const OcrModel *q, const Tuiles *t) {
+    const size_t ns = t->n * (size_t)f->output_dim;
+    char *lf = (char *)malloc(t->n), *lq = (char *)malloc(t->n);
+    float *sf = (float *)malloc(ns * sizeof(float)), *sq = (float *)malloc(ns * sizeof(float));
+    int rc = -1;
+    if (lf && lq && sf && sq) {
+        double tf = mesurer(f, t, lf, sf), tq = mesurer(q, t, lq, sq);
+        size_t okf = 0, okq = 0, same = 0;
+        double diff = 0.0;
+        for (size_t i = 0; i < t->n; ++i) {
+            okf += lf[i] == t->truth[i];
+            okq += lq[i] == t->truth[i];
+            same += lf[i] == lq[i];
+        }
+        for (size_t i = 0; i < ns; ++i) diff = fmax(diff, fabs((double)sq[i] - sf[i]));
+        const size_t hw = (size_t)f->hidden_dim * (size_t)f->input_dim, ow = (size_t)f->output_dim * f->hidden_dim;
+        printf("Poids de la reconnaissance : float %zu Ko, int8 %zu Ko\n", (hw + ow) * sizeof(float) / 1024,
+               (hw + ow) / 1024);
+        printf("modele   justes     us/tuile\n");
+        printf("float    %5.1f%%   %8.2f\n", 100.0 * okf / t->n, tf * 1e3 / t->n);
+        printf("int8     %5.1f%%   %8.2f   (= float : %.1f%%, ecart max des scores %.3f)\n", 100.0 * okq / t->n,
+               tq * 1e3 / t->n, 100.0 * same / t->n, diff);
+        rc = tf >= 0.0 && tq >= 0.0 ? 0 : -1;
+    }
+    free(lf);
+    free(lq);
+    free(sf);
+    free(sq);
+    return rc;
+}
+
+/* Quantification apres entrainement : echelles par ligne calibrees sur les tuiles du jeu
+ * d'entrainement, modele int8 ecrit au format binaire, puis comparaison au modele float. */
+int main(int argc, char **argv) {
+    const char *in = argc > 1 ? argv[1] : "weights.txt";
+    const char *data = argc > 2 ? argv[2] : "dataset/train";
+    const char *out = argc > 3 ? argv[3] : "weights_q8." WEIGHTS_EXT;
+    if (argc > 4 || (argc > 1 && strcmp(argv[1], "--help") == 0)) {
+        printf("Usage: %s [weights.txt] [dataset/train] [weights_q8.%s]\n", argv[0], WEIGHTS_EXT);
+        return argc > 4;
+    }
+
+    OcrModel f, q8;
+    if (ocr_model_load(in, &f) != 0) return 1;
+    if (!f.W1) {
+        fprintf(stderr, "%s est déjà quantifié\n", in);
+        ocr_model_free(&f);
+        return 1;
+    }
+    Tuiles t;
+    if (charger_tuiles(data, &f, &t) != 0) {
+        ocr_model_free(&f);
+        return 1;
+    }
+    const size_t idim = (size_t)f.input_dim, hdim = (size_t)f.hidden_dim, odim = (size_t)f.output_dim;
+    OcrModel q = { .input_dim = f.input_dim, .hidden_dim = f.hidden_dim, .output_dim = f.output_dim,
+                   .W1sum = f.W1sum, .b2 = f.b2 };
+    q.Q1t = (int8_t *)malloc(idim * hdim);
+    q.s1 = (float *)malloc(hdim * sizeof(float));
+    q.Q2 = (int8_t *)malloc(odim * hdim);
+    q.s2 = (float *)malloc(odim * sizeof(float));
+    float *hf = (float *)malloc(t.n * hdim * sizeof(float));
+    uint8_t *hq = (uint8_t *)malloc(t.n * hdim);
+    int rc = 1;
+    if (!q.Q1t || !q.s1 || !q.Q2 || !q.s2 || !hf || !hq) {
+        fprintf(stderr, "Allocation mémoire impossible.\n");
+        goto fin;
+    }
+
+    double t0 = timing_now_ms();
+    couches_cachees(&f, &t, hf);
+    calibrer_couche1(&f, &t, hf, &q);
+    couches_cachees_q8(&q, &t, hq);
+    calibrer_couche2(&f, &t, hf, hq, &q);
+    double t1 = timing_now_ms();
+    if (weights_write_q8(out, &q) != 0) {
+        fprintf(stderr, "Impossible d'écrire %s\n", out);
+        goto fin;
+    }
+    if (ocr_model_load(out, &q8) != 0) goto fin;
+    if (weights_verify(&q8) != 0) {
+        fprintf(stderr, "Somme de contrôle fausse à la relecture de %s\n", out);
+        ocr_model_free(&q8);
+        goto fin;
+    }
+    printf("Écrit %s (%zu tuiles de calibration dans %s, %.0f ms, %zu octets)\n", out, t.n, data, t1 - t0,
+           q8.map_len);
+    rc = rapport(&f, &q8, &t) == 0 ? 0 : 1;
+    ocr_model_free(&q8);
+
+fin:
+    free(q.Q1t);
+    free(q.s1);
+    free(q.Q2);
+    free(q.s2);
+    free(hf);
+    free(hq);
+    tuiles_free(&t);
+    ocr_model_free(&f);
+    return rc;
+}
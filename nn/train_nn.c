@@ -7,8 +7,9 @@
 #include <string.h>
 #include <time.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "../binary/stb_image.h"
+#include "dense.h"
+#include "ocr.h"
+#include "weights.h"
 
 #define OUTPUT_DIM 26
 #define MAX_PATH_LEN 512
@@ -103,15 +104,16 @@ static int load_dataset(const TrainOptions *opts, Dataset *ds) {
             if (!has_png_extension(entry->d_name)) continue;
             char file_path[MAX_PATH_LEN];
             snprintf(file_path, sizeof(file_path), "%s/%s", dir_path, entry->d_name);
-            int w, h, comp;
-            unsigned char *pix = stbi_load(file_path, &w, &h, &comp, 1);
-            if (!pix) {
+            OcrImage img;
+            if (ocr_image_load(file_path, 1, &img) != 0) {
                 fprintf(stderr, "Impossible de charger %s\n", file_path);
                 closedir(dir);
                 free(inputs);
                 free(targets);
                 return -1;
             }
+            int w = img.width, h = img.height;
+            const unsigned char *pix = img.pixels;
             if (input_dim == 0) {
                 input_dim = w * h;
                 width = w;
@@ -120,7 +122,7 @@ static int load_dataset(const TrainOptions *opts, Dataset *ds) {
                 targets = (float *)calloc(total * OUTPUT_DIM, sizeof(float));
                 if (!inputs || !targets) {
                     fprintf(stderr, "Allocation mémoire impossible.\n");
-                    stbi_image_free(pix);
+                    ocr_image_free(&img);
                     closedir(dir);
                     free(inputs);
                     free(targets);
@@ -129,7 +131,7 @@ static int load_dataset(const TrainOptions *opts, Dataset *ds) {
             } else if (input_dim != w * h) {
                 fprintf(stderr, "Taille incohérente pour %s (%dx%d vs %dx%d attendu)\n",
                         file_path, w, h, width, height);
-                stbi_image_free(pix);
+                ocr_image_free(&img);
                 closedir(dir);
                 free(inputs);
                 free(targets);
@@ -144,7 +146,7 @@ static int load_dataset(const TrainOptions *opts, Dataset *ds) {
             float *tgt = targets + index * OUTPUT_DIM;
             tgt[letter_idx] = 1.0f;
             ++index;
-            stbi_image_free(pix);
+            ocr_image_free(&img);
         }
         closedir(dir);
     }
@@ -197,8 +199,24 @@ static void initialize_weights(int input_dim, int hidden_dim, int output_dim,
         (*W2)[i] = (randf() - 0.5f) * scale;
 }
 
+static int has_bin_extension(const char *path) {
+    const char *dot = strrchr(path, '.');
+    return dot && strcmp(dot + 1, WEIGHTS_EXT) == 0;
+}
+
 static void save_weights(const char *path, int input_dim, int hidden_dim, int output_dim,
                          const float *W1, const float *b1, const float *W2, const float *b2) {
+    if (has_bin_extension(path)) {
+        OcrModel m = { .input_dim = input_dim, .hidden_dim = hidden_dim, .output_dim = output_dim,
+                       .W1 = (float *)W1, .b1 = (float *)b1, .W2 = (float *)W2, .b2 = (float *)b2 };
+        if (weights_write(path, &m) != 0) {
+            fprintf(stderr, "Impossible d'écrire %s : %s\n", path, strerror(errno));
+            return;
+        }
+        printf("Écrit %s (binaire, input_dim=%d, hidden_dim=%d, output_dim=%d)\n",
+               path, input_dim, hidden_dim, output_dim);
+        return;
+    }
     FILE *f = fopen(path, "w");
     if (!f) {
         fprintf(stderr, "Impossible d'écrire %s : %s\n", path, strerror(errno));
@@ -233,14 +251,17 @@ static void train_network(const Dataset *ds, const TrainOptions *opts) {
     float *grad_b2 = (float *)calloc(output_dim, sizeof(float));
     float *hidden = (float *)malloc(sizeof(float) * hidden_dim);
     float *output = (float *)malloc(sizeof(float) * output_dim);
+    float *delta1 = (float *)malloc(sizeof(float) * hidden_dim);
 
-    if (!grad_W1 || !grad_b1 || !grad_W2 || !grad_b2 || !hidden || !output) {
+    if (!grad_W1 || !grad_b1 || !grad_W2 || !grad_b2 || !hidden || !output || !delta1) {
         fprintf(stderr, "Allocation mémoire impossible pour l'entraînement.\n");
         free(W1); free(b1); free(W2); free(b2);
         free(grad_W1); free(grad_b1); free(grad_W2); free(grad_b2);
-        free(hidden); free(output);
+        free(hidden); free(output); free(delta1);
         exit(1);
     }
+    const DenseOps *k_dense = dense_ops(DENSE_KERNEL_AUTO);
+    printf("Noyaux denses : %s\n", dense_kernel_name(dense_active_kernel()));
 
     const float eps = 1e-6f;
     for (int epoch = 1; epoch <= opts->epochs; ++epoch) {
@@ -254,39 +275,29 @@ static void train_network(const Dataset *ds, const TrainOptions *opts) {
             const float *x = ds->inputs + sample * input_dim;
             const float *y_true = ds->targets + sample * OUTPUT_DIM;
 
-            for (int j = 0; j < hidden_dim; ++j) {
-                float sum = b1[j];
-                const float *w_row = W1 + j * input_dim;
-                for (int i = 0; i < input_dim; ++i)
-                    sum += w_row[i] * x[i];
-                hidden[j] = 1.0f / (1.0f + expf(-sum));
-            }
+            k_dense->gemv(W1, (size_t)input_dim, hidden_dim, input_dim, x, hidden);
+            k_dense->bias_sigmoid(hidden, b1, hidden_dim);
+            k_dense->gemv(W2, (size_t)hidden_dim, output_dim, hidden_dim, hidden, output);
+            k_dense->bias_sigmoid(output, b2, output_dim);
 
             float delta2[OUTPUT_DIM];
             for (int k = 0; k < output_dim; ++k) {
-                float sum = b2[k];
-                const float *w_row = W2 + k * hidden_dim;
-                for (int j = 0; j < hidden_dim; ++j)
-                    sum += w_row[j] * hidden[j];
-                float y_hat = 1.0f / (1.0f + expf(-sum));
-                output[k] = y_hat;
+                float y_hat = output[k];
                 float yt = y_true[k];
                 loss += -(yt * logf(y_hat + eps) + (1.0f - yt) * logf(1.0f - y_hat + eps));
                 delta2[k] = (y_hat - yt);
                 grad_b2[k] += delta2[k];
-                for (int j = 0; j < hidden_dim; ++j)
-                    grad_W2[k * hidden_dim + j] += delta2[k] * hidden[j];
             }
+            k_dense->ger(grad_W2, (size_t)hidden_dim, output_dim, hidden_dim, delta2, hidden);
 
             for (int j = 0; j < hidden_dim; ++j) {
                 float sum = 0.0f;
                 for (int k = 0; k < output_dim; ++k)
                     sum += delta2[k] * W2[k * hidden_dim + j];
-                float delta1 = sum * hidden[j] * (1.0f - hidden[j]);
-                grad_b1[j] += delta1;
-                for (int i = 0; i < input_dim; ++i)
-                    grad_W1[j * input_dim + i] += delta1 * x[i];
+                delta1[j] = sum * hidden[j] * (1.0f - hidden[j]);
+                grad_b1[j] += delta1[j];
             }
+            k_dense->ger(grad_W1, (size_t)input_dim, hidden_dim, input_dim, delta1, x);
         }
 
         float inv_n = 1.0f / samples;
@@ -320,7 +331,7 @@ static void train_network(const Dataset *ds, const TrainOptions *opts) {
 
     free(W1); free(b1); free(W2); free(b2);
     free(grad_W1); free(grad_b1); free(grad_W2); free(grad_b2);
-    free(hidden); free(output);
+    free(hidden); free(output); free(delta1);
 }
 
 static void parse_args(int argc, char **argv, TrainOptions *opts) {
@@ -339,6 +350,7 @@ static void parse_args(int argc, char **argv, TrainOptions *opts) {
             opts->threshold = (float)atof(argv[++i]);
         } else if (strcmp(argv[i], "--help") == 0) {
             printf("Usage: %s [--data path] [--hidden N] [--epochs N] [--lr X] [--threshold X] [--out fichier]\n", argv[0]);
+            printf("  --out poids.bin : format binaire (weights.h), sinon texte\n");
             exit(0);
         } else {
             fprintf(stderr, "Argument inconnu: %s\n", argv[i]);
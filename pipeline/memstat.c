@@ -0,0 +1,111 @@
+#define _GNU_SOURCE
+#include "memstat.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+void *__real_malloc(size_t n);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t n);
+void __real_free(void *p);
+
+static size_t g_allocs;
+static size_t g_bytes;
+static size_t g_live;
+static size_t g_peak;
+
+static void track_alloc(void *p, size_t requested)
+{
+    if (!p) return;
+    size_t usable = malloc_usable_size(p);
+    __atomic_fetch_add(&g_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_bytes, requested, __ATOMIC_RELAXED);
+    size_t live = __atomic_add_fetch(&g_live, usable, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&g_peak, __ATOMIC_RELAXED);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&g_peak, &peak, live, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void track_free(void *p)
+{
+    if (p) __atomic_fetch_sub(&g_live, malloc_usable_size(p), __ATOMIC_RELAXED);
+}
+
+void *__wrap_malloc(size_t n)
+{
+    void *p = __real_malloc(n);
+    track_alloc(p, n);
+    return p;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    void *p = __real_calloc(n, size);
+    track_alloc(p, n * size);
+    return p;
+}
+
+void *__wrap_realloc(void *old, size_t n)
+{
+    size_t old_usable = old ? malloc_usable_size(old) : 0;
+    void *p = __real_realloc(old, n);
+    if (p || n == 0) __atomic_fetch_sub(&g_live, old_usable, __ATOMIC_RELAXED);
+    track_alloc(p, n);
+    return p;
+}
+
+void __wrap_free(void *p)
+{
+    track_free(p);
+    __real_free(p);
+}
+
+void memstat_reset(void)
+{
+    __atomic_store_n(&g_allocs, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_peak, __atomic_load_n(&g_live, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
+
+void memstat_read(MemCounters *out)
+{
+    out->allocs = __atomic_load_n(&g_allocs, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&g_bytes, __ATOMIC_RELAXED);
+    out->peak_live = __atomic_load_n(&g_peak, __ATOMIC_RELAXED);
+}
+
+size_t memstat_live(void)
+{
+    return __atomic_load_n(&g_live, __ATOMIC_RELAXED);
+}
+
+void memstat_reset_rss(void)
+{
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (!f) return;
+    fputs("5", f);
+    fclose(f);
+}
+
+long memstat_peak_rss_kb(void)
+{
+    FILE *f = fopen("/proc/self/status", "r");
+    if (f) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, "VmHWM:", 6) == 0) {
+                sscanf(line + 6, "%ld", &kb);
+                break;
+            }
+        }
+        fclose(f);
+        if (kb >= 0) return kb;
+    }
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
@@ -0,0 +1,22 @@
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <stddef.h>
+
+/* Compteurs d'allocation alimentes par -Wl,--wrap=malloc,calloc,realloc,free. */
+typedef struct {
+    size_t allocs;
+    size_t bytes;
+    size_t peak_live;
+} MemCounters;
+
+void memstat_reset(void);
+void memstat_read(MemCounters *out);
+size_t memstat_live(void);
+
+/* Pic de RSS (Ko) depuis le dernier memstat_reset_rss ; retombe sur le pic du processus
+ * si le noyau ne permet pas la remise a zero (/proc/self/clear_refs). */
+void memstat_reset_rss(void);
+long memstat_peak_rss_kb(void);
+
+#endif
@@ -0,0 +1,360 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "memstat.h"
+#include "ocr.h"
+#include "timing.h"
+
+typedef enum {
+    STAGE_LOAD = 0,
+    STAGE_BINARIZE,
+    STAGE_SPLIT,
+    STAGE_WORDS,
+    STAGE_RECOGNIZE,
+    STAGE_SOLVE,
+    STAGE_COUNT
+} Stage;
+
+static const char *stage_names[STAGE_COUNT] = {
+    "chargement", "binarisation", "decoupage", "mots", "reconnaissance", "resolution"
+};
+
+typedef struct {
+    int runs;
+    double ms;
+    size_t allocs;
+    size_t bytes;
+    size_t peak_live;
+    long peak_rss_kb;
+} StageStats;
+
+typedef struct {
+    const char *weights;
+    const char *words_file;
+    int repeat;
+    int quiet;
+    const char **images;
+    int nimages;
+} PipelineOptions;
+
+typedef struct {
+    char **items;
+    size_t count;
+} WordList;
+
+static double stage_begin(void)
+{
+    memstat_reset();
+    memstat_reset_rss();
+    return timing_now_ms();
+}
+
+static void stage_end(StageStats *s, double t0)
+{
+    double ms = timing_now_ms() - t0;
+    MemCounters c;
+    memstat_read(&c);
+    long rss = memstat_peak_rss_kb();
+    s->runs++;
+    s->ms += ms;
+    s->allocs += c.allocs;
+    s->bytes += c.bytes;
+    if (c.peak_live > s->peak_live) s->peak_live = c.peak_live;
+    if (rss > s->peak_rss_kb) s->peak_rss_kb = rss;
+}
+
+static void words_free(WordList *wl)
+{
+    for (size_t i = 0; i < wl->count; ++i) free(wl->items[i]);
+    free(wl->items);
+    wl->items = NULL;
+    wl->count = 0;
+}
+
+static int words_push(WordList *wl, size_t *cap, char *w)
+{
+    if (wl->count == *cap) {
+        size_t ncap = *cap ? *cap * 2 : 16;
+        char **tmp = realloc(wl->items, ncap * sizeof(char *));
+        if (!tmp) return -1;
+        wl->items = tmp;
+        *cap = ncap;
+    }
+    wl->items[wl->count++] = w;
+    return 0;
+}
+
+static int load_words_file(const char *path, WordList *wl)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    size_t cap = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        size_t k = 0;
+        for (size_t i = 0; line[i]; ++i)
+            if (!isspace((unsigned char)line[i])) line[k++] = line[i];
+        line[k] = '\0';
+        if (k == 0) continue;
+        char *w = malloc(k + 1);
+        if (!w || words_push(wl, &cap, w) != 0) {
+            free(w);
+            fclose(f);
+            words_free(wl);
+            return -1;
+        }
+        memcpy(w, line, k + 1);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void print_solution(const char *grid, int rows, int cols, const WordList *wl)
+{
+    char *mask = calloc((size_t)rows * (size_t)cols, 1);
+    for (size_t i = 0; i < wl->count; ++i) {
+        OcrCoord s, e;
+        if (ocr_search_word(grid, (unsigned)rows, (unsigned)cols, wl->items[i], &s, &e) != 0) {
+            printf("%s : non trouvé\n", wl->items[i]);
+            continue;
+        }
+        printf("%s : trouvé de (%u,%u) à (%u,%u)\n", wl->items[i], s.x, s.y, e.x, e.y);
+        if (!mask) continue;
+        int dx = (e.x > s.x) - (e.x < s.x);
+        int dy = (e.y > s.y) - (e.y < s.y);
+        int x = (int)s.x, y = (int)s.y;
+        for (size_t k = 0; k < strlen(wl->items[i]); ++k, x += dx, y += dy)
+            mask[(size_t)y * (size_t)cols + (size_t)x] = 1;
+    }
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            size_t i = (size_t)r * (size_t)cols + (size_t)c;
+            putchar(mask && mask[i] ? grid[i] : '.');
+            if (c + 1 < cols) putchar(' ');
+        }
+        putchar('\n');
+    }
+    free(mask);
+}
+
+static int run_image(const char *path, const OcrModel *model, const WordList *given,
+                     int quiet, StageStats st[STAGE_COUNT])
+{
+    int rc = -1;
+    OcrImage rgba = {0}, bw = {0};
+    RleImage runs = {0};
+    OcrTileSet tiles = {0};
+    OcrWordSet words = {0};
+    WordList wl = {0};
+    char *grid = NULL;
+    int rows = 0, cols = 0;
+
+    double t0 = stage_begin();
+    if (ocr_image_load(path, 4, &rgba) != 0) {
+        fprintf(stderr, "Echec : %s\n", path);
+        return -1;
+    }
+    stage_end(&st[STAGE_LOAD], t0);
+
+    OcrBinarizeOptions bopts;
+    ocr_binarize_default_options(&bopts);
+    t0 = stage_begin();
+    /* segments d'encre codes une fois, partages par le decoupage et les mots */
+    int brc = ocr_binarize_runs(&rgba, &bw, &runs, &bopts, NULL);
+    ocr_image_free(&rgba);
+    if (brc != 0) {
+        fprintf(stderr, "X mémoire\n");
+        goto done;
+    }
+    stage_end(&st[STAGE_BINARIZE], t0);
+
+    t0 = stage_begin();
+    if (ocr_split_grid_runs(&bw, &runs, &tiles, 0) != 0) {
+        fprintf(stderr, "Grille introuvable : %s\n", path);
+        goto done;
+    }
+    stage_end(&st[STAGE_SPLIT], t0);
+
+    if (!given) {
+        t0 = stage_begin();
+        if (ocr_extract_words_runs(&bw, &runs, &words) != 0) {
+            fprintf(stderr, "Extraction des mots impossible : %s\n", path);
+            goto done;
+        }
+        stage_end(&st[STAGE_WORDS], t0);
+    }
+    ocr_image_free(&bw);
+    rle_free(&runs);
+
+    t0 = stage_begin();
+    grid = ocr_recognize_grid(model, &tiles, &rows, &cols);
+    if (!grid) goto done;
+    size_t cap = 0;
+    for (size_t i = 0; i < words.count; ++i) {
+        char *w = ocr_recognize_word(model, &words.words[i]);
+        if (w && *w && words_push(&wl, &cap, w) == 0) continue;
+        free(w);
+    }
+    stage_end(&st[STAGE_RECOGNIZE], t0);
+
+    const WordList *list = given ? given : &wl;
+    OcrCoord s, e;
+    t0 = stage_begin();
+    for (size_t i = 0; i < list->count; ++i)
+        ocr_search_word(grid, (unsigned)rows, (unsigned)cols, list->items[i], &s, &e);
+    stage_end(&st[STAGE_SOLVE], t0);
+
+    if (!quiet) {
+        printf("== %s : grille %dx%d, %zu mots ==\n", path, rows, cols, list->count);
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                putchar(grid[(size_t)r * (size_t)cols + (size_t)c]);
+                if (c + 1 < cols) putchar(' ');
+            }
+            putchar('\n');
+        }
+        putchar('\n');
+        print_solution(grid, rows, cols, list);
+        putchar('\n');
+    }
+    rc = 0;
+
+done:
+    free(grid);
+    words_free(&wl);
+    ocr_words_free(&words);
+    ocr_tiles_free(&tiles);
+    ocr_image_free(&bw);
+    rle_free(&runs);
+    return rc;
+}
+
+static void print_report(const StageStats st[STAGE_COUNT], int images, double wall_ms, size_t model_allocs)
+{
+    fprintf(stderr, "%-15s %6s %10s %10s %10s %10s %10s\n",
+            "etape", "passes", "ms/img", "allocs", "Mo alloues", "pic tas Mo", "pic RSS Mo");
+    double total = 0.0;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const StageStats *s = &st[i];
+        if (s->runs == 0) continue;
+        total += s->ms / s->runs;
+        fprintf(stderr, "%-15s %6d %10.2f %10.0f %10.2f %10.2f %10.1f\n",
+                stage_names[i], s->runs, s->ms / s->runs,
+                (double)s->allocs / s->runs,
+                (double)s->bytes / s->runs / (1024.0 * 1024.0),
+                (double)s->peak_live / (1024.0 * 1024.0),
+                (double)s->peak_rss_kb / 1024.0);
+    }
+    fprintf(stderr, "%-15s %6s %10.2f   (modele : %zu allocations)\n", "total", "", total, model_allocs);
+    if (images > 0 && wall_ms > 0.0)
+        fprintf(stderr, "%d images en %.2f s : %.2f images/s\n",
+                images, wall_ms * 1e-3, images / (wall_ms * 1e-3));
+}
+
+/* weights.bin (nn/Makefile) s'il n'est pas plus ancien que weights.txt a cote */
+static const char *default_weights(void)
+{
+    static const char *dirs[] = {"nn/", "../nn/", ""};
+    static char path[64];
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i) {
+        char txt[64], bin[64];
+        struct stat st_txt, st_bin;
+        snprintf(txt, sizeof(txt), "%sweights.txt", dirs[i]);
+        snprintf(bin, sizeof(bin), "%sweights.bin", dirs[i]);
+        int has_txt = stat(txt, &st_txt) == 0, has_bin = stat(bin, &st_bin) == 0;
+        if (!has_txt && !has_bin) continue;
+        snprintf(path, sizeof(path), "%s",
+                 has_bin && (!has_txt || st_bin.st_mtime >= st_txt.st_mtime) ? bin : txt);
+        return path;
+    }
+    return "nn/weights.txt";
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [--weights poids.txt] [--words mots.txt] [--repeat N] [--quiet] image...\n",
+            prog);
+}
+
+static int parse_args(int argc, char **argv, PipelineOptions *o)
+{
+    memset(o, 0, sizeof(*o));
+    o->repeat = 1;
+    o->images = calloc((size_t)argc, sizeof(char *));
+    if (!o->images) return -1;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (strcmp(a, "--weights") == 0 && i + 1 < argc) {
+            o->weights = argv[++i];
+        } else if (strcmp(a, "--words") == 0 && i + 1 < argc) {
+            o->words_file = argv[++i];
+        } else if (strcmp(a, "--repeat") == 0 && i + 1 < argc) {
+            o->repeat = atoi(argv[++i]);
+            if (o->repeat < 1) o->repeat = 1;
+        } else if (strcmp(a, "--quiet") == 0 || strcmp(a, "-q") == 0) {
+            o->quiet = 1;
+        } else if (a[0] == '-' && a[1] == '-') {
+            fprintf(stderr, "Argument inconnu: %s\n", a);
+            return -1;
+        } else {
+            o->images[o->nimages++] = a;
+        }
+    }
+    if (!o->weights) o->weights = default_weights();
+    return o->nimages > 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    PipelineOptions opts;
+    if (parse_args(argc, argv, &opts) != 0) {
+        usage(argv[0]);
+        free(opts.images);
+        return 1;
+    }
+
+    memstat_reset();
+    OcrModel model;
+    if (ocr_model_load(opts.weights, &model) != 0) {
+        free(opts.images);
+        return 2;
+    }
+    MemCounters mc;
+    memstat_read(&mc);
+
+    WordList given = {0};
+    if (opts.words_file && load_words_file(opts.words_file, &given) != 0) {
+        ocr_model_free(&model);
+        free(opts.images);
+        return 2;
+    }
+
+    StageStats st[STAGE_COUNT];
+    memset(st, 0, sizeof(st));
+    int done = 0, failed = 0;
+    double t0 = timing_now_ms();
+    for (int r = 0; r < opts.repeat; ++r) {
+        for (int i = 0; i < opts.nimages; ++i) {
+            int quiet = opts.quiet || r > 0;
+            if (run_image(opts.images[i], &model, opts.words_file ? &given : NULL, quiet, st) == 0)
+                done++;
+            else
+                failed++;
+        }
+    }
+    double wall = timing_now_ms() - t0;
+
+    print_report(st, done, wall, mc.allocs);
+
+    words_free(&given);
+    ocr_model_free(&model);
+    free(opts.images);
+    return failed ? 3 : 0;
+}
@@ -2,7 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include "solver.h"
+#include "ocr.h"
 
 
 static char* load_grid(const char* path, unsigned int* rows, unsigned int* cols) {
@@ -106,8 +106,8 @@ int main(void) {
         {
             continue;
         }
-        Coord s, e;
-        int rc = search_word(grid, rows, cols, word, &s, &e);
+        OcrCoord s, e;
+        int rc = ocr_search_word(grid, rows, cols, word, &s, &e);
         if (rc == 0)
        {
             printf("%s : trouvé de (%u,%u) à (%u,%u)\n", word, s.x, s.y, e.x, e.y);